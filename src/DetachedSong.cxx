@@ -39,7 +39,7 @@ DetachedSong::~DetachedSong()
 bool
 DetachedSong::IsRemote() const
 {
-	return uri_has_scheme(GetRealURI());
+	return remote_storage || uri_has_scheme(GetRealURI());
 }
 
 bool
@@ -51,8 +51,9 @@ DetachedSong::IsAbsoluteFile() const
 bool
 DetachedSong::IsInDatabase() const
 {
-	/* here, we use GetURI() and not GetRealURI() because
-	   GetRealURI() is never relative */
+	/* here, we use GetURI() and not GetRealURI() because a
+	   song from another database (e.g. UPnP) may have an
+	   absolute "real" URI */
 
 	const char *_uri = GetURI();
 	return !uri_has_scheme(_uri) && !PathTraitsUTF8::IsAbsolute(_uri);
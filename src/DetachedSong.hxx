@@ -56,8 +56,10 @@ class DetachedSong {
 	 * resource.  If this attribute is empty, then #uri shall be
 	 * used.
 	 *
-	 * This attribute is used for songs from the database which
-	 * have a relative URI.
+	 * This attribute is used for songs from a database which
+	 * cannot be mapped with the music directory's storage (e.g.
+	 * UPnP).  Songs from the local database leave it empty, see
+	 * map_song_real_uri() and #remote_storage.
 	 */
 	std::string real_uri;
 
@@ -76,6 +78,21 @@ class DetachedSong {
 	 */
 	SongTime end_time;
 
+	/**
+	 * Does #tag contain only the tag types which the database
+	 * keeps in memory (see LightSong::partial_tag)?  The rest is
+	 * loaded by CompleteTag() when the song is played.
+	 */
+	bool partial_tag = false;
+
+	/**
+	 * Does the music directory's storage map #uri to a remote
+	 * resource (e.g. NFS or SMB)?  This is decided by
+	 * DatabaseDetachSong(), because the mapped URI is not stored
+	 * in #real_uri.
+	 */
+	bool remote_storage = false;
+
 	explicit DetachedSong(const LightSong &other);
 
 public:
@@ -154,6 +171,18 @@ public:
 		return uri == other_uri;
 	}
 
+	/**
+	 * Does the music directory's storage map this song to a
+	 * remote resource?  See #remote_storage.
+	 */
+	bool HasRemoteStorage() const {
+		return remote_storage;
+	}
+
+	void SetRemoteStorage() {
+		remote_storage = true;
+	}
+
 	gcc_pure
 	bool IsRemote() const;
 
@@ -176,6 +205,14 @@ public:
 		return tag;
 	}
 
+	bool HasPartialTag() const {
+		return partial_tag;
+	}
+
+	void SetPartialTag() {
+		partial_tag = true;
+	}
+
 	void SetTag(const Tag &_tag) {
 		tag = Tag(_tag);
 	}
@@ -234,6 +271,19 @@ public:
 	 * Load #tag and #mtime from a local file.
 	 */
 	bool LoadFile(Path path);
+
+	/**
+	 * If the #tag is partial (see HasPartialTag()), complement it
+	 * with the tag loaded from the file.  This works only for plain
+	 * local files, not for "sub" songs in containers or
+	 * archives; if it fails, the partial tag is kept.
+	 *
+	 * This may block for disk I/O, which is why it is only done
+	 * by the decoder thread, on its own copy of the song; the
+	 * queue keeps the partial tag.  The "real" URI must have been
+	 * mapped already (see playlist::DupForPlayer()).
+	 */
+	void CompleteTag();
 };
 
 #endif
@@ -87,7 +87,7 @@ struct Instance final
 
 	Partition *partition;
 
-	StateFile *state_file;
+	StateFile *state_file = nullptr;
 
 	Instance()
 		:idle_monitor(event_loop, BIND_THIS_METHOD(OnIdle)) {}
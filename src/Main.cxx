@@ -58,6 +58,7 @@
 #include "config/ConfigOption.hxx"
 #include "config/ConfigError.hxx"
 #include "Stats.hxx"
+#include "PipelineStats.hxx"
 
 #ifdef ENABLE_DAEMON
 #include "unix/Daemon.hxx"
@@ -117,9 +118,11 @@
 #endif
 
 #include <limits.h>
+#include <string.h>
 
 static constexpr unsigned DEFAULT_BUFFER_SIZE = 4096;
 static constexpr unsigned DEFAULT_BUFFER_BEFORE_PLAY = 10;
+static constexpr size_t MAX_CHUNK_SIZE = 1024 * 1024;
 
 #ifdef ANDROID
 Context *context;
@@ -280,7 +283,21 @@ glue_state_file_init(Error &error)
 		config_get_unsigned(ConfigOption::STATE_FILE_INTERVAL,
 				    StateFile::DEFAULT_INTERVAL);
 
+	const char *format =
+		config_get_string(ConfigOption::STATE_FILE_FORMAT, "text");
+	bool binary_queue;
+	if (strcmp(format, "binary") == 0)
+		binary_queue = true;
+	else if (strcmp(format, "text") == 0)
+		binary_queue = false;
+	else {
+		error.Format(config_domain,
+			     "Unrecognized state file format: %s", format);
+		return false;
+	}
+
 	instance->state_file = new StateFile(std::move(path_fs), interval,
+					     binary_queue,
 					     *instance->partition,
 					     instance->event_loop);
 	instance->state_file->Read();
@@ -329,15 +346,33 @@ initialize_decoder_and_player(void)
 
 	buffer_size *= 1024;
 
-	const unsigned buffered_chunks = buffer_size / CHUNK_SIZE;
+	const size_t chunk_size =
+		config_get_positive(ConfigOption::AUDIO_CHUNK_SIZE,
+				    CHUNK_SIZE / 1024) * 1024;
+	if (chunk_size > MAX_CHUNK_SIZE)
+		FormatFatalError("chunk size \"%lu\" is too big",
+				 (unsigned long)chunk_size);
+
+	const unsigned buffered_chunks = buffer_size / chunk_size;
 
 	if (buffered_chunks >= 1 << 15)
 		FormatFatalError("buffer size \"%lu\" is too big",
 				 (unsigned long)buffer_size);
 
+	if (buffered_chunks == 0)
+		FormatFatalError("buffer size \"%lu\" is smaller than "
+				 "the chunk size",
+				 (unsigned long)buffer_size);
+
 	float perc;
+	bool adaptive_buffering = false;
 	param = config_get_param(ConfigOption::BUFFER_BEFORE_PLAY);
-	if (param != nullptr) {
+	if (param != nullptr && param->value == "auto") {
+		/* the default is the upper limit; the player thread
+		   decides for each song how much of it is needed */
+		perc = DEFAULT_BUFFER_BEFORE_PLAY;
+		adaptive_buffering = true;
+	} else if (param != nullptr) {
 		char *test;
 		perc = strtod(param->value.c_str(), &test);
 		if (*test != '%' || perc < 0 || perc > 100) {
@@ -357,10 +392,16 @@ initialize_decoder_and_player(void)
 		config_get_positive(ConfigOption::MAX_PLAYLIST_LENGTH,
 				    DEFAULT_PLAYLIST_MAX_LENGTH);
 
+	const bool lock_free_pipe =
+		config_get_bool(ConfigOption::LOCK_FREE_PIPE, false);
+
 	instance->partition = new Partition(*instance,
 					    max_length,
 					    buffered_chunks,
-					    buffered_before_play);
+					    chunk_size,
+					    buffered_before_play,
+					    adaptive_buffering,
+					    lock_free_pipe);
 }
 
 void
@@ -450,6 +491,7 @@ int mpd_main(int argc, char *argv[])
 #endif
 
 	stats_global_init();
+	pipeline_stats_global_init();
 	TagLoadConfig();
 
 	if (!log_init(options.verbose, options.log_stderr, error)) {
@@ -474,7 +516,7 @@ int mpd_main(int argc, char *argv[])
 
 	const unsigned max_clients =
 		config_get_positive(ConfigOption::MAX_CONN, 10);
-	instance->client_list = new ClientList(max_clients);
+	instance->client_list = new ClientList(instance->event_loop, max_clients);
 
 	initialize_decoder_and_player();
 
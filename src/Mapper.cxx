@@ -23,6 +23,7 @@
 
 #include "config.h"
 #include "Mapper.hxx"
+#include "DetachedSong.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "fs/CheckFile.hxx"
 #include "util/StringCompare.hxx"
@@ -108,6 +109,21 @@ map_fs_to_utf8(Path path_fs)
 
 #endif
 
+std::string
+map_song_real_uri(const DetachedSong &song)
+{
+#ifdef ENABLE_DATABASE
+	if (!song.HasRealURI() && song.IsInDatabase()) {
+		if (instance->storage == nullptr)
+			return std::string();
+
+		return instance->storage->MapUTF8(song.GetURI());
+	}
+#endif
+
+	return song.GetRealURI();
+}
+
 const AllocatedPath &
 map_spl_path()
 {
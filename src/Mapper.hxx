@@ -32,6 +32,7 @@
 
 class Path;
 class AllocatedPath;
+class DetachedSong;
 
 void
 mapper_init(AllocatedPath &&playlist_dir);
@@ -64,6 +65,21 @@ map_fs_to_utf8(Path path_fs);
 
 #endif
 
+/**
+ * Determines the URI which shall be used to open the song: an
+ * absolute file name or a URL.  Songs from the database don't store
+ * it (see DatabaseDetachSong()); it is obtained from the music
+ * directory's storage.  This accesses the global #Instance, so it
+ * may only be called from the main thread; the player and the
+ * decoder get the mapped URI with their copy of the song (see
+ * playlist::DupForPlayer()).
+ *
+ * @return the URI in UTF-8, or an empty string if mapping failed
+ */
+gcc_pure
+std::string
+map_song_real_uri(const DetachedSong &song);
+
 /**
  * Returns the playlist directory.
  */
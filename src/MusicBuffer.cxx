@@ -23,15 +23,60 @@
 
 #include <assert.h>
 
-MusicBuffer::MusicBuffer(unsigned num_chunks)
-	:buffer(num_chunks) {
+MusicBuffer::MusicBuffer(unsigned num_chunks, size_t _chunk_size,
+			 bool lock_free)
+	:buffer(lock_free ? nullptr : new SliceBuffer<MusicChunk>(num_chunks)),
+	 lock_free_buffer(lock_free
+			  ? new LockFreeSliceBuffer<MusicChunk>(num_chunks)
+			  : nullptr),
+	 chunk_size(_chunk_size),
+	 payload((uint8_t *)HugeAllocate(num_chunks * chunk_size)),
+	 contention(0) {
+	assert(chunk_size > 0);
+}
+
+MusicBuffer::~MusicBuffer()
+{
+	HugeFree(payload, GetSize() * chunk_size);
+
+	delete buffer;
+	delete lock_free_buffer;
+}
+
+inline void
+MusicBuffer::LockMutex()
+{
+	if (!mutex.try_lock()) {
+		contention.fetch_add(1, std::memory_order_relaxed);
+		mutex.lock();
+	}
+}
+
+inline MusicChunk *
+MusicBuffer::AssignPayload(MusicChunk *chunk, unsigned i) const
+{
+	chunk->data = payload + i * chunk_size;
+	chunk->capacity = chunk_size;
+	return chunk;
 }
 
 MusicChunk *
 MusicBuffer::Allocate()
 {
-	const ScopeLock protect(mutex);
-	return buffer.Allocate();
+	if (lock_free_buffer != nullptr) {
+		MusicChunk *chunk = lock_free_buffer->Allocate();
+		return chunk != nullptr
+			? AssignPayload(chunk,
+					lock_free_buffer->IndexOf(chunk))
+			: nullptr;
+	}
+
+	LockMutex();
+	MusicChunk *chunk = buffer->Allocate();
+	if (chunk != nullptr)
+		AssignPayload(chunk, buffer->IndexOf(chunk));
+	mutex.unlock();
+	return chunk;
 }
 
 void
@@ -39,12 +84,30 @@ MusicBuffer::Return(MusicChunk *chunk)
 {
 	assert(chunk != nullptr);
 
-	const ScopeLock protect(mutex);
+	if (lock_free_buffer != nullptr) {
+		if (chunk->other != nullptr) {
+			assert(chunk->other->other == nullptr);
+			lock_free_buffer->Free(chunk->other);
+		}
+
+		lock_free_buffer->Free(chunk);
+		return;
+	}
+
+	LockMutex();
 
 	if (chunk->other != nullptr) {
 		assert(chunk->other->other == nullptr);
-		buffer.Free(chunk->other);
+		buffer->Free(chunk->other);
 	}
 
-	buffer.Free(chunk);
+	buffer->Free(chunk);
+
+	/* give the PCM memory back to the kernel when the last chunk
+	   was freed, just like SliceBuffer does with the chunk
+	   headers */
+	if (buffer->IsEmpty())
+		HugeDiscard(payload, GetSize() * chunk_size);
+
+	mutex.unlock();
 }
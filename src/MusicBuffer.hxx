@@ -21,8 +21,14 @@
 #define MPD_MUSIC_BUFFER_HXX
 
 #include "util/SliceBuffer.hxx"
+#include "util/LockFreeSliceBuffer.hxx"
 #include "thread/Mutex.hxx"
 
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
 struct MusicChunk;
 
 /**
@@ -32,7 +38,46 @@ class MusicBuffer {
 	/** a mutex which protects #buffer */
 	Mutex mutex;
 
-	SliceBuffer<MusicChunk> buffer;
+	/**
+	 * The mutex-protected allocator.  It is nullptr if this
+	 * object was created in lock-free mode.
+	 */
+	SliceBuffer<MusicChunk> *const buffer;
+
+	/**
+	 * The lock-free allocator.  It is nullptr unless this object
+	 * was created in lock-free mode.
+	 */
+	LockFreeSliceBuffer<MusicChunk> *const lock_free_buffer;
+
+	/**
+	 * The size of MusicChunk::data in bytes.
+	 */
+	const size_t chunk_size;
+
+	/**
+	 * The memory for MusicChunk::data of all chunks; each chunk
+	 * owns #chunk_size bytes at the position matching its index
+	 * in the allocator.
+	 */
+	uint8_t *const payload;
+
+	/**
+	 * The number of times a thread had to wait for #mutex.
+	 */
+	std::atomic_ulong contention;
+
+	/**
+	 * Lock #mutex and increment #contention if it was not
+	 * available immediately.
+	 */
+	void LockMutex();
+
+	/**
+	 * Point MusicChunk::data to the payload slot with the given
+	 * index.
+	 */
+	MusicChunk *AssignPayload(MusicChunk *chunk, unsigned i) const;
 
 public:
 	/**
@@ -40,8 +85,16 @@ public:
 	 *
 	 * @param num_chunks the number of #MusicChunk reserved in
 	 * this buffer
+	 * @param chunk_size the size of MusicChunk::data in bytes
+	 * @param lock_free use a lock-free allocator instead of a
+	 * mutex-protected one
 	 */
-	MusicBuffer(unsigned num_chunks);
+	MusicBuffer(unsigned num_chunks, size_t chunk_size, bool lock_free);
+
+	~MusicBuffer();
+
+	MusicBuffer(const MusicBuffer &) = delete;
+	MusicBuffer &operator=(const MusicBuffer &) = delete;
 
 #ifndef NDEBUG
 	/**
@@ -50,10 +103,23 @@ public:
 	 * object is inaccessible to other threads.
 	 */
 	bool IsEmptyUnsafe() const {
-		return buffer.IsEmpty();
+		return lock_free_buffer != nullptr
+			? lock_free_buffer->IsEmpty()
+			: buffer->IsEmpty();
 	}
 #endif
 
+	bool IsLockFree() const {
+		return lock_free_buffer != nullptr;
+	}
+
+	/**
+	 * Returns the size of MusicChunk::data in bytes.
+	 */
+	size_t GetChunkSize() const {
+		return chunk_size;
+	}
+
 	/**
 	 * Returns the total number of reserved chunks in this buffer.  This
 	 * is the same value which was passed to the constructor
@@ -61,7 +127,21 @@ public:
 	 */
 	gcc_pure
 	unsigned GetSize() const {
-		return buffer.GetCapacity();
+		return lock_free_buffer != nullptr
+			? lock_free_buffer->GetCapacity()
+			: buffer->GetCapacity();
+	}
+
+	/**
+	 * Returns how often Allocate() or Return() was delayed by
+	 * another thread: the number of times the mutex was already
+	 * locked, or (in lock-free mode) the number of retries.
+	 */
+	gcc_pure
+	unsigned long GetContention() const {
+		return lock_free_buffer != nullptr
+			? lock_free_buffer->GetRetries()
+			: contention.load(std::memory_order_relaxed);
 	}
 
 	/**
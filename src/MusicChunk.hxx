@@ -31,6 +31,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ * The default size of MusicChunk::data in bytes.  It can be changed
+ * with the "audio_chunk_size" setting.
+ */
 static constexpr size_t CHUNK_SIZE = 4096;
 
 struct AudioFormat;
@@ -57,7 +61,7 @@ struct MusicChunk {
 	float mix_ratio;
 
 	/** number of bytes stored in this chunk */
-	uint16_t length;
+	uint32_t length;
 
 	/** current bit rate of the source file */
 	uint16_t bit_rate;
@@ -86,8 +90,22 @@ struct MusicChunk {
 	 */
 	unsigned replay_gain_serial;
 
-	/** the data (probably PCM) */
-	uint8_t data[CHUNK_SIZE];
+	/**
+	 * The data (probably PCM).  This buffer is owned by the
+	 * #MusicBuffer and is assigned by MusicBuffer::Allocate().
+	 */
+	uint8_t *data;
+
+	/** the size of #data in bytes */
+	size_t capacity;
+
+	/**
+	 * Time stamps for the pipeline statistics (see
+	 * pipeline_stats_now()): when the decoder has finished this
+	 * chunk, and when the player thread has passed it to the
+	 * audio outputs.  0 means unknown.
+	 */
+	uint64_t decoded_time, queued_time;
 
 #ifndef NDEBUG
 	AudioFormat audio_format;
@@ -97,7 +115,9 @@ struct MusicChunk {
 		:other(nullptr),
 		 length(0),
 		 tag(nullptr),
-		 replay_gain_serial(0) {}
+		 replay_gain_serial(0),
+		 data(nullptr), capacity(0),
+		 decoded_time(0), queued_time(0) {}
 
 	~MusicChunk();
 
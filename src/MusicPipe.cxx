@@ -22,26 +22,101 @@
 #include "MusicBuffer.hxx"
 #include "MusicChunk.hxx"
 
+std::atomic_ulong MusicPipe::contention(0);
+
+/**
+ * Round up to the next power of two.
+ */
+static constexpr unsigned
+CeilPowerOfTwo(unsigned n, unsigned result=1)
+{
+	return result >= n ? result : CeilPowerOfTwo(n, result * 2);
+}
+
+MusicPipe::MusicPipe(unsigned capacity)
+	:head(nullptr), tail_r(&head), size(0),
+	 ring_mask(CeilPowerOfTwo(capacity) - 1),
+	 ring(new MusicChunk *[ring_mask + 1]),
+	 ring_head(0), ring_tail(0)
+{
+	assert(capacity > 0);
+
+#ifndef NDEBUG
+	audio_format.Clear();
+#endif
+}
+
+MusicPipe::~MusicPipe()
+{
+	assert(head == nullptr);
+	assert(tail_r == &head);
+	assert(IsEmpty());
+
+	delete[] ring;
+}
+
+inline void
+MusicPipe::LockMutex() const
+{
+	if (!mutex.try_lock()) {
+		contention.fetch_add(1, std::memory_order_relaxed);
+		mutex.lock();
+	}
+}
+
 #ifndef NDEBUG
 
 bool
 MusicPipe::Contains(const MusicChunk *chunk) const
 {
-	const ScopeLock protect(mutex);
+	if (ring != nullptr) {
+		const unsigned t = ring_tail.load(std::memory_order_acquire);
+		for (unsigned i = ring_head.load(std::memory_order_acquire);
+		     i != t; ++i)
+			if (ring[i & ring_mask] == chunk)
+				return true;
+
+		return false;
+	}
 
-	for (const MusicChunk *i = head; i != nullptr; i = i->next)
-		if (i == chunk)
-			return true;
+	LockMutex();
 
-	return false;
+	bool found = false;
+	for (const MusicChunk *i = head; i != nullptr; i = i->next) {
+		if (i == chunk) {
+			found = true;
+			break;
+		}
+	}
+
+	mutex.unlock();
+	return found;
 }
 
 #endif
 
+inline MusicChunk *
+MusicPipe::ShiftRing()
+{
+	const unsigned h = ring_head.load(std::memory_order_relaxed);
+	if (h == ring_tail.load(std::memory_order_acquire))
+		return nullptr;
+
+	MusicChunk *chunk = ring[h & ring_mask];
+	assert(!chunk->IsEmpty());
+
+	/* release the slot to the producer */
+	ring_head.store(h + 1, std::memory_order_release);
+	return chunk;
+}
+
 MusicChunk *
 MusicPipe::Shift()
 {
-	const ScopeLock protect(mutex);
+	if (ring != nullptr)
+		return ShiftRing();
+
+	LockMutex();
 
 	MusicChunk *chunk = head;
 	if (chunk != nullptr) {
@@ -69,6 +144,7 @@ MusicPipe::Shift()
 #endif
 	}
 
+	mutex.unlock();
 	return chunk;
 }
 
@@ -81,13 +157,33 @@ MusicPipe::Clear(MusicBuffer &buffer)
 		buffer.Return(chunk);
 }
 
+inline void
+MusicPipe::PushRing(MusicChunk *chunk)
+{
+	const unsigned t = ring_tail.load(std::memory_order_relaxed);
+
+	/* the ring is as large as the MusicBuffer, therefore it can
+	   never overflow */
+	assert(t - ring_head.load(std::memory_order_acquire) <= ring_mask);
+
+	ring[t & ring_mask] = chunk;
+
+	/* publish the chunk to the consumer */
+	ring_tail.store(t + 1, std::memory_order_release);
+}
+
 void
 MusicPipe::Push(MusicChunk *chunk)
 {
 	assert(!chunk->IsEmpty());
 	assert(chunk->length == 0 || chunk->audio_format.IsValid());
 
-	const ScopeLock protect(mutex);
+	if (ring != nullptr) {
+		PushRing(chunk);
+		return;
+	}
+
+	LockMutex();
 
 	assert(size > 0 || !audio_format.IsDefined());
 	assert(!audio_format.IsDefined() ||
@@ -103,4 +199,6 @@ MusicPipe::Push(MusicChunk *chunk)
 	tail_r = &chunk->next;
 
 	++size;
+
+	mutex.unlock();
 }
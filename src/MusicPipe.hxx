@@ -27,6 +27,8 @@
 #include "AudioFormat.hxx"
 #endif
 
+#include <atomic>
+
 #include <assert.h>
 
 struct MusicChunk;
@@ -35,6 +37,13 @@ class MusicBuffer;
 /**
  * A queue of #MusicChunk objects.  One party appends chunks at the
  * tail, and the other consumes them from the head.
+ *
+ * By default, the queue is a linked list protected by a mutex, and
+ * consumers may walk the list via MusicChunk::next.  A pipe
+ * constructed with a capacity is a lock-free single-producer /
+ * single-consumer ring instead; only Push() may be called by the
+ * producer, and only Peek()/Shift()/Clear() by the consumer (see
+ * Clear() for an exception).  It does not maintain MusicChunk::next.
  */
 class MusicPipe {
 	/** the first chunk */
@@ -49,6 +58,36 @@ class MusicPipe {
 	/** a mutex which protects #head and #tail_r */
 	mutable Mutex mutex;
 
+	/**
+	 * The number of ring slots minus one in lock-free mode (the
+	 * number of slots is a power of two), or 0 if this pipe uses
+	 * #mutex.
+	 */
+	const unsigned ring_mask;
+
+	/**
+	 * The ring buffer in lock-free mode.
+	 */
+	MusicChunk **const ring;
+
+	/**
+	 * The number of chunks ever shifted from the ring.  Written
+	 * only by the consumer.
+	 */
+	std::atomic_uint ring_head;
+
+	/**
+	 * The number of chunks ever pushed to the ring.  Written only
+	 * by the producer.
+	 */
+	std::atomic_uint ring_tail;
+
+	/**
+	 * The number of times a thread had to wait for #mutex,
+	 * accumulated over all #MusicPipe instances.
+	 */
+	static std::atomic_ulong contention;
+
 #ifndef NDEBUG
 	AudioFormat audio_format;
 #endif
@@ -58,18 +97,41 @@ public:
 	 * Creates a new #MusicPipe object.  It is empty.
 	 */
 	MusicPipe()
-		:head(nullptr), tail_r(&head), size(0) {
+		:head(nullptr), tail_r(&head), size(0),
+		 ring_mask(0), ring(nullptr),
+		 ring_head(0), ring_tail(0) {
 #ifndef NDEBUG
 		audio_format.Clear();
 #endif
 	}
 
+	/**
+	 * Creates a new lock-free #MusicPipe object.  It is empty.
+	 *
+	 * @param capacity the maximum number of chunks in this pipe;
+	 * usually the size of the #MusicBuffer
+	 */
+	explicit MusicPipe(unsigned capacity);
+
 	/**
 	 * Frees the object.  It must be empty now.
 	 */
-	~MusicPipe() {
-		assert(head == nullptr);
-		assert(tail_r == &head);
+	~MusicPipe();
+
+	MusicPipe(const MusicPipe &) = delete;
+	MusicPipe &operator=(const MusicPipe &) = delete;
+
+	bool IsLockFree() const {
+		return ring != nullptr;
+	}
+
+	/**
+	 * Returns the number of times any (mutex-protected)
+	 * #MusicPipe was already locked by another thread.
+	 */
+	gcc_pure
+	static unsigned long GetContention() {
+		return contention.load(std::memory_order_relaxed);
 	}
 
 #ifndef NDEBUG
@@ -96,6 +158,14 @@ public:
 	 */
 	gcc_pure
 	const MusicChunk *Peek() const {
+		if (ring != nullptr) {
+			const unsigned h =
+				ring_head.load(std::memory_order_relaxed);
+			return h != ring_tail.load(std::memory_order_acquire)
+				? ring[h & ring_mask]
+				: nullptr;
+		}
+
 		return head;
 	}
 
@@ -107,6 +177,12 @@ public:
 	/**
 	 * Clears the whole pipe and returns the chunks to the buffer.
 	 *
+	 * In lock-free mode, this acts as a consumer.  The decoder
+	 * thread (the producer) calls it while seeking; that is only
+	 * safe because the player thread (the consumer) is blocked in
+	 * the synchronous decoder command meanwhile and does not
+	 * touch the pipe.
+	 *
 	 * @param buffer the buffer object to return the chunks to
 	 */
 	void Clear(MusicBuffer &buffer);
@@ -121,6 +197,10 @@ public:
 	 */
 	gcc_pure
 	unsigned GetSize() const {
+		if (ring != nullptr)
+			return ring_tail.load(std::memory_order_acquire) -
+				ring_head.load(std::memory_order_acquire);
+
 		return size;
 	}
 
@@ -128,6 +208,16 @@ public:
 	bool IsEmpty() const {
 		return GetSize() == 0;
 	}
+
+private:
+	/**
+	 * Lock #mutex and increment #contention if it was not
+	 * available immediately.
+	 */
+	void LockMutex() const;
+
+	MusicChunk *ShiftRing();
+	void PushRing(MusicChunk *chunk);
 };
 
 #endif
@@ -27,12 +27,16 @@
 Partition::Partition(Instance &_instance,
 		     unsigned max_length,
 		     unsigned buffer_chunks,
-		     unsigned buffered_before_play)
+		     size_t chunk_size,
+		     unsigned buffered_before_play,
+		     bool adaptive_buffering,
+		     bool lock_free_pipe)
 	:instance(_instance),
 	 global_events(instance.event_loop, BIND_THIS_METHOD(OnGlobalEvent)),
 	 playlist(max_length, *this),
 	 outputs(*this),
-	 pc(*this, outputs, buffer_chunks, buffered_before_play)
+	 pc(*this, outputs, buffer_chunks, chunk_size,
+	    buffered_before_play, adaptive_buffering, lock_free_pipe)
 {
 }
 
@@ -55,7 +55,10 @@ struct Partition final : QueueListener, PlayerListener, MixerListener {
 	Partition(Instance &_instance,
 		  unsigned max_length,
 		  unsigned buffer_chunks,
-		  unsigned buffered_before_play);
+		  size_t chunk_size,
+		  unsigned buffered_before_play,
+		  bool adaptive_buffering,
+		  bool lock_free_pipe);
 
 	void EmitGlobalEvent(unsigned mask) {
 		global_events.OrMask(mask);
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "PipelineStats.hxx"
+#include "Partition.hxx"
+#include "output/MultipleOutputs.hxx"
+#include "output/Internal.hxx"
+#include "client/Response.hxx"
+#include "config/ConfigGlobal.hxx"
+#include "config/ConfigOption.hxx"
+
+bool pipeline_stats_enabled;
+
+PipelinePlayerStats pipeline_player_stats;
+
+uint64_t
+PipelineHistogram::GetPercentile(unsigned percent) const
+{
+	const uint64_t n = count.load(std::memory_order_relaxed);
+	const uint64_t threshold = (n * percent + 99) / 100;
+	const uint64_t max = maximum.load(std::memory_order_relaxed);
+
+	uint64_t cumulated = 0;
+	for (unsigned i = 0; i < N_BUCKETS; ++i) {
+		cumulated += buckets[i].load(std::memory_order_relaxed);
+		if (cumulated >= threshold) {
+			const uint64_t upper = i > 0
+				? (uint64_t(1) << i) - 1
+				: 0;
+			return upper < max ? upper : max;
+		}
+	}
+
+	return max;
+}
+
+void
+PipelineHistogram::Print(Response &r, const char *stage, int output) const
+{
+	r.Format("stage: %s\n", stage);
+	if (output >= 0)
+		r.Format("outputid: %i\n", output);
+
+	if (reset_requested.load(std::memory_order_acquire)) {
+		/* the writing thread has not cleared it yet */
+		r.Write("count: 0\n"
+			"avg: 0\n"
+			"max: 0\n"
+			"p50: 0\n"
+			"p99: 0\n"
+			"histogram: 0\n");
+		return;
+	}
+
+	const uint64_t n = count.load(std::memory_order_relaxed);
+	r.Format("count: %llu\n"
+		 "avg: %llu\n"
+		 "max: %llu\n"
+		 "p50: %llu\n"
+		 "p99: %llu\n",
+		 (unsigned long long)n,
+		 n > 0
+		 ? (unsigned long long)(sum.load(std::memory_order_relaxed) / n)
+		 : 0ULL,
+		 (unsigned long long)maximum.load(std::memory_order_relaxed),
+		 (unsigned long long)GetPercentile(50),
+		 (unsigned long long)GetPercentile(99));
+
+	/* omit the empty buckets at the end */
+	unsigned end = N_BUCKETS;
+	while (end > 1 && buckets[end - 1].load(std::memory_order_relaxed) == 0)
+		--end;
+
+	r.Format("histogram: %llu",
+		 (unsigned long long)buckets[0].load(std::memory_order_relaxed));
+	for (unsigned i = 1; i < end; ++i)
+		r.Format(" %llu",
+			 (unsigned long long)buckets[i].load(std::memory_order_relaxed));
+	r.Write("\n");
+}
+
+void
+pipeline_stats_global_init()
+{
+	pipeline_stats_enabled =
+		config_get_bool(ConfigOption::PIPELINE_STATS, false);
+}
+
+void
+pipeline_stats_print(Response &r, const Partition &partition)
+{
+	pipeline_player_stats.decoder_latency.Print(r, "decoder_latency");
+	pipeline_player_stats.decoder_depth.Print(r, "decoder_depth");
+	pipeline_player_stats.output_depth.Print(r, "output_depth");
+
+	const MultipleOutputs &outputs = partition.outputs;
+	for (unsigned i = 0, n = outputs.Size(); i != n; ++i) {
+		const auto &stats = outputs.Get(i).pipeline_stats;
+		stats.pickup.Print(r, "output_pickup", i);
+		stats.filter.Print(r, "output_filter", i);
+		stats.play.Print(r, "output_play", i);
+		stats.total.Print(r, "output_total", i);
+	}
+}
+
+void
+pipeline_stats_reset(Partition &partition)
+{
+	pipeline_player_stats.Reset();
+
+	MultipleOutputs &outputs = partition.outputs;
+	for (unsigned i = 0, n = outputs.Size(); i != n; ++i)
+		outputs.Get(i).pipeline_stats.Reset();
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/** \file
+ *
+ * Optional instrumentation of the playback pipeline: time stamps are
+ * attached to each #MusicChunk, and the latencies between the
+ * decoder, the player thread and the audio outputs are collected in
+ * histograms.  The "pipelinestats" command prints them.
+ */
+
+#ifndef MPD_PIPELINE_STATS_HXX
+#define MPD_PIPELINE_STATS_HXX
+
+#include "system/Clock.hxx"
+#include "Compiler.h"
+
+#include <atomic>
+
+#include <stdint.h>
+
+class Response;
+struct Partition;
+
+/**
+ * Is the instrumentation enabled?  This is initialized by
+ * pipeline_stats_global_init() before the player and output threads
+ * are started; if false, no time stamps are taken.
+ */
+extern bool pipeline_stats_enabled;
+
+/**
+ * A histogram with power-of-two buckets: bucket 0 counts the value
+ * 0, bucket n counts the values in the range [2^(n-1), 2^n).
+ *
+ * Each histogram must be updated by only one thread, therefore Add()
+ * does not need atomic read-modify-write operations; other threads
+ * may read it at any time.  Other threads may not clear it either;
+ * they request that with Reset(), and the writing thread clears it
+ * in its next Add() call.
+ */
+class PipelineHistogram {
+	static constexpr unsigned N_BUCKETS = 32;
+
+	std::atomic<uint64_t> buckets[N_BUCKETS];
+
+	std::atomic<uint64_t> count, sum, maximum;
+
+	/**
+	 * Has Reset() been called, and the writing thread has not
+	 * yet cleared the histogram?
+	 */
+	std::atomic<bool> reset_requested;
+
+public:
+	PipelineHistogram()
+		:reset_requested(false) {
+		Clear();
+	}
+
+	PipelineHistogram(const PipelineHistogram &) = delete;
+	PipelineHistogram &operator=(const PipelineHistogram &) = delete;
+
+	/**
+	 * Ask the writing thread to clear the histogram.  Until it
+	 * does, Print() shows an empty histogram.  This method may
+	 * be called from any thread.
+	 */
+	void Reset() {
+		reset_requested.store(true, std::memory_order_release);
+	}
+
+	void Add(uint64_t value) {
+		const bool reset =
+			reset_requested.load(std::memory_order_relaxed);
+		if (gcc_unlikely(reset) &&
+		    reset_requested.exchange(false, std::memory_order_acquire))
+			Clear();
+
+		Increment(buckets[BucketOf(value)], 1);
+		Increment(count, 1);
+		Increment(sum, value);
+		if (value > maximum.load(std::memory_order_relaxed))
+			maximum.store(value, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Print the histogram to the client.
+	 *
+	 * @param stage the name of the pipeline stage; this line
+	 * starts a new entry in the response
+	 * @param output the index of the audio output, or -1 if the
+	 * stage is not specific to an output
+	 */
+	void Print(Response &r, const char *stage, int output=-1) const;
+
+private:
+	/**
+	 * Clear all counters.  Only the writing thread may call this
+	 * (or the constructor).
+	 *
+	 * This is inline because #AudioOutput embeds histograms, and
+	 * programs like test/run_output don't link PipelineStats.cxx.
+	 */
+	void Clear() {
+		for (auto &i : buckets)
+			i.store(0, std::memory_order_relaxed);
+
+		count.store(0, std::memory_order_relaxed);
+		sum.store(0, std::memory_order_relaxed);
+		maximum.store(0, std::memory_order_relaxed);
+	}
+
+	gcc_const
+	static unsigned BucketOf(uint64_t value) {
+		if (value == 0)
+			return 0;
+
+		unsigned n = 64 - __builtin_clzll(value);
+		return n < N_BUCKETS ? n : N_BUCKETS - 1;
+	}
+
+	static void Increment(std::atomic<uint64_t> &a, uint64_t delta) {
+		a.store(a.load(std::memory_order_relaxed) + delta,
+			std::memory_order_relaxed);
+	}
+
+	/**
+	 * Returns the upper bound of the bucket which contains the
+	 * given percentile.
+	 */
+	gcc_pure
+	uint64_t GetPercentile(unsigned percent) const;
+};
+
+/**
+ * Statistics collected by one audio output.  All durations are in
+ * microseconds.
+ */
+struct PipelineOutputStats {
+	/**
+	 * From MultipleOutputs::Play() until the output thread begins
+	 * to play the chunk.
+	 */
+	PipelineHistogram pickup;
+
+	/**
+	 * The duration of the filter chain (including replay gain,
+	 * cross-fading and resampling).
+	 */
+	PipelineHistogram filter;
+
+	/**
+	 * The time spent in the output plugin's play() method.
+	 */
+	PipelineHistogram play;
+
+	/**
+	 * From the decoder until the chunk has been written to the
+	 * device.
+	 */
+	PipelineHistogram total;
+
+	void Reset() {
+		pickup.Reset();
+		filter.Reset();
+		play.Reset();
+		total.Reset();
+	}
+};
+
+/**
+ * Statistics collected by the player thread.
+ */
+struct PipelinePlayerStats {
+	/**
+	 * From the decoder until the player thread takes the chunk
+	 * (microseconds).
+	 */
+	PipelineHistogram decoder_latency;
+
+	/**
+	 * The number of chunks left in the decoder's pipe after the
+	 * player thread has taken one.
+	 */
+	PipelineHistogram decoder_depth;
+
+	/**
+	 * The number of chunks in the output pipe after the player
+	 * thread has added one.
+	 */
+	PipelineHistogram output_depth;
+
+	void Reset() {
+		decoder_latency.Reset();
+		decoder_depth.Reset();
+		output_depth.Reset();
+	}
+};
+
+extern PipelinePlayerStats pipeline_player_stats;
+
+void
+pipeline_stats_global_init();
+
+/**
+ * Returns the value of the clock used for the time stamps, or 0 if
+ * the instrumentation is disabled.
+ */
+static inline uint64_t
+pipeline_stats_now()
+{
+	return pipeline_stats_enabled
+		? MonotonicClockUS()
+		: 0;
+}
+
+void
+pipeline_stats_print(Response &r, const Partition &partition);
+
+/**
+ * Clear all statistics.  The histograms are cleared by the threads
+ * which write them, the next time they add a value (see
+ * PipelineHistogram::Reset()).
+ */
+void
+pipeline_stats_reset(Partition &partition);
+
+#endif
@@ -28,8 +28,14 @@
 #include "Instance.hxx"
 #include "db/Interface.hxx"
 #include "client/Response.hxx"
+#include "client/ResponseGenerator.hxx"
+#include "protocol/Ack.hxx"
 #include "util/Error.hxx"
 
+#include <algorithm>
+
+#include <assert.h>
+
 #define SONG_FILE "file: "
 #define SONG_TIME "Time: "
 
@@ -60,6 +66,68 @@ playlist_print_info(Response &r, Partition &partition,
 	queue_print_info(r, partition, queue, start, end);
 }
 
+/**
+ * The number of songs printed by one PlaylistInfoGenerator::Generate()
+ * call.
+ */
+static constexpr unsigned PLAYLIST_INFO_CHUNK = 256;
+
+class PlaylistInfoGenerator final : public ResponseGenerator {
+	Partition &partition;
+	const playlist &pl;
+
+	/**
+	 * The queue version at the beginning.  If the queue gets
+	 * modified between two portions, the response is aborted,
+	 * because the songs sent so far may not be consistent with
+	 * the rest.
+	 */
+	const uint32_t version;
+
+	unsigned position;
+	const unsigned end;
+
+public:
+	PlaylistInfoGenerator(Partition &_partition, const playlist &_pl,
+			      unsigned start, unsigned _end)
+		:partition(_partition), pl(_pl),
+		 version(_pl.queue.version),
+		 position(start), end(_end) {}
+
+	/* virtual methods from class ResponseGenerator */
+	bool Generate(Response &r) override {
+		const Queue &queue = pl.queue;
+
+		if (queue.version != version)
+			throw ProtocolError(ACK_ERROR_PLAYER_SYNC,
+					    "Queue was modified during the listing");
+
+		assert(end <= queue.GetLength());
+
+		const unsigned limit =
+			std::min(end, position + PLAYLIST_INFO_CHUNK);
+		queue_print_info(r, partition, queue, position, limit);
+		position = limit;
+		return position >= end;
+	}
+};
+
+ResponseGenerator *
+playlist_print_info_generator(Partition &partition,
+			      const playlist &playlist,
+			      unsigned start, unsigned end)
+{
+	if (end > playlist.queue.GetLength())
+		/* correct the "end" offset */
+		end = playlist.queue.GetLength();
+
+	if (start > end)
+		/* an invalid "start" offset is fatal */
+		throw PlaylistError::BadRange();
+
+	return new PlaylistInfoGenerator(partition, playlist, start, end);
+}
+
 void
 playlist_print_id(Response &r, Partition &partition, const playlist &playlist,
 		  unsigned id)
@@ -26,6 +26,7 @@ struct playlist;
 struct Partition;
 class SongFilter;
 class Response;
+class ResponseGenerator;
 
 /**
  * Sends the whole playlist to the client, song URIs only.
@@ -47,6 +48,19 @@ playlist_print_info(Response &r, Partition &partition,
 		    const playlist &playlist,
 		    unsigned start, unsigned end);
 
+/**
+ * Like playlist_print_info(), but return a #ResponseGenerator which
+ * sends the songs in portions, see Client::RunResponseGenerator().
+ * If the playlist is modified meanwhile, the remaining portions
+ * reflect the modified playlist.
+ *
+ * Throws #PlaylistError if the range is invalid.
+ */
+ResponseGenerator *
+playlist_print_info_generator(Partition &partition,
+			      const playlist &playlist,
+			      unsigned start, unsigned end);
+
 /**
  * Sends the song with the specified id to the client.
  *
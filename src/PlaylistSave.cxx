@@ -38,12 +38,13 @@
 void
 playlist_print_song(BufferedOutputStream &os, const DetachedSong &song)
 {
-	const char *uri_utf8 = playlist_saveAbsolutePaths
-		? song.GetRealURI()
-		: song.GetURI();
+	const std::string uri_utf8 = playlist_saveAbsolutePaths
+		? map_song_real_uri(song)
+		: std::string(song.GetURI());
 
 	try {
-		const auto uri_fs = AllocatedPath::FromUTF8Throw(uri_utf8);
+		const auto uri_fs =
+			AllocatedPath::FromUTF8Throw(uri_utf8.c_str());
 		os.Format("%s\n", NarrowPath(uri_fs).c_str());
 	} catch (const std::runtime_error &) {
 	}
@@ -152,6 +152,38 @@ DetachedSong::LoadFile(Path path)
 	return true;
 }
 
+void
+DetachedSong::CompleteTag()
+{
+	if (!partial_tag)
+		return;
+
+	/* don't try again if this fails */
+	partial_tag = false;
+
+	if (!start_time.IsZero() || !end_time.IsZero())
+		return;
+
+	/* the "real" URI has been mapped by the main thread, see
+	   playlist::DupForPlayer() */
+	if (!IsAbsoluteFile())
+		return;
+
+	const AllocatedPath path_fs = AllocatedPath::FromUTF8(GetRealURI());
+	if (path_fs.IsNull())
+		return;
+
+	TagBuilder file_tag;
+	if (!tag_file_scan(path_fs, file_tag))
+		return;
+
+	/* the items we have take precedence, because they may have
+	   been merged from a playlist file */
+	TagBuilder tag_builder(tag);
+	tag_builder.Complement(file_tag.Commit());
+	tag_builder.Commit(tag);
+}
+
 bool
 DetachedSong::Update()
 {
@@ -21,9 +21,11 @@
 #include "StateFile.hxx"
 #include "output/OutputState.hxx"
 #include "queue/PlaylistState.hxx"
+#include "queue/QueueSave.hxx"
 #include "fs/io/TextFile.hxx"
 #include "fs/io/FileOutputStream.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
+#include "fs/FileSystem.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
 #include "mixer/Volume.hxx"
@@ -31,6 +33,7 @@
 #include "util/Domain.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
 #include <exception>
 
 #include <string.h>
@@ -38,13 +41,18 @@
 static constexpr Domain state_file_domain("state_file");
 
 StateFile::StateFile(AllocatedPath &&_path, unsigned _interval,
+		     bool _binary_queue,
 		     Partition &_partition, EventLoop &_loop)
 	:TimeoutMonitor(_loop),
 	 path(std::move(_path)), path_utf8(path.ToUTF8()),
 	 interval(_interval),
+	 queue_path(AllocatedPath::FromFS(path.c_str() +
+					  PathTraitsFS::string(PATH_LITERAL(".queue")))),
+	 binary_queue(_binary_queue),
 	 partition(_partition),
 	 prev_volume_version(0), prev_output_version(0),
-	 prev_playlist_version(0)
+	 prev_playlist_version(0),
+	 queue_file_exists(false)
 {
 }
 
@@ -71,7 +79,47 @@ StateFile::Write(BufferedOutputStream &os)
 {
 	save_sw_volume_state(os);
 	audio_output_state_save(os, partition.outputs);
-	playlist_state_save(os, partition.playlist, partition.pc);
+	playlist_state_save(os, partition.playlist, partition.pc,
+			    binary_queue);
+}
+
+bool
+StateFile::IsQueueModified() const
+{
+	const Queue &queue = partition.playlist.queue;
+
+	if (!queue_file_exists || queue.version != saved_queue_version)
+		return true;
+
+	if (!queue.random)
+		return !saved_queue_order.empty();
+
+	return saved_queue_order.size() != queue.GetLength() ||
+		!std::equal(saved_queue_order.begin(),
+			    saved_queue_order.end(), queue.order);
+}
+
+void
+StateFile::WriteQueue()
+{
+	const Queue &queue = partition.playlist.queue;
+
+	FormatDebug(state_file_domain, "Saving queue file");
+
+	FileOutputStream fos(queue_path);
+	BufferedOutputStream bos(fos);
+	queue_save_binary(bos, queue);
+	bos.Flush();
+	fos.Commit();
+
+	queue_file_exists = true;
+	saved_queue_version = queue.version;
+
+	if (queue.random)
+		saved_queue_order.assign(queue.order,
+					 queue.order + queue.GetLength());
+	else
+		saved_queue_order.clear();
 }
 
 inline void
@@ -89,9 +137,21 @@ StateFile::Write()
 		    "Saving state file %s", path_utf8.c_str());
 
 	try {
+		/* the queue file is written first; the state file
+		   refers to it */
+		if (binary_queue && IsQueueModified())
+			WriteQueue();
+
 		FileOutputStream fos(path);
 		Write(fos);
 		fos.Commit();
+
+		if (!binary_queue && queue_file_exists) {
+			/* the state file doesn't refer to the queue
+			   file anymore */
+			RemoveFile(queue_path);
+			queue_file_exists = false;
+		}
 	} catch (const std::exception &e) {
 		LogError(e);
 	}
@@ -120,6 +180,7 @@ try {
 		success = read_sw_volume_state(line, partition.outputs) ||
 			audio_output_state_read(line, partition.outputs) ||
 			playlist_state_restore(line, file, song_loader,
+					       queue_path,
 					       partition.playlist,
 					       partition.pc);
 		if (!success)
@@ -128,6 +189,9 @@ try {
 				    line);
 	}
 
+	if (!binary_queue)
+		queue_file_exists = FileExists(queue_path);
+
 	RememberVersions();
 } catch (const std::exception &e) {
 	LogError(e);
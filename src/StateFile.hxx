@@ -25,6 +25,7 @@
 #include "Compiler.h"
 
 #include <string>
+#include <vector>
 
 struct Partition;
 class OutputStream;
@@ -36,6 +37,19 @@ class StateFile final : private TimeoutMonitor {
 
 	const unsigned interval;
 
+	/**
+	 * The file which contains the queue in the binary format
+	 * (see queue_save_binary()).
+	 */
+	const AllocatedPath queue_path;
+
+	/**
+	 * Save the queue to #queue_path instead of the state file?
+	 * It is then rewritten only if the queue has been modified,
+	 * which makes periodic saves of a large queue cheap.
+	 */
+	const bool binary_queue;
+
 	Partition &partition;
 
 	/**
@@ -45,10 +59,30 @@ class StateFile final : private TimeoutMonitor {
 	unsigned prev_volume_version, prev_output_version,
 		prev_playlist_version;
 
+	/**
+	 * Does #queue_path exist?  If #binary_queue is set, then it
+	 * contains the queue described by the following attributes;
+	 * else it is obsolete and will be deleted by the next save.
+	 */
+	bool queue_file_exists;
+
+	/**
+	 * The #Queue::version of the queue in #queue_path.
+	 */
+	unsigned saved_queue_version;
+
+	/**
+	 * A copy of #Queue::order of the queue in #queue_path, or
+	 * empty if it was not in random mode.  The order can change
+	 * without a new #Queue::version.
+	 */
+	std::vector<unsigned> saved_queue_order;
+
 public:
 	static constexpr unsigned DEFAULT_INTERVAL = 2 * 60;
 
 	StateFile(AllocatedPath &&path, unsigned interval,
+		  bool binary_queue,
 		  Partition &partition, EventLoop &loop);
 
 	void Read();
@@ -63,6 +97,18 @@ private:
 	void Write(OutputStream &os);
 	void Write(BufferedOutputStream &os);
 
+	/**
+	 * Has the queue been modified since it was written to
+	 * #queue_path?
+	 */
+	gcc_pure
+	bool IsQueueModified() const;
+
+	/**
+	 * Write the queue to #queue_path.
+	 */
+	void WriteQueue();
+
 	/**
 	 * Save the current state versions for use with IsModified().
 	 */
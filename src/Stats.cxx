@@ -20,6 +20,8 @@
 #include "config.h"
 #include "Stats.hxx"
 #include "player/Control.hxx"
+#include "MusicPipe.hxx"
+#include "PipelineStats.hxx"
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
@@ -138,6 +140,14 @@ stats_print(Response &r, const Partition &partition)
 #endif
 		 (unsigned long)(partition.pc.GetTotalPlayTime() + 0.5));
 
+	if (partition.pc.lock_free_pipe || pipeline_stats_enabled)
+		/* only for those who compare the lock-free pipe
+		   with the mutex-protected one */
+		r.Format("pipe_contention: %lu\n"
+			 "buffer_contention: %lu\n",
+			 MusicPipe::GetContention(),
+			 partition.pc.LockGetBufferContention());
+
 #ifdef ENABLE_DATABASE
 	const Database *db = partition.instance.database;
 	if (db != nullptr)
@@ -23,6 +23,8 @@
 #include "check.h"
 #include "ClientMessage.hxx"
 #include "command/CommandListBuilder.hxx"
+#include "command/CommandThread.hxx"
+#include "ResponseGenerator.hxx"
 #include "event/FullyBufferedSocket.hxx"
 #include "event/TimeoutMonitor.hxx"
 #include "Compiler.h"
@@ -30,6 +32,7 @@
 #include <boost/intrusive/link_mode.hpp>
 #include <boost/intrusive/list_hook.hpp>
 
+#include <memory>
 #include <set>
 #include <string>
 #include <list>
@@ -71,6 +74,26 @@ public:
 	/** idle flags that the client wants to receive */
 	unsigned idle_subscriptions;
 
+	/**
+	 * Is a command of this client currently being executed by
+	 * the #CommandThread?  While this is set, no input is
+	 * processed, and this object must not be deleted.
+	 */
+	bool background_busy;
+
+	/**
+	 * Generates the rest of the response to the current command,
+	 * see RunResponseGenerator().  While this is set, no input is
+	 * processed.
+	 */
+	std::unique_ptr<ResponseGenerator> generator;
+
+	/**
+	 * The name of the command whose response is generated by
+	 * #generator.  Used to generate error messages.
+	 */
+	const char *generator_command;
+
 	/**
 	 * A list of channel names this client is subscribed to.
 	 */
@@ -107,6 +130,36 @@ public:
 	void Close();
 	void SetExpired();
 
+	/**
+	 * Execute a command in the #CommandThread.
+	 *
+	 * @return false if that is not possible; the caller should
+	 * then execute the command synchronously
+	 */
+	bool StartBackgroundCommand(const char *name, CommandHandler handler,
+				    Request args);
+
+	/**
+	 * Called in the main thread when the #CommandThread has
+	 * generated more output for the command started by
+	 * StartBackgroundCommand(), or when it has finished.
+	 *
+	 * @return false if the client has been closed
+	 */
+	bool OnBackgroundCommandOutput();
+
+	/**
+	 * Send the response generated by the given object.  Unless
+	 * inside a command list, only the first portion is generated
+	 * right now; the rest follows as the client receives it.
+	 *
+	 * @param g a newly allocated object; this method takes
+	 * ownership
+	 * @return the value to be returned by the command handler
+	 */
+	CommandResult RunResponseGenerator(ResponseGenerator *g,
+					   Response &r);
+
 	bool Write(const void *data, size_t length);
 
 	/**
@@ -191,11 +244,24 @@ public:
 	const Storage *GetStorage() const;
 
 private:
+	bool ContinueResponseGenerator();
+
+	/**
+	 * The response to a command executed by the #CommandThread
+	 * or by a #ResponseGenerator has been sent completely.
+	 *
+	 * @return false if the client has been closed
+	 */
+	bool OnDeferredResponseFinished(CommandResult result);
+
 	/* virtual methods from class BufferedSocket */
 	virtual InputResult OnSocketInput(void *data, size_t length) override;
 	virtual void OnSocketError(Error &&error) override;
 	virtual void OnSocketClosed() override;
 
+	/* virtual methods from class FullyBufferedSocket */
+	virtual bool OnSocketDrained() override;
+
 	/* virtual methods from class TimeoutMonitor */
 	virtual void OnTimeout() override;
 };
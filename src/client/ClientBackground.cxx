@@ -0,0 +1,186 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "ClientInternal.hxx"
+#include "ClientList.hxx"
+#include "Partition.hxx"
+#include "Instance.hxx"
+#include "command/Request.hxx"
+#include "command/CommandError.hxx"
+#include "protocol/Result.hxx"
+#include "Log.hxx"
+
+#include <assert.h>
+
+bool
+Client::StartBackgroundCommand(const char *name, CommandHandler handler,
+			       Request args)
+{
+	assert(!background_busy);
+	assert(!idle_waiting);
+	assert(!cmd_list.IsActive());
+
+	CommandThread &thread =
+		partition.instance.client_list->GetCommandThread();
+	if (!thread.Push(*this, name, handler, args))
+		return false;
+
+	background_busy = true;
+
+	/* the client is waiting for us, not vice versa */
+	TimeoutMonitor::Cancel();
+	return true;
+}
+
+bool
+Client::OnBackgroundCommandOutput()
+{
+	assert(background_busy);
+
+	if (!IsExpired() && !IsOutputEmpty())
+		/* wait for OnSocketDrained() */
+		return true;
+
+	CommandThread &thread =
+		partition.instance.client_list->GetCommandThread();
+
+	std::string text;
+	CommandResult result = CommandResult::ERROR;
+	bool overflow = false;
+	const bool done = thread.Take(*this, text, result, overflow);
+	if (done)
+		background_busy = false;
+
+	if (IsExpired()) {
+		/* the client was closed while the command was
+		   running; Close() has postponed the cleanup */
+		if (done)
+			Close();
+		return false;
+	}
+
+	if (overflow) {
+		FormatWarning(client_domain,
+			      "[%u] output buffer size is larger than the max (%lu)",
+			      num, (unsigned long)client_max_output_buffer_size);
+		Close();
+		return false;
+	}
+
+	if (!Write(text.data(), text.length()))
+		return false;
+
+	if (done)
+		return OnDeferredResponseFinished(result);
+
+	if (text.empty())
+		/* the client is waiting for the CommandThread */
+		TimeoutMonitor::Cancel();
+	else
+		/* the CommandThread is waiting for the client */
+		TimeoutMonitor::ScheduleSeconds(client_timeout);
+
+	return true;
+}
+
+CommandResult
+Client::RunResponseGenerator(ResponseGenerator *_g, Response &r)
+{
+	std::unique_ptr<ResponseGenerator> g(_g);
+
+	assert(!generator);
+	assert(!background_busy);
+
+	if (cmd_list.IsActive()) {
+		/* the next command in the list must not be executed
+		   before this response is complete */
+		while (!g->Generate(r)) {}
+		return CommandResult::OK;
+	}
+
+	if (g->Generate(r))
+		return CommandResult::OK;
+
+	/* the rest is generated by OnSocketDrained() */
+	generator = std::move(g);
+	generator_command = r.GetCommand();
+	return CommandResult::BACKGROUND;
+}
+
+inline bool
+Client::ContinueResponseGenerator()
+{
+	assert(generator);
+
+	Response r(*this, 0);
+	r.SetCommand(generator_command);
+
+	CommandResult result = CommandResult::OK;
+	try {
+		if (!generator->Generate(r)) {
+			if (IsExpired())
+				return false;
+
+			/* wait for OnSocketDrained() */
+			TimeoutMonitor::ScheduleSeconds(client_timeout);
+			return true;
+		}
+	} catch (...) {
+		PrintError(r, std::current_exception());
+		result = CommandResult::ERROR;
+	}
+
+	generator.reset();
+	return !IsExpired() && OnDeferredResponseFinished(result);
+}
+
+bool
+Client::OnDeferredResponseFinished(CommandResult result)
+{
+	assert(!background_busy);
+	assert(!generator);
+
+	if (result == CommandResult::OK)
+		command_success(*this);
+
+	if ((result != CommandResult::OK && result != CommandResult::ERROR) ||
+	    IsExpired()) {
+		Close();
+		return false;
+	}
+
+	TimeoutMonitor::ScheduleSeconds(client_timeout);
+
+	/* process the input which was received meanwhile */
+	return ResumeInput();
+}
+
+bool
+Client::OnSocketDrained()
+{
+	if (generator)
+		return ContinueResponseGenerator();
+
+	if (background_busy)
+		return OnBackgroundCommandOutput();
+
+	return true;
+}
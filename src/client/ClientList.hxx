@@ -25,6 +25,8 @@
 #include <boost/intrusive/list.hpp>
 
 class ClientList {
+	CommandThread command_thread;
+
 	typedef boost::intrusive::list<Client,
 				       boost::intrusive::constant_time_size<true>> List;
 
@@ -33,12 +35,17 @@ class ClientList {
 	List list;
 
 public:
-	ClientList(unsigned _max_size)
-		:max_size(_max_size) {}
+	ClientList(EventLoop &_loop, unsigned _max_size)
+		:command_thread(_loop), max_size(_max_size) {}
 	~ClientList() {
+		command_thread.Stop();
 		CloseAll();
 	}
 
+	CommandThread &GetCommandThread() {
+		return command_thread;
+	}
+
 	List::iterator begin() {
 		return list.begin();
 	}
@@ -51,6 +51,7 @@ Client::Client(EventLoop &_loop, Partition &_partition,
 	 uid(_uid),
 	 num(_num),
 	 idle_waiting(false), idle_flags(0),
+	 background_busy(false),
 	 num_subscriptions(0)
 {
 	TimeoutMonitor::ScheduleSeconds(client_timeout);
@@ -108,6 +109,21 @@ client_new(EventLoop &loop, Partition &partition,
 void
 Client::Close()
 {
+	if (background_busy) {
+		CommandThread &thread =
+			partition.instance.client_list->GetCommandThread();
+		if (!thread.Cancel(*this)) {
+			/* the CommandThread is still using this
+			   object; OnBackgroundCommandOutput() will
+			   call this method again */
+			SetExpired();
+			TimeoutMonitor::Cancel();
+			return;
+		}
+
+		background_busy = false;
+	}
+
 	partition.instance.client_list->Remove(*this);
 
 	SetExpired();
@@ -19,20 +19,68 @@
 
 #include "config.h"
 #include "Response.hxx"
-#include "Client.hxx"
+#include "ClientInternal.hxx"
 #include "util/FormatString.hxx"
 #include "util/AllocatedString.hxx"
 
+#include <string.h>
+
+/**
+ * Collect at least this number of bytes before passing them to the
+ * #ResponseStream.
+ */
+static constexpr size_t RESPONSE_STREAM_CHUNK = 64 * 1024;
+
+bool
+Response::Flush()
+{
+	if (stream == nullptr)
+		return true;
+
+	if (discard)
+		return false;
+
+	if (buffer.length() < RESPONSE_STREAM_CHUNK)
+		return true;
+
+	discard = !stream->Send(std::move(buffer));
+	buffer.clear();
+	return !discard;
+}
+
+void
+Response::Finish()
+{
+	if (stream == nullptr || discard || buffer.empty())
+		return;
+
+	discard = !stream->Send(std::move(buffer));
+	buffer.clear();
+}
+
 bool
 Response::Write(const void *data, size_t length)
 {
-	return client.Write(data, length);
+	if (stream == nullptr)
+		return client.Write(data, length);
+
+	if (discard)
+		return false;
+
+	if (buffer.length() + length > client_max_output_buffer_size) {
+		overflow = true;
+		discard = true;
+		return false;
+	}
+
+	buffer.append((const char *)data, length);
+	return true;
 }
 
 bool
 Response::Write(const char *data)
 {
-	return client.Write(data);
+	return Write(data, strlen(data));
 }
 
 bool
@@ -23,11 +23,29 @@
 #include "check.h"
 #include "protocol/Ack.hxx"
 
+#include <string>
+
 #include <stddef.h>
 #include <stdarg.h>
 
 class Client;
 
+/**
+ * A destination for the text of a #Response which is not written to
+ * the client's socket directly, see #CommandThread.
+ */
+class ResponseStream {
+public:
+	/**
+	 * Consume the next portion of the response.  This may block
+	 * until the client has received the previous portions.
+	 *
+	 * @return false if the client is gone and further output
+	 * shall be discarded
+	 */
+	virtual bool Send(std::string &&text) = 0;
+};
+
 class Response {
 	Client &client;
 
@@ -42,17 +60,83 @@ class Response {
 	 */
 	const char *command;
 
+	/**
+	 * If this is not nullptr, then the response is collected in
+	 * #buffer and passed to this object by Flush() and Finish()
+	 * instead of being written to the client.
+	 */
+	ResponseStream *const stream;
+
+	std::string buffer;
+
+	/**
+	 * Set when the #buffer has grown beyond
+	 * #client_max_output_buffer_size.
+	 */
+	bool overflow = false;
+
+	/**
+	 * Set when the #stream has refused more data, or after an
+	 * overflow.  All further output is discarded.
+	 */
+	bool discard = false;
+
 public:
 	Response(Client &_client, unsigned _list_index)
-		:client(_client), list_index(_list_index), command("") {}
+		:client(_client), list_index(_list_index), command(""),
+		 stream(nullptr) {}
+
+	/**
+	 * Construct a #Response which passes the text to the given
+	 * #ResponseStream.
+	 */
+	Response(Client &_client, unsigned _list_index,
+		 ResponseStream &_stream)
+		:client(_client), list_index(_list_index), command(""),
+		 stream(&_stream) {}
 
 	Response(const Response &) = delete;
 	Response &operator=(const Response &) = delete;
 
+	const char *GetCommand() const {
+		return command;
+	}
+
 	void SetCommand(const char *_command) {
 		command = _command;
 	}
 
+	/**
+	 * Is the text passed to a #ResponseStream?  Only then it is
+	 * worth calling Flush().
+	 */
+	bool IsStream() const {
+		return stream != nullptr;
+	}
+
+	bool IsOverflow() const {
+		return overflow;
+	}
+
+	/**
+	 * Pass the text collected so far to the #ResponseStream if it
+	 * is large enough.  Commands generating huge responses call
+	 * this between portions, which allows sending the response
+	 * while it is being generated.  This may block, therefore
+	 * the caller must not hold any locks (e.g. the database
+	 * lock).  Does nothing if there is no #ResponseStream.
+	 *
+	 * @return false if the client is gone and the command should
+	 * stop generating the response
+	 */
+	bool Flush();
+
+	/**
+	 * Pass the remaining text to the #ResponseStream.  To be
+	 * called after the command has finished.
+	 */
+	void Finish();
+
 	bool Write(const void *data, size_t length);
 	bool Write(const char *data);
 	bool FormatV(const char *fmt, va_list args);
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_RESPONSE_GENERATOR_HXX
+#define MPD_RESPONSE_GENERATOR_HXX
+
+#include "check.h"
+
+class Response;
+
+/**
+ * Generates a huge response in portions, each time the client's
+ * output buffer has been sent to the socket.  This limits the memory
+ * used by the output buffer.  See Client::RunResponseGenerator().
+ */
+class ResponseGenerator {
+public:
+	virtual ~ResponseGenerator() {}
+
+	/**
+	 * Write the next portion of the response.
+	 *
+	 * Throws std::runtime_error on error; the response is then
+	 * finished with an "ACK".
+	 *
+	 * @return true if the response is complete
+	 */
+	virtual bool Generate(Response &r) = 0;
+};
+
+#endif
@@ -42,6 +42,11 @@
 #include "util/Error.hxx"
 #include "util/StringAPI.hxx"
 
+#ifdef ENABLE_DATABASE
+#include "db/Interface.hxx"
+#include "db/DatabasePlugin.hxx"
+#endif
+
 #ifdef ENABLE_SQLITE
 #include "StickerCommands.hxx"
 #include "sticker/StickerDatabase.hxx"
@@ -137,6 +142,7 @@ static constexpr struct command commands[] = {
 	{ "password", PERMISSION_NONE, 1, 1, handle_password },
 	{ "pause", PERMISSION_CONTROL, 0, 1, handle_pause },
 	{ "ping", PERMISSION_NONE, 0, 0, handle_ping },
+	{ "pipelinestats", PERMISSION_READ, 0, 1, handle_pipelinestats },
 	{ "play", PERMISSION_CONTROL, 0, 1, handle_play },
 	{ "playid", PERMISSION_CONTROL, 0, 1, handle_playid },
 	{ "playlist", PERMISSION_READ, 0, 0, handle_playlist },
@@ -358,6 +364,35 @@ command_checked_lookup(Response &r, unsigned permission,
 	return cmd;
 }
 
+#ifdef ENABLE_DATABASE
+
+/**
+ * Shall this command be executed by the #CommandThread?  This is
+ * only done for read-only database queries which may take a long
+ * time on a large database, and only if the database plugin allows
+ * concurrent access.  Command lists are always executed
+ * synchronously.
+ */
+gcc_pure
+static bool
+command_background(const Client &client, const struct command &cmd)
+{
+	if (cmd.handler != handle_find && cmd.handler != handle_search &&
+	    cmd.handler != handle_count && cmd.handler != handle_list &&
+	    cmd.handler != handle_listall &&
+	    cmd.handler != handle_listallinfo)
+		return false;
+
+	if (client.cmd_list.IsActive())
+		return false;
+
+	const Database *db = client.GetDatabase(IgnoreError());
+	return db != nullptr &&
+		(db->GetPlugin().flags & DatabasePlugin::FLAG_CONCURRENT_VISIT);
+}
+
+#endif
+
 CommandResult
 command_process(Client &client, unsigned num, char *line)
 try {
@@ -410,6 +445,12 @@ try {
 		command_checked_lookup(r, client.GetPermission(),
 				       cmd_name, args);
 
+#ifdef ENABLE_DATABASE
+	if (cmd != nullptr && command_background(client, *cmd) &&
+	    client.StartBackgroundCommand(cmd->cmd, cmd->handler, args))
+		return CommandResult::BACKGROUND;
+#endif
+
 	CommandResult ret = cmd
 		? cmd->handler(client, args, r)
 		: CommandResult::ERROR;
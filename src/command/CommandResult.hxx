@@ -41,6 +41,13 @@ enum class CommandResult {
 	 */
 	IDLE,
 
+	/**
+	 * The command is being executed by the #CommandThread.  The
+	 * response will be sent when it has finished; until then, no
+	 * further input from this client shall be processed.
+	 */
+	BACKGROUND,
+
 	/**
 	 * There was an error.  The "ACK" response was sent to the
 	 * client.
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "CommandThread.hxx"
+#include "CommandError.hxx"
+#include "Request.hxx"
+#include "client/Client.hxx"
+#include "client/Response.hxx"
+#include "thread/Name.hxx"
+
+#include <iterator>
+
+#include <assert.h>
+
+/**
+ * Job::Send() blocks while this number of bytes is waiting to be
+ * picked up by the main thread.
+ */
+static constexpr size_t MAX_PENDING_OUTPUT = 256 * 1024;
+
+CommandThread::Job::Job(CommandThread &_thread, Client &_client,
+			const char *_name,
+			CommandHandler _handler, Request _args)
+	:thread(_thread), client(_client), name(_name), handler(_handler),
+	 args(_args.begin(), _args.end())
+{
+}
+
+bool
+CommandThread::Job::Send(std::string &&text)
+{
+	const ScopeLock protect(thread.mutex);
+
+	while (!cancelled && !thread.quit && !thread.unbounded &&
+	       output.length() >= MAX_PENDING_OUTPUT)
+		thread.cond.wait(thread.mutex);
+
+	if (cancelled || thread.quit)
+		return false;
+
+	if (output.empty()) {
+		output = std::move(text);
+
+		/* wake up the main thread */
+		thread.DeferredMonitor::Schedule();
+	} else
+		output.append(text);
+
+	return true;
+}
+
+inline void
+CommandThread::Job::Run()
+{
+	std::vector<const char *> argv;
+	argv.reserve(args.size());
+	for (const auto &i : args)
+		argv.push_back(i.c_str());
+
+	Response r(client, 0, *this);
+	r.SetCommand(name);
+
+	try {
+		result = handler(client, Request(argv.data(), argv.size()), r);
+	} catch (const std::exception &) {
+		PrintError(r, std::current_exception());
+		result = CommandResult::ERROR;
+	}
+
+	r.Finish();
+	overflow = r.IsOverflow();
+}
+
+bool
+CommandThread::Push(Client &client, const char *name, CommandHandler handler,
+		    Request args)
+{
+	const ScopeLock protect(mutex);
+	assert(!quit);
+
+	if (pending.size() + running.size() >= n_threads &&
+	    n_threads < MAX_THREADS &&
+	    threads[n_threads].Start(Run, this))
+		++n_threads;
+
+	if (n_threads == 0)
+		return false;
+
+	pending.emplace_back(*this, client, name, handler, args);
+	cond.broadcast();
+	return true;
+}
+
+CommandThread::Job *
+CommandThread::Find(std::list<Job> &list, const Client &client)
+{
+	for (auto &job : list)
+		if (&job.client == &client)
+			return &job;
+
+	return nullptr;
+}
+
+bool
+CommandThread::Take(Client &client, std::string &dest,
+		    CommandResult &result, bool &overflow)
+{
+	const ScopeLock protect(mutex);
+
+	Job *job = Find(running, client);
+	if (job != nullptr) {
+		dest = std::move(job->output);
+		job->output.clear();
+		cond.broadcast();
+		return false;
+	}
+
+	for (auto i = finished.begin(); i != finished.end(); ++i) {
+		if (&i->client == &client) {
+			dest = std::move(i->output);
+			result = i->result;
+			overflow = i->overflow;
+			finished.erase(i);
+			return true;
+		}
+	}
+
+	/* not yet started */
+	dest.clear();
+	return false;
+}
+
+static bool
+EraseJob(std::list<CommandThread::Job> &list, const Client &client)
+{
+	for (auto i = list.begin(); i != list.end(); ++i) {
+		if (&i->client == &client) {
+			list.erase(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool
+CommandThread::Cancel(Client &client)
+{
+	const ScopeLock protect(mutex);
+
+	if (EraseJob(pending, client) || EraseJob(finished, client))
+		return true;
+
+	Job *job = Find(running, client);
+	assert(job != nullptr);
+
+	job->cancelled = true;
+	job->output.clear();
+	cond.broadcast();
+	return false;
+}
+
+void
+CommandThread::WaitIdle()
+{
+	const ScopeLock protect(mutex);
+
+	unbounded = true;
+	cond.broadcast();
+
+	while (!pending.empty() || !running.empty())
+		cond.wait(mutex);
+
+	unbounded = false;
+}
+
+void
+CommandThread::Stop()
+{
+	if (n_threads == 0)
+		return;
+
+	{
+		const ScopeLock protect(mutex);
+		quit = true;
+		cond.broadcast();
+	}
+
+	for (unsigned i = 0; i < n_threads; ++i)
+		threads[i].Join();
+	n_threads = 0;
+
+	DeferredMonitor::Cancel();
+	pending.clear();
+	finished.clear();
+}
+
+inline void
+CommandThread::Run()
+{
+	SetThreadName("command");
+
+	const ScopeLock protect(mutex);
+
+	while (!quit) {
+		if (pending.empty()) {
+			cond.wait(mutex);
+			continue;
+		}
+
+		running.splice(running.end(), pending, pending.begin());
+		const auto job = std::prev(running.end());
+
+		{
+			const ScopeUnlock unlock(mutex);
+			job->Run();
+		}
+
+		finished.splice(finished.end(), running, job);
+		cond.broadcast();
+		DeferredMonitor::Schedule();
+	}
+}
+
+void
+CommandThread::Run(void *ctx)
+{
+	CommandThread &thread = *(CommandThread *)ctx;
+	thread.Run();
+}
+
+void
+CommandThread::RunDeferred()
+{
+	std::vector<Client *> clients;
+
+	{
+		const ScopeLock protect(mutex);
+
+		for (auto &job : running)
+			if (!job.output.empty())
+				clients.push_back(&job.client);
+
+		for (auto &job : finished)
+			clients.push_back(&job.client);
+	}
+
+	/* the Client objects are not deleted while their job is
+	   known to this object */
+	for (Client *client : clients)
+		client->OnBackgroundCommandOutput();
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_COMMAND_THREAD_HXX
+#define MPD_COMMAND_THREAD_HXX
+
+#include "check.h"
+#include "CommandResult.hxx"
+#include "event/DeferredMonitor.hxx"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+#include "client/Response.hxx"
+#include "Compiler.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+class Client;
+class Request;
+
+typedef CommandResult (*CommandHandler)(Client &client, Request request,
+					Response &response);
+
+/**
+ * A thread which executes expensive read-only commands (i.e. database
+ * queries) on behalf of clients, so the main thread remains
+ * responsive.
+ *
+ * The response is passed to the main thread in portions (see
+ * Response::Flush()), where Client::OnBackgroundCommandOutput()
+ * picks it up with Take() whenever the client's output buffer is
+ * empty.  While a portion is waiting to be picked up, the thread
+ * blocks, which limits the memory used by huge responses.
+ *
+ * Up to #MAX_THREADS threads are started on demand, so a client
+ * which receives its response slowly does not block the queries of
+ * other clients.  Jobs are started in the order they were submitted.
+ */
+class CommandThread final : DeferredMonitor {
+public:
+	struct Job final : ResponseStream {
+		CommandThread &thread;
+
+		Client &client;
+
+		const char *const name;
+
+		const CommandHandler handler;
+
+		const std::vector<std::string> args;
+
+		/**
+		 * Response text which was generated, but not yet
+		 * picked up by the main thread.  Protected by
+		 * CommandThread::mutex.
+		 */
+		std::string output;
+
+		CommandResult result = CommandResult::ERROR;
+
+		/**
+		 * Set if the (unflushed part of the) response did not
+		 * fit into #client_max_output_buffer_size.
+		 */
+		bool overflow = false;
+
+		/**
+		 * The client is gone; discard all output.  Protected
+		 * by CommandThread::mutex.
+		 */
+		bool cancelled = false;
+
+		Job(CommandThread &_thread, Client &_client, const char *_name,
+		    CommandHandler _handler, Request _args);
+
+		void Run();
+
+		/* virtual methods from class ResponseStream */
+		bool Send(std::string &&text) override;
+	};
+
+private:
+	Mutex mutex;
+
+	/**
+	 * Signalled when a job is added to #pending, when a job has
+	 * finished, when output has been picked up and when the
+	 * thread shall quit.
+	 */
+	Cond cond;
+
+	static constexpr unsigned MAX_THREADS = 4;
+
+	Thread threads[MAX_THREADS];
+
+	/**
+	 * The number of threads which have been started.
+	 */
+	unsigned n_threads = 0;
+
+	/**
+	 * Jobs waiting to be executed, those being executed and
+	 * those which are finished, but whose output has not yet
+	 * been picked up completely.
+	 */
+	std::list<Job> pending, running, finished;
+
+	/**
+	 * If this is set, then Job::Send() never blocks, see
+	 * WaitIdle().
+	 */
+	bool unbounded = false;
+
+	bool quit = false;
+
+public:
+	explicit CommandThread(EventLoop &_loop)
+		:DeferredMonitor(_loop) {}
+
+	~CommandThread() {
+		Stop();
+	}
+
+	CommandThread(const CommandThread &) = delete;
+	CommandThread &operator=(const CommandThread &) = delete;
+
+	/**
+	 * Submit a new job.  The caller must not process any further
+	 * input from this client until the job has finished.
+	 *
+	 * @return false if no thread could be started; the caller
+	 * should then execute the command synchronously
+	 */
+	bool Push(Client &client, const char *name, CommandHandler handler,
+		  Request args);
+
+	/**
+	 * Move the response text which has been generated for the
+	 * specified client so far to the given buffer.
+	 *
+	 * @return true if the job has finished; it has been removed
+	 * and its result has been stored in the given variables
+	 */
+	bool Take(Client &client, std::string &dest,
+		  CommandResult &result, bool &overflow);
+
+	/**
+	 * Discard the job of the specified client.  If it is
+	 * currently running, only its further output is discarded.
+	 *
+	 * @return true if the job was discarded, false if it is
+	 * still running
+	 */
+	bool Cancel(Client &client);
+
+	/**
+	 * Wait until all jobs have been executed.  This must be
+	 * called before destroying an object which may be in use by
+	 * a job, e.g. an unmounted database.  Meanwhile, responses
+	 * are buffered in memory without limit, because the main
+	 * thread is not able to send them.
+	 */
+	void WaitIdle();
+
+	/**
+	 * Stop all threads.  Jobs which have not been delivered yet
+	 * are discarded.  This must be called before the #Client
+	 * objects are destroyed.
+	 */
+	void Stop();
+
+private:
+	gcc_pure
+	Job *Find(std::list<Job> &list, const Client &client);
+
+	void Run();
+	static void Run(void *ctx);
+
+	/* virtual methods from class DeferredMonitor */
+	void RunDeferred() override;
+};
+
+#endif
@@ -189,9 +189,7 @@ handle_listall(Client &client, Request args, Response &r)
 	const auto uri = args.GetOptional(0, "");
 
 	Error error;
-	return db_selection_print(r, client.partition,
-				  DatabaseSelection(uri, true),
-				  false, false, error)
+	return db_print_tree(r, client.partition, uri, false, error)
 		? CommandResult::OK
 		: print_error(r, error);
 }
@@ -275,9 +273,7 @@ handle_listallinfo(Client &client, Request args, Response &r)
 	const auto uri = args.GetOptional(0, "");
 
 	Error error;
-	return db_selection_print(r, client.partition,
-				  DatabaseSelection(uri, true),
-				  true, false, error)
+	return db_print_tree(r, client.partition, uri, true, error)
 		? CommandResult::OK
 		: print_error(r, error);
 }
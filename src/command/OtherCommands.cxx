@@ -40,6 +40,7 @@
 #include "util/StringAPI.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "Stats.hxx"
+#include "PipelineStats.hxx"
 #include "Permission.hxx"
 #include "PlaylistFile.hxx"
 #include "db/PlaylistVector.hxx"
@@ -396,6 +397,28 @@ handle_stats(Client &client, gcc_unused Request args, Response &r)
 	return CommandResult::OK;
 }
 
+CommandResult
+handle_pipelinestats(Client &client, Request args, Response &r)
+{
+	if (!pipeline_stats_enabled) {
+		r.Error(ACK_ERROR_SYSTEM, "pipeline statistics are disabled");
+		return CommandResult::ERROR;
+	}
+
+	if (args.size == 1) {
+		if (!StringIsEqual(args.front(), "reset")) {
+			r.Error(ACK_ERROR_ARG, "\"reset\" expected");
+			return CommandResult::ERROR;
+		}
+
+		pipeline_stats_reset(client.partition);
+		return CommandResult::OK;
+	}
+
+	pipeline_stats_print(r, client.partition);
+	return CommandResult::OK;
+}
+
 CommandResult
 handle_ping(gcc_unused Client &client, gcc_unused Request args,
 	    gcc_unused Response &r)
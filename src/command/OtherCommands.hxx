@@ -62,6 +62,9 @@ handle_volume(Client &client, Request request, Response &response);
 CommandResult
 handle_stats(Client &client, Request request, Response &response);
 
+CommandResult
+handle_pipelinestats(Client &client, Request request, Response &response);
+
 CommandResult
 handle_ping(Client &client, Request request, Response &response);
 
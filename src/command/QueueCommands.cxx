@@ -244,9 +244,11 @@ handle_playlistinfo(Client &client, Request args, Response &r)
 {
 	RangeArg range = args.ParseOptional(0, RangeArg::All());
 
-	playlist_print_info(r, client.partition, client.playlist,
-			    range.start, range.end);
-	return CommandResult::OK;
+	ResponseGenerator *g =
+		playlist_print_info_generator(client.partition,
+					      client.playlist,
+					      range.start, range.end);
+	return client.RunResponseGenerator(g, r);
 }
 
 CommandResult
@@ -257,8 +259,12 @@ handle_playlistid(Client &client, Request args, Response &r)
 		playlist_print_id(r, client.partition,
 				  client.playlist, id);
 	} else {
-		playlist_print_info(r, client.partition, client.playlist,
-				    0, std::numeric_limits<unsigned>::max());
+		ResponseGenerator *g =
+			playlist_print_info_generator(client.partition,
+						      client.playlist,
+						      0,
+						      std::numeric_limits<unsigned>::max());
+		return client.RunResponseGenerator(g, r);
 	}
 
 	return CommandResult::OK;
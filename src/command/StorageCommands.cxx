@@ -31,6 +31,7 @@
 #include "client/Response.hxx"
 #include "Partition.hxx"
 #include "Instance.hxx"
+#include "client/ClientList.hxx"
 #include "storage/Registry.hxx"
 #include "storage/CompositeStorage.hxx"
 #include "storage/FileInfo.hxx"
@@ -281,6 +282,9 @@ handle_unmount(Client &client, Request args, Response &r)
 		   destroy here */
 		client.partition.instance.update->CancelMount(local_uri);
 
+	/* same for database queries running in the CommandThread */
+	client.partition.instance.client_list->GetCommandThread().WaitIdle();
+
 	Database *_db = client.partition.instance.database;
 	if (_db != nullptr && _db->IsPlugin(simple_db_plugin)) {
 		SimpleDatabase &db = *(SimpleDatabase *)_db;
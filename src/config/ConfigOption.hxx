@@ -39,6 +39,7 @@ enum class ConfigOption {
 	PID_FILE,
 	STATE_FILE,
 	STATE_FILE_INTERVAL,
+	STATE_FILE_FORMAT,
 	RESTORE_PAUSED,
 	USER,
 	GROUP,
@@ -58,7 +59,10 @@ enum class ConfigOption {
 	VOLUME_NORMALIZATION,
 	SAMPLERATE_CONVERTER,
 	AUDIO_BUFFER_SIZE,
+	AUDIO_CHUNK_SIZE,
 	BUFFER_BEFORE_PLAY,
+	LOCK_FREE_PIPE,
+	PIPELINE_STATS,
 	HTTP_PROXY_HOST,
 	HTTP_PROXY_PORT,
 	HTTP_PROXY_USER,
@@ -75,6 +79,7 @@ enum class ConfigOption {
 	GAPLESS_MP3_PLAYBACK,
 	AUTO_UPDATE,
 	AUTO_UPDATE_DEPTH,
+	UPDATE_THREADS,
 	DESPOTIFY_USER,
 	DESPOTIFY_PASSWORD,
 	DESPOTIFY_HIGH_BITRATE,
@@ -34,6 +34,7 @@ const ConfigTemplate config_param_templates[] = {
 	{ "pid_file" },
 	{ "state_file" },
 	{ "state_file_interval" },
+	{ "state_file_format" },
 	{ "restore_paused" },
 	{ "user" },
 	{ "group" },
@@ -53,7 +54,10 @@ const ConfigTemplate config_param_templates[] = {
 	{ "volume_normalization" },
 	{ "samplerate_converter" },
 	{ "audio_buffer_size" },
+	{ "audio_chunk_size" },
 	{ "buffer_before_play" },
+	{ "lock_free_pipe" },
+	{ "pipeline_stats" },
 	{ "http_proxy_host", false, true },
 	{ "http_proxy_port", false, true },
 	{ "http_proxy_user", false, true },
@@ -70,6 +74,7 @@ const ConfigTemplate config_param_templates[] = {
 	{ "gapless_mp3_playback" },
 	{ "auto_update" },
 	{ "auto_update_depth" },
+	{ "update_threads" },
 	{ "despotify_user", false, true },
 	{ "despotify_password", false, true },
 	{ "despotify_high_bitrate", false, true },
@@ -21,22 +21,16 @@
 #include "Count.hxx"
 #include "Selection.hxx"
 #include "Interface.hxx"
+#include "Stats.hxx"
 #include "Partition.hxx"
 #include "client/Response.hxx"
 #include "LightSong.hxx"
 #include "tag/Tag.hxx"
+#include "util/Error.hxx"
 
 #include <functional>
 #include <map>
 
-struct SearchStats {
-	unsigned n_songs;
-	std::chrono::duration<std::uint64_t, SongTime::period> total_duration;
-
-	constexpr SearchStats()
-		:n_songs(0), total_duration(0) {}
-};
-
 class TagCountMap : public std::map<std::string, SearchStats> {
 };
 
@@ -107,6 +101,14 @@ GroupCountVisitor(TagCountMap &map, TagType group, const LightSong &song)
 	return true;
 }
 
+static void
+MergeGroupStats(TagCountMap &map, const char *value, const SearchStats &src)
+{
+	SearchStats &dest = map[value];
+	dest.n_songs += src.n_songs;
+	dest.total_duration += src.total_duration;
+}
+
 bool
 PrintSongCount(Response &r, const Partition &partition, const char *name,
 	       const SongFilter *filter,
@@ -138,10 +140,21 @@ PrintSongCount(Response &r, const Partition &partition, const char *name,
 		TagCountMap map;
 
 		using namespace std::placeholders;
-		const auto f = std::bind(GroupCountVisitor, std::ref(map),
-					 group, _1);
-		if (!db->Visit(selection, f, error))
-			return false;
+		if (!db->GetGroupStats(selection, group,
+				       std::bind(MergeGroupStats,
+						 std::ref(map), _1, _2),
+				       error)) {
+			if (error.IsDefined())
+				return false;
+
+			/* not implemented by the plugin: visit all
+			   songs */
+			const auto f = std::bind(GroupCountVisitor,
+						 std::ref(map),
+						 group, _1);
+			if (!db->Visit(selection, f, error))
+				return false;
+		}
 
 		Print(r, group, map);
 	}
@@ -27,34 +27,60 @@
 #define MPD_DB_LOCK_HXX
 
 #include "check.h"
-#include "thread/Mutex.hxx"
+#include "thread/SharedMutex.hxx"
 #include "Compiler.h"
 
 #include <assert.h>
 
-extern Mutex db_mutex;
+/**
+ * The global database lock.  Threads which only read the tree (most
+ * importantly, the main thread executing client queries) lock it in
+ * "shared" mode, which allows them to run concurrently with each
+ * other and with read-only phases of the update thread.  Modifying
+ * the tree requires an exclusive lock.
+ */
+extern SharedMutex db_mutex;
 
 #ifndef NDEBUG
 
 #include "thread/Id.hxx"
 
+/**
+ * The thread which holds the exclusive database lock.
+ */
 extern ThreadId db_mutex_holder;
 
 /**
- * Does the current thread hold the database lock?
+ * Does the current thread hold the database lock in "shared" mode?
+ */
+extern thread_local bool db_mutex_shared;
+
+/**
+ * Does the current thread hold the exclusive database lock?
  */
 gcc_pure
 static inline bool
-holding_db_lock(void)
+holding_db_write_lock(void)
 {
 	return db_mutex_holder.IsInside();
 }
 
+/**
+ * Does the current thread hold the database lock (exclusive or
+ * shared)?
+ */
+gcc_pure
+static inline bool
+holding_db_lock(void)
+{
+	return holding_db_write_lock() || db_mutex_shared;
+}
+
 #endif
 
 /**
- * Obtain the global database lock.  This is needed before
- * dereferencing a #song or #directory.  It is not recursive.
+ * Obtain the global database lock in exclusive mode.  This is needed
+ * before modifying a #song or #directory.  It is not recursive.
  */
 static inline void
 db_lock(void)
@@ -70,12 +96,12 @@ db_lock(void)
 }
 
 /**
- * Release the global database lock.
+ * Release the exclusive global database lock.
  */
 static inline void
 db_unlock(void)
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 #ifndef NDEBUG
 	db_mutex_holder = ThreadId::Null();
 #endif
@@ -83,6 +109,36 @@ db_unlock(void)
 	db_mutex.unlock();
 }
 
+/**
+ * Obtain the global database lock in shared mode.  This is needed
+ * before dereferencing a #song or #directory.  It is not recursive.
+ */
+static inline void
+db_lock_shared(void)
+{
+	assert(!holding_db_lock());
+
+	db_mutex.lock_shared();
+
+#ifndef NDEBUG
+	db_mutex_shared = true;
+#endif
+}
+
+/**
+ * Release the shared global database lock.
+ */
+static inline void
+db_unlock_shared(void)
+{
+	assert(db_mutex_shared);
+#ifndef NDEBUG
+	db_mutex_shared = false;
+#endif
+
+	db_mutex.unlock_shared();
+}
+
 class ScopeDatabaseLock {
 	bool locked = true;
 
@@ -107,6 +163,34 @@ public:
 	}
 };
 
+/**
+ * Like #ScopeDatabaseLock, but obtain the lock in shared mode, for
+ * code which does not modify the tree.
+ */
+class ScopeDatabaseSharedLock {
+	bool locked = true;
+
+public:
+	ScopeDatabaseSharedLock() {
+		db_lock_shared();
+	}
+
+	~ScopeDatabaseSharedLock() {
+		if (locked)
+			db_unlock_shared();
+	}
+
+	/**
+	 * Unlock the mutex now, making the destructor a no-op.
+	 */
+	void unlock() {
+		assert(locked);
+
+		db_unlock_shared();
+		locked = false;
+	}
+};
+
 /**
  * Unlock the database while in the current scope.
  */
@@ -121,4 +205,18 @@ public:
 	}
 };
 
+/**
+ * Release the shared database lock while in the current scope.
+ */
+class ScopeDatabaseSharedUnlock {
+public:
+	ScopeDatabaseSharedUnlock() {
+		db_unlock_shared();
+	}
+
+	~ScopeDatabaseSharedUnlock() {
+		db_lock_shared();
+	}
+};
+
 #endif
@@ -39,6 +39,13 @@ struct DatabasePlugin {
 	 */
 	static constexpr unsigned FLAG_REQUIRE_STORAGE = 0x1;
 
+	/**
+	 * Database::Visit(), Database::VisitUniqueTags() and
+	 * Database::GetStats() may be called from another thread,
+	 * concurrently with the main thread.
+	 */
+	static constexpr unsigned FLAG_CONCURRENT_VISIT = 0x2;
+
 	const char *name;
 
 	unsigned flags;
@@ -30,9 +30,15 @@
 #include "LightDirectory.hxx"
 #include "PlaylistInfo.hxx"
 #include "Interface.hxx"
+#include "DatabaseError.hxx"
 #include "fs/Traits.hxx"
+#include "util/Error.hxx"
 
 #include <functional>
+#include <string>
+#include <vector>
+
+#include <string.h>
 
 static const char *
 ApplyBaseFlag(const char *uri, bool base)
@@ -196,6 +202,146 @@ db_selection_print(Response &r, Partition &partition,
 				  error);
 }
 
+namespace {
+
+/**
+ * A directory whose contents have not been printed yet, see
+ * db_print_tree().
+ */
+struct PendingDirectory {
+	std::string uri;
+	time_t mtime;
+
+	explicit PendingDirectory(const LightDirectory &directory)
+		:uri(directory.GetPath()), mtime(directory.mtime) {}
+
+	LightDirectory Export() const {
+		return LightDirectory(uri.c_str(), mtime);
+	}
+};
+
+}
+
+static bool
+CollectDirectory(std::vector<PendingDirectory> &list,
+		 const LightDirectory &directory)
+{
+	list.emplace_back(directory);
+	return true;
+}
+
+/**
+ * Look up the specified directory in its parent.
+ *
+ * @return false if the URI does not refer to a directory
+ */
+static bool
+FindDirectory(const Database &db, const char *uri,
+	      std::vector<PendingDirectory> &result)
+{
+	const char *slash = strrchr(uri, '/');
+	const std::string parent = slash != nullptr
+		? std::string(uri, slash)
+		: std::string();
+
+	std::vector<PendingDirectory> children;
+
+	using namespace std::placeholders;
+	try {
+		if (!db.Visit(DatabaseSelection(parent.c_str(), false),
+			      std::bind(CollectDirectory, std::ref(children),
+					_1),
+			      VisitSong(), VisitPlaylist(), IgnoreError()))
+			return false;
+	} catch (const DatabaseError &) {
+		return false;
+	}
+
+	for (auto &i : children) {
+		if (i.uri == uri) {
+			result.emplace_back(std::move(i));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool
+db_print_tree(Response &r, Partition &partition, const char *uri,
+	      bool full, Error &error)
+{
+	const Database *db = partition.GetDatabase(error);
+	if (db == nullptr)
+		return false;
+
+	/* the directories which are yet to be printed, in reverse
+	   order */
+	std::vector<PendingDirectory> stack;
+
+	if (!r.IsStream())
+		/* visiting each directory separately is only useful
+		   if the response can be sent while it is being
+		   generated; with the proxy plugin, it would be much
+		   slower */
+		return db_selection_print(r, partition,
+					  DatabaseSelection(uri, true),
+					  full, false, error);
+
+	if (*uri == 0)
+		stack.emplace_back(LightDirectory::Root());
+	else if (!FindDirectory(*db, uri, stack))
+		/* a song, or an error: no need for the incremental
+		   code */
+		return db_selection_print(r, partition,
+					  DatabaseSelection(uri, true),
+					  full, false, error);
+
+	using namespace std::placeholders;
+	const auto d = full ? PrintDirectoryFull : PrintDirectoryBrief;
+	const auto s = std::bind(full ? PrintSongFull : PrintSongBrief,
+				 std::ref(r), std::ref(partition), false, _1);
+	const auto p = std::bind(full ? PrintPlaylistFull : PrintPlaylistBrief,
+				 std::ref(r), false, _1, _2);
+
+	std::vector<PendingDirectory> children;
+
+	while (!stack.empty()) {
+		const PendingDirectory directory(std::move(stack.back()));
+		stack.pop_back();
+
+		d(r, false, directory.Export());
+
+		children.clear();
+
+		try {
+			if (!db->Visit(DatabaseSelection(directory.uri.c_str(),
+							 false),
+				       std::bind(CollectDirectory,
+						 std::ref(children), _1),
+				       s, p, error))
+				return false;
+		} catch (const DatabaseError &e) {
+			if (e.GetCode() != DatabaseErrorCode::NOT_FOUND)
+				throw;
+
+			/* the directory has been deleted meanwhile */
+			continue;
+		}
+
+		stack.insert(stack.end(),
+			     std::make_move_iterator(children.rbegin()),
+			     std::make_move_iterator(children.rend()));
+
+		/* the database is not locked here; send what we have
+		   so far */
+		if (!r.Flush())
+			break;
+	}
+
+	return true;
+}
+
 static bool
 PrintSongURIVisitor(Response &r, Partition &partition, const LightSong &song)
 {
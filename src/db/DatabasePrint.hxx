@@ -44,6 +44,19 @@ db_selection_print(Response &r, Partition &partition,
 		   unsigned window_start, unsigned window_end,
 		   Error &error);
 
+/**
+ * Print the specified directory recursively, like
+ * db_selection_print() with a recursive #DatabaseSelection.  The
+ * directories are visited one at a time, and Response::Flush() is
+ * called in between, which allows sending a huge listing while it
+ * is being generated (if Response::IsStream() is true).
+ *
+ * @param full print attributes/tags
+ */
+bool
+db_print_tree(Response &r, Partition &partition, const char *uri,
+	      bool full, Error &error);
+
 bool
 PrintUniqueTags(Response &r, Partition &partition,
 		unsigned type, tag_mask_t group_mask,
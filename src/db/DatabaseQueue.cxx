@@ -25,17 +25,40 @@
 #include "Instance.hxx"
 #include "DetachedSong.hxx"
 
-#include <functional>
+#include <vector>
 
-static bool
-AddToQueue(Partition &partition, const LightSong &song)
-{
-	const Storage &storage = *partition.instance.storage;
-	partition.playlist.AppendSong(partition.pc,
-				      DatabaseDetachSong(storage,
-							 song));
-	return true;
-}
+/**
+ * Collects songs from the database and appends them to the queue in
+ * batches, see playlist::AppendSongs().
+ */
+class DatabaseQueueAdder {
+	static constexpr size_t BATCH_SIZE = 4096;
+
+	Partition &partition;
+	const Storage &storage;
+
+	std::vector<DetachedSong> songs;
+
+public:
+	explicit DatabaseQueueAdder(Partition &_partition)
+		:partition(_partition),
+		 storage(*partition.instance.storage) {
+		songs.reserve(BATCH_SIZE);
+	}
+
+	bool Add(const LightSong &song) {
+		songs.emplace_back(DatabaseDetachSong(storage, song));
+		if (songs.size() >= BATCH_SIZE)
+			Flush();
+		return true;
+	}
+
+	void Flush() {
+		partition.playlist.AppendSongs(partition.pc,
+					       std::move(songs));
+		songs.clear();
+	}
+};
 
 bool
 AddFromDatabase(Partition &partition, const DatabaseSelection &selection,
@@ -45,7 +68,15 @@ AddFromDatabase(Partition &partition, const DatabaseSelection &selection,
 	if (db == nullptr)
 		return false;
 
-	using namespace std::placeholders;
-	const auto f = std::bind(AddToQueue, std::ref(partition), _1);
-	return db->Visit(selection, f, error);
+	DatabaseQueueAdder adder(partition);
+	const auto f = [&adder](const LightSong &song, Error &){
+		return adder.Add(song);
+	};
+
+	bool success = db->Visit(selection, f, error);
+
+	/* append the remaining songs after the database has been
+	   unlocked */
+	adder.Flush();
+	return success;
 }
@@ -23,6 +23,8 @@
 #include "Interface.hxx"
 #include "DetachedSong.hxx"
 #include "storage/StorageInterface.hxx"
+#include "fs/AllocatedPath.hxx"
+#include "util/UriUtil.hxx"
 
 #include <assert.h>
 
@@ -32,10 +34,18 @@ DatabaseDetachSong(const Storage &storage, const LightSong &song)
 	DetachedSong detached(song);
 	assert(detached.IsInDatabase());
 
-	if (!detached.HasRealURI()) {
-		const auto uri = song.GetURI();
-		detached.SetRealURI(storage.MapUTF8(uri.c_str()));
-	}
+	/* don't store the URI mapped by the storage (see
+	   map_song_real_uri()), only whether it refers to a remote
+	   resource */
+	if (!detached.HasRealURI() &&
+	    uri_has_scheme(storage.MapUTF8(detached.GetURI()).c_str()))
+		detached.SetRemoteStorage();
+
+	if (song.partial_tag)
+		/* the database keeps only some of the tags in memory;
+		   the decoder loads the rest when the song is played,
+		   see DetachedSong::CompleteTag() */
+		detached.SetPartialTag();
 
 	return detached;
 }
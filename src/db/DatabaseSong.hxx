@@ -30,6 +30,11 @@ class DetachedSong;
 /**
  * "Detach" the #Song object, i.e. convert it to a #DetachedSong
  * instance.
+ *
+ * The "real" URI is not copied unless the database provides one;
+ * it is obtained from the storage when it is needed, see
+ * map_song_real_uri().  The storage only decides whether the song
+ * is remote (DetachedSong::IsRemote()).
  */
 gcc_pure
 DetachedSong
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "Interface.hxx"
+#include "util/ScopeExit.hxx"
+
+#include <stdexcept>
+
+void
+Database::LookupSongs(ConstBuffer<const char *> uris,
+		      VisitIndexedSong visit) const
+{
+	for (size_t i = 0; i < uris.size; ++i) {
+		const LightSong *song;
+		try {
+			song = GetSong(uris[i]);
+		} catch (const std::runtime_error &) {
+			continue;
+		}
+
+		if (song == nullptr)
+			continue;
+
+		AtScopeExit(this, song) { ReturnSong(song); };
+		visit(i, *song);
+	}
+}
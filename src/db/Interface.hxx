@@ -23,6 +23,7 @@
 #include "Visitor.hxx"
 #include "tag/TagType.h"
 #include "tag/Mask.hxx"
+#include "util/ConstBuffer.hxx"
 #include "Compiler.h"
 
 #include <time.h>
@@ -81,6 +82,18 @@ public:
 	 */
 	virtual void ReturnSong(const LightSong *song) const = 0;
 
+	/**
+	 * Look up many songs at once, e.g. to restore a saved queue.
+	 * The visitor is invoked (in no particular order) for each
+	 * URI which refers to a song, with the index of that URI and
+	 * the song object, which is only valid during the call.  URIs
+	 * which are not found are skipped.
+	 *
+	 * The default implementation calls GetSong() for each URI.
+	 */
+	virtual void LookupSongs(ConstBuffer<const char *> uris,
+				 VisitIndexedSong visit) const;
+
 	/**
 	 * Visit the selected entities.
 	 */
@@ -115,6 +128,26 @@ public:
 			      DatabaseStats &stats,
 			      Error &error) const = 0;
 
+	/**
+	 * Obtain the number of songs and their total duration for
+	 * each value of the given tag (command "count group").  Songs
+	 * without "AlbumArtist" are counted with their "Artist"
+	 * values instead.  The values are visited in no particular
+	 * order.
+	 *
+	 * This is an optional shortcut for plugins which can answer
+	 * it without visiting all songs.  Returns false on error
+	 * (with #Error set) and false if not implemented for this
+	 * selection (#Error not set); the caller shall then fall back
+	 * to Visit().
+	 */
+	virtual bool GetGroupStats(gcc_unused const DatabaseSelection &selection,
+				   gcc_unused TagType group,
+				   gcc_unused VisitGroupStats visit,
+				   gcc_unused Error &error) const {
+		return false;
+	}
+
 	/**
 	 * Update the database.  Returns the job id on success, 0 on
 	 * error (with #Error set) and 0 if not implemented (#Error
@@ -62,6 +62,14 @@ struct LightSong {
 	 */
 	const Tag *tag;
 
+	/**
+	 * If true, then #tag contains only some of the song's tags
+	 * (see the "resident_tags" setting of the simple database
+	 * plugin), and the complete tag has to be loaded from the
+	 * file when the song is detached from the database.
+	 */
+	bool partial_tag;
+
 	time_t mtime;
 
 	/**
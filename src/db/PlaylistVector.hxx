@@ -41,14 +41,14 @@ public:
 	using std::list<PlaylistInfo>::erase;
 
 	/**
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 *
 	 * @return true if the vector or one of its items was modified
 	 */
 	bool UpdateOrInsert(PlaylistInfo &&pi);
 
 	/**
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 */
 	bool erase(const char *name);
 };
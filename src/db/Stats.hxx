@@ -22,6 +22,18 @@
 
 #include "Chrono.hxx"
 
+/**
+ * The number of songs and their total duration, e.g. for one value of
+ * a tag (see command "count").
+ */
+struct SearchStats {
+	unsigned n_songs;
+	std::chrono::duration<std::uint64_t, SongTime::period> total_duration;
+
+	constexpr SearchStats()
+		:n_songs(0), total_duration(0) {}
+};
+
 struct DatabaseStats {
 	/**
 	 * Number of songs.
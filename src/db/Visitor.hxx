@@ -22,10 +22,13 @@
 
 #include <functional>
 
+#include <stddef.h>
+
 struct LightDirectory;
 struct LightSong;
 struct PlaylistInfo;
 struct Tag;
+struct SearchStats;
 class Error;
 
 typedef std::function<bool(const LightDirectory &, Error &)> VisitDirectory;
@@ -35,4 +38,13 @@ typedef std::function<bool(const PlaylistInfo &, const LightDirectory &,
 
 typedef std::function<bool(const Tag &, Error &)> VisitTag;
 
+/**
+ * Callback for Database::LookupSongs(); the first parameter is the
+ * index of the URI which was found.
+ */
+typedef std::function<void(size_t, const LightSong &)> VisitIndexedSong;
+
+typedef std::function<void(const char *value,
+			   const SearchStats &stats)> VisitGroupStats;
+
 #endif
@@ -206,6 +206,7 @@ ProxySong::ProxySong(const mpd_song *song)
 	uri = mpd_song_get_uri(song);
 	real_uri = nullptr;
 	tag = &tag2;
+	partial_tag = false;
 	mtime = mpd_song_get_last_modified(song);
 
 #if LIBMPDCLIENT_CHECK_VERSION(2,3,0)
@@ -0,0 +1,658 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "BinaryDatabase.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/DatabaseError.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/FileReader.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Charset.hxx"
+#include "tag/Tag.hxx"
+#include "tag/TagItem.hxx"
+#include "tag/TagPool.hxx"
+#include "tag/Settings.hxx"
+#include "util/StringView.hxx"
+#include "util/Error.hxx"
+#include "Log.hxx"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef WIN32
+#include <memory>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * File layout: #BinaryHeader, followed by the arrays of
+ * #BinaryItem, item references (uint32_t indexes into the item
+ * array), #BinaryDirectory, #BinarySong, #BinaryPlaylist, each padded
+ * to a multiple of 8 bytes, followed by the string table.  Strings
+ * are referred to by their byte offset in the string table.
+ *
+ * Directories are stored in pre-order, i.e. each parent precedes its
+ * children, and the root directory comes first.  Songs and playlists
+ * are stored in the order of their directories.
+ *
+ * All numbers are in host byte order; a database file written on a
+ * machine with a different byte order is discarded.
+ */
+
+static constexpr char BINARY_DB_MAGIC[8] = {
+	'\x89', 'M', 'P', 'D', 'D', 'B', '\r', '\n',
+};
+
+static constexpr uint32_t BINARY_DB_FORMAT = 1;
+
+static constexpr uint32_t BINARY_DB_BYTE_ORDER = 0x01020304;
+
+struct BinaryHeader {
+	char magic[sizeof(BINARY_DB_MAGIC)];
+
+	uint32_t format, byte_order;
+
+	/**
+	 * A bit mask of the tag types which were enabled when the
+	 * database was written.
+	 */
+	uint64_t tag_mask;
+
+	uint32_t fs_charset;
+
+	uint32_t n_items, n_item_refs, n_directories, n_songs, n_playlists;
+
+	uint32_t string_size;
+
+	uint32_t reserved;
+};
+
+struct BinaryItem {
+	uint32_t value, type;
+};
+
+struct BinaryDirectory {
+	int64_t mtime;
+	uint32_t name, parent, device;
+	uint32_t n_songs, n_playlists;
+	uint32_t reserved;
+};
+
+struct BinarySong {
+	int64_t mtime;
+	uint32_t uri;
+	uint32_t start_ms, end_ms;
+
+	/**
+	 * The duration in milliseconds; negative if unknown.
+	 */
+	int32_t duration_ms;
+
+	uint32_t first_item;
+	uint16_t n_items;
+	uint8_t has_playlist;
+	uint8_t reserved;
+};
+
+struct BinaryPlaylist {
+	int64_t mtime;
+	uint32_t name, reserved;
+};
+
+static_assert(sizeof(BinaryHeader) % 8 == 0, "Wrong header size");
+static_assert(sizeof(BinaryDirectory) % 8 == 0, "Wrong record size");
+static_assert(sizeof(BinarySong) % 8 == 0, "Wrong record size");
+static_assert(sizeof(BinaryPlaylist) % 8 == 0, "Wrong record size");
+
+static constexpr uint64_t
+AlignSection(uint64_t size)
+{
+	return (size + 7) & ~uint64_t(7);
+}
+
+namespace {
+
+class BinaryDatabaseWriter {
+	std::vector<char> strings;
+	std::unordered_map<std::string, uint32_t> string_map;
+
+	std::vector<BinaryItem> items;
+
+	/**
+	 * Maps type and string offset to the index in #items.
+	 */
+	std::unordered_map<uint64_t, uint32_t> item_map;
+
+	std::vector<uint32_t> item_refs;
+	std::vector<BinaryDirectory> directories;
+	std::vector<BinarySong> songs;
+	std::vector<BinaryPlaylist> playlists;
+
+public:
+	BinaryDatabaseWriter() {
+		/* offset 0 is the empty string */
+		strings.push_back(0);
+		string_map.emplace(std::string(), 0);
+	}
+
+	void AddDirectory(const Directory &directory, uint32_t parent);
+
+	void Write(BufferedOutputStream &os, tag_mask_t tag_mask) const;
+
+private:
+	uint32_t AddString(const char *s);
+	uint32_t AddItem(const TagItem &item);
+	void AddSong(const Song &song);
+};
+
+}
+
+uint32_t
+BinaryDatabaseWriter::AddString(const char *s)
+{
+	auto i = string_map.emplace(s, strings.size());
+	if (i.second)
+		strings.insert(strings.end(), s, s + strlen(s) + 1);
+
+	return i.first->second;
+}
+
+uint32_t
+BinaryDatabaseWriter::AddItem(const TagItem &item)
+{
+	const uint32_t value = AddString(item.value);
+	const uint64_t key = (uint64_t(item.type) << 32) | value;
+
+	auto i = item_map.emplace(key, items.size());
+	if (i.second)
+		items.push_back({value, uint32_t(item.type)});
+
+	return i.first->second;
+}
+
+void
+BinaryDatabaseWriter::AddSong(const Song &song)
+{
+	BinarySong s;
+	memset(&s, 0, sizeof(s));
+	s.mtime = song.mtime;
+	s.uri = AddString(song.uri);
+	s.start_ms = song.start_time.ToMS();
+	s.end_ms = song.end_time.ToMS();
+	s.duration_ms = song.tag.duration.IsNegative()
+		? -1
+		: song.tag.duration.ToMS();
+	s.first_item = item_refs.size();
+	s.n_items = song.tag.num_items;
+	s.has_playlist = song.tag.has_playlist;
+
+	for (const auto &item : song.tag)
+		item_refs.push_back(AddItem(item));
+
+	songs.push_back(s);
+}
+
+void
+BinaryDatabaseWriter::AddDirectory(const Directory &directory,
+				   uint32_t parent)
+{
+	const uint32_t index = directories.size();
+
+	BinaryDirectory d;
+	memset(&d, 0, sizeof(d));
+	d.mtime = directory.mtime;
+	d.name = directory.IsRoot() ? 0 : AddString(directory.GetName());
+	d.parent = parent;
+	if (directory.device == DEVICE_INARCHIVE ||
+	    directory.device == DEVICE_CONTAINER)
+		d.device = directory.device;
+
+	for (const auto &song : directory.songs) {
+		AddSong(song);
+		++d.n_songs;
+	}
+
+	for (const auto &playlist : directory.playlists) {
+		BinaryPlaylist p;
+		memset(&p, 0, sizeof(p));
+		p.mtime = playlist.mtime;
+		p.name = AddString(playlist.name.c_str());
+		playlists.push_back(p);
+		++d.n_playlists;
+	}
+
+	directories.push_back(d);
+
+	for (const auto &child : directory.children)
+		/* mount points are not saved; they are restored from
+		   the state file */
+		if (!child.IsMount())
+			AddDirectory(child, index);
+}
+
+template<typename T>
+static void
+WriteSection(BufferedOutputStream &os, const T *data, size_t n)
+{
+	static constexpr uint8_t padding[8] = {};
+
+	const size_t size = n * sizeof(*data);
+	if (size > 0)
+		os.Write(data, size);
+
+	const size_t padded = AlignSection(size);
+	if (padded > size)
+		os.Write(padding, padded - size);
+}
+
+template<typename T>
+static void
+WriteSection(BufferedOutputStream &os, const std::vector<T> &v)
+{
+	WriteSection(os, v.data(), v.size());
+}
+
+void
+BinaryDatabaseWriter::Write(BufferedOutputStream &os,
+			    tag_mask_t tag_mask) const
+{
+	BinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BINARY_DB_MAGIC, sizeof(header.magic));
+	header.format = BINARY_DB_FORMAT;
+	header.byte_order = BINARY_DB_BYTE_ORDER;
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+		if (IsTagEnabled(i) && (tag_mask & (tag_mask_t(1) << i)) != 0)
+			header.tag_mask |= uint64_t(1) << i;
+
+	header.n_items = items.size();
+	header.n_item_refs = item_refs.size();
+	header.n_directories = directories.size();
+	header.n_songs = songs.size();
+	header.n_playlists = playlists.size();
+
+	/* the charset string is appended last, so this method can
+	   be const */
+	std::vector<char> s(strings);
+	header.fs_charset = s.size();
+	const char *charset = GetFSCharset();
+	s.insert(s.end(), charset, charset + strlen(charset) + 1);
+	header.string_size = s.size();
+
+	WriteSection(os, &header, 1);
+	WriteSection(os, items);
+	WriteSection(os, item_refs);
+	WriteSection(os, directories);
+	WriteSection(os, songs);
+	WriteSection(os, playlists);
+	WriteSection(os, s);
+}
+
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root,
+	       tag_mask_t tag_mask)
+{
+	assert(root.IsRoot());
+
+	BinaryDatabaseWriter writer;
+	writer.AddDirectory(root, 0);
+	writer.Write(os, tag_mask);
+}
+
+bool
+db_is_binary(Path path)
+{
+	try {
+		FileReader reader(path);
+
+		char magic[sizeof(BINARY_DB_MAGIC)];
+		return reader.Read(magic, sizeof(magic)) == sizeof(magic) &&
+			memcmp(magic, BINARY_DB_MAGIC, sizeof(magic)) == 0;
+	} catch (...) {
+		return false;
+	}
+}
+
+namespace {
+
+/**
+ * A read-only view of a whole file.  It is memory-mapped if
+ * possible, which avoids copying the file into the heap.
+ */
+class FileView {
+	const uint8_t *data = nullptr;
+	size_t size;
+
+#ifdef WIN32
+	std::unique_ptr<uint8_t[]> buffer;
+#endif
+
+public:
+	FileView() = default;
+	FileView(const FileView &) = delete;
+	FileView &operator=(const FileView &) = delete;
+
+#ifndef WIN32
+	~FileView() {
+		if (data != nullptr)
+			munmap(const_cast<uint8_t *>(data), size);
+	}
+#endif
+
+	bool Open(FileReader &reader, size_t _size, Error &error);
+
+	const uint8_t *GetData() const {
+		return data;
+	}
+};
+
+/**
+ * Holds a reference to each interned #TagItem; the songs obtain
+ * their own references with tag_pool_dup_item(), which is much
+ * cheaper than looking up the value again.
+ */
+class InternedItems {
+	std::vector<TagItem *> items;
+
+public:
+	~InternedItems() {
+		const ScopeLock protect(tag_pool_lock);
+		for (TagItem *item : items)
+			tag_pool_put_item(item);
+	}
+
+	void Intern(const BinaryItem *src, size_t n, const char *strings) {
+		items.reserve(n);
+
+		const ScopeLock protect(tag_pool_lock);
+		for (size_t i = 0; i < n; ++i)
+			items.push_back(tag_pool_get_item(TagType(src[i].type),
+							  strings + src[i].value));
+	}
+
+	TagItem *operator[](size_t i) const {
+		return items[i];
+	}
+};
+
+}
+
+bool
+FileView::Open(FileReader &reader, size_t _size, Error &error)
+{
+	size = _size;
+
+#ifdef WIN32
+	buffer.reset(new uint8_t[size]);
+
+	size_t position = 0;
+	while (position < size) {
+		size_t nbytes = reader.Read(buffer.get() + position,
+					    size - position);
+		if (nbytes == 0) {
+			error.Set(db_domain, "Unexpected end of file");
+			return false;
+		}
+
+		position += nbytes;
+	}
+
+	data = buffer.get();
+#else
+	void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+		       reader.GetFD().Get(), 0);
+	if (p == MAP_FAILED) {
+		error.SetErrno("Failed to map the database file");
+		return false;
+	}
+
+	data = (const uint8_t *)p;
+#endif
+
+	return true;
+}
+
+static bool
+CheckString(uint32_t offset, uint32_t string_size, bool allow_empty,
+	    const char *strings)
+{
+	return offset < string_size &&
+		(allow_empty || strings[offset] != 0);
+}
+
+bool
+db_load_binary(Path path, Directory &root, tag_mask_t tag_mask,
+	       Error &error)
+{
+	assert(root.IsRoot());
+
+	FileReader reader(path);
+
+	const uint64_t file_size = reader.GetFileInfo().GetSize();
+	if (file_size < sizeof(BinaryHeader) || file_size != size_t(file_size)) {
+		error.Set(db_domain, "Database corrupted");
+		return false;
+	}
+
+	FileView view;
+	if (!view.Open(reader, file_size, error))
+		return false;
+
+	reader.Close();
+
+	const uint8_t *const base = view.GetData();
+	const BinaryHeader &header = *(const BinaryHeader *)base;
+
+	if (memcmp(header.magic, BINARY_DB_MAGIC, sizeof(header.magic)) != 0 ||
+	    header.format != BINARY_DB_FORMAT) {
+		error.Set(db_domain,
+			  "Database format mismatch, "
+			  "discarding database file");
+		return false;
+	}
+
+	if (header.byte_order != BINARY_DB_BYTE_ORDER) {
+		error.Set(db_domain,
+			  "Database byte order mismatch, "
+			  "discarding database file");
+		return false;
+	}
+
+	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i) {
+		if (IsTagEnabled(i) && (tag_mask & (tag_mask_t(1) << i)) != 0 &&
+		    (header.tag_mask & (uint64_t(1) << i)) == 0) {
+			error.Set(db_domain,
+				  "Tag list mismatch, "
+				  "discarding database file");
+			return false;
+		}
+	}
+
+	/* locate the sections and verify that they fit into the
+	   file */
+
+	uint64_t offset = sizeof(header);
+
+	const auto *items = (const BinaryItem *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_items) * sizeof(*items));
+
+	const auto *item_refs = (const uint32_t *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_item_refs) * sizeof(*item_refs));
+
+	const auto *directories = (const BinaryDirectory *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_directories) * sizeof(*directories));
+
+	const auto *songs = (const BinarySong *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_songs) * sizeof(*songs));
+
+	const auto *playlists = (const BinaryPlaylist *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_playlists) * sizeof(*playlists));
+
+	const char *strings = (const char *)(base + offset);
+	offset += header.string_size;
+
+	if (offset > file_size || header.string_size == 0 ||
+	    strings[header.string_size - 1] != 0 ||
+	    header.n_directories == 0 ||
+	    !CheckString(header.fs_charset, header.string_size, true,
+			 strings)) {
+		error.Set(db_domain, "Database corrupted");
+		return false;
+	}
+
+	const char *new_charset = strings + header.fs_charset;
+	const char *const old_charset = GetFSCharset();
+	if (*old_charset != 0 && strcmp(new_charset, old_charset) != 0) {
+		error.Format(db_domain,
+			     "Existing database has charset "
+			     "\"%s\" instead of \"%s\"; "
+			     "discarding database file",
+			     new_charset, old_charset);
+		return false;
+	}
+
+	/* validate all references before modifying anything */
+
+	for (size_t i = 0; i < header.n_items; ++i) {
+		if (items[i].type >= TAG_NUM_OF_ITEM_TYPES ||
+		    !CheckString(items[i].value, header.string_size, true,
+				 strings)) {
+			error.Set(db_domain, "Database corrupted");
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < header.n_item_refs; ++i) {
+		if (item_refs[i] >= header.n_items) {
+			error.Set(db_domain, "Database corrupted");
+			return false;
+		}
+	}
+
+	uint64_t total_songs = 0, total_playlists = 0;
+	for (size_t i = 0; i < header.n_directories; ++i) {
+		const auto &d = directories[i];
+		if (i > 0 && (d.parent >= i ||
+			      !CheckString(d.name, header.string_size,
+					   false, strings) ||
+			      strchr(strings + d.name, '/') != nullptr)) {
+			error.Set(db_domain, "Database corrupted");
+			return false;
+		}
+
+		total_songs += d.n_songs;
+		total_playlists += d.n_playlists;
+	}
+
+	if (total_songs != header.n_songs ||
+	    total_playlists != header.n_playlists) {
+		error.Set(db_domain, "Database corrupted");
+		return false;
+	}
+
+	for (size_t i = 0; i < header.n_songs; ++i) {
+		const auto &s = songs[i];
+		if (!CheckString(s.uri, header.string_size, false, strings) ||
+		    uint64_t(s.first_item) + s.n_items > header.n_item_refs) {
+			error.Set(db_domain, "Database corrupted");
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < header.n_playlists; ++i) {
+		if (!CheckString(playlists[i].name, header.string_size, false,
+				 strings)) {
+			error.Set(db_domain, "Database corrupted");
+			return false;
+		}
+	}
+
+	LogDebug(db_domain, "reading binary DB");
+
+	InternedItems interned;
+	interned.Intern(items, header.n_items, strings);
+
+	const ScopeDatabaseLock protect;
+
+	std::vector<Directory *> directory_pointers;
+	directory_pointers.reserve(header.n_directories);
+	directory_pointers.push_back(&root);
+
+	const BinarySong *s = songs;
+	const BinaryPlaylist *p = playlists;
+
+	for (size_t i = 0; i < header.n_directories; ++i) {
+		const auto &d = directories[i];
+
+		Directory *directory;
+		if (i == 0)
+			directory = &root;
+		else {
+			directory = directory_pointers[d.parent]
+				->CreateChild(strings + d.name);
+			directory->mtime = d.mtime;
+			directory->device = d.device;
+			directory_pointers.push_back(directory);
+		}
+
+		for (const auto *end = s + d.n_songs; s != end; ++s) {
+			Song *song = Song::NewFile(strings + s->uri,
+						   *directory);
+			song->mtime = s->mtime;
+			song->start_time = SongTime::FromMS(s->start_ms);
+			song->end_time = SongTime::FromMS(s->end_ms);
+
+			Tag &tag = song->tag;
+			tag.duration = s->duration_ms < 0
+				? SignedSongTime::Negative()
+				: SignedSongTime::FromMS(s->duration_ms);
+			tag.has_playlist = s->has_playlist;
+
+			if (s->n_items > 0) {
+				tag.num_items = s->n_items;
+				tag.items = Tag::AllocateItems(s->n_items);
+
+				const uint32_t *refs = item_refs + s->first_item;
+
+				const ScopeLock protect_pool(tag_pool_lock);
+				for (unsigned j = 0; j < s->n_items; ++j)
+					tag.items[j] =
+						tag_pool_dup_item(interned[refs[j]]);
+			}
+
+			directory->AddSong(song);
+		}
+
+		for (const auto *end = p + d.n_playlists; p != end; ++p)
+			directory->playlists.push_back(PlaylistInfo(strings + p->name,
+								    p->mtime));
+	}
+
+	return true;
+}
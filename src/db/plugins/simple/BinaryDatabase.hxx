@@ -0,0 +1,61 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/** \file
+ *
+ * A binary alternative to the text database format implemented by
+ * DatabaseSave.cxx.  The file consists of a header followed by
+ * arrays of fixed-size records and a string table; it is memory
+ * mapped while loading, and each distinct tag value is interned
+ * only once.
+ */
+
+#ifndef MPD_DB_SIMPLE_BINARY_DATABASE_HXX
+#define MPD_DB_SIMPLE_BINARY_DATABASE_HXX
+
+#include "tag/Mask.hxx"
+
+struct Directory;
+class BufferedOutputStream;
+class Path;
+class Error;
+
+/**
+ * @param tag_mask the tag types which are stored in the file
+ */
+void
+db_save_binary(BufferedOutputStream &os, const Directory &root,
+	       tag_mask_t tag_mask);
+
+/**
+ * Does the specified file contain a binary database?  Returns false
+ * if the file cannot be read.
+ */
+bool
+db_is_binary(Path path);
+
+/**
+ * @param tag_mask the tag types which must be stored in the file;
+ * the file is rejected if one of them is missing
+ */
+bool
+db_load_binary(Path path, Directory &root, tag_mask_t tag_mask,
+	       Error &error);
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "DatabaseJournal.hxx"
+#include "DirectorySave.hxx"
+#include "Directory.hxx"
+#include "db/DatabaseLock.hxx"
+#include "db/DatabaseError.hxx"
+#include "fs/io/BufferedOutputStream.hxx"
+#include "fs/io/TextFile.hxx"
+#include "fs/Charset.hxx"
+#include "util/StringCompare.hxx"
+#include "util/Error.hxx"
+
+#include <string.h>
+#include <stdlib.h>
+
+#define JOURNAL_FORMAT_PREFIX "journal_format: "
+#define JOURNAL_FS_CHARSET "fs_charset: "
+
+static constexpr unsigned JOURNAL_FORMAT = 1;
+
+static void
+db_journal_save_directory(BufferedOutputStream &os,
+			  const Directory &directory)
+{
+	/* pre-order: a directory's record must precede the records
+	   of its children, because it may delete them */
+	if (directory.dirty)
+		directory_save_shallow(os, directory);
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			db_journal_save_directory(os, child);
+}
+
+void
+db_journal_save(BufferedOutputStream &os, const Directory &root,
+		bool header)
+{
+	if (header) {
+		os.Format(JOURNAL_FORMAT_PREFIX "%u\n", JOURNAL_FORMAT);
+		os.Format(JOURNAL_FS_CHARSET "%s\n", GetFSCharset());
+	}
+
+	db_journal_save_directory(os, root);
+}
+
+bool
+db_journal_load(TextFile &file, Directory &root, Error &error)
+{
+	const char *line = file.ReadLine();
+	const char *p;
+	if (line == nullptr ||
+	    (p = StringAfterPrefix(line, JOURNAL_FORMAT_PREFIX)) == nullptr) {
+		error.Set(db_domain, "Journal corrupted");
+		return false;
+	}
+
+	if (unsigned(atoi(p)) != JOURNAL_FORMAT) {
+		error.Set(db_domain, "Journal format mismatch");
+		return false;
+	}
+
+	line = file.ReadLine();
+	if (line == nullptr ||
+	    (p = StringAfterPrefix(line, JOURNAL_FS_CHARSET)) == nullptr) {
+		error.Set(db_domain, "Journal corrupted");
+		return false;
+	}
+
+	if (strcmp(p, GetFSCharset()) != 0) {
+		error.Format(db_domain,
+			     "Journal has charset \"%s\" instead of \"%s\"",
+			     p, GetFSCharset());
+		return false;
+	}
+
+	const ScopeDatabaseLock protect;
+
+	while (directory_load_shallow(file, root, error)) {}
+
+	return !error.IsDefined();
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DATABASE_JOURNAL_HXX
+#define MPD_DATABASE_JOURNAL_HXX
+
+struct Directory;
+class BufferedOutputStream;
+class TextFile;
+class Error;
+
+/*
+ * The database journal is a text file next to the database file
+ * which contains a snapshot of each directory which has been modified
+ * since the database file was written.  Saving a few directories
+ * after a small update is much cheaper than rewriting the whole
+ * database file.
+ */
+
+/**
+ * Append a record for each "dirty" directory to the journal.
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * @param header write the journal header; this must be done if the
+ * file is new
+ */
+void
+db_journal_save(BufferedOutputStream &os, const Directory &root,
+		bool header);
+
+/**
+ * Replay a journal file, applying all records to the tree.  If an
+ * error occurs, all records before the bad one have been applied.
+ */
+bool
+db_journal_load(TextFile &file, Directory &root, Error &error);
+
+#endif
@@ -50,7 +50,8 @@ static constexpr unsigned DB_FORMAT = 2;
 static constexpr unsigned OLDEST_DB_FORMAT = 1;
 
 void
-db_save_internal(BufferedOutputStream &os, const Directory &music_root)
+db_save_internal(BufferedOutputStream &os, const Directory &music_root,
+		 tag_mask_t tag_mask)
 {
 	os.Format("%s\n", DIRECTORY_INFO_BEGIN);
 	os.Format(DB_FORMAT_PREFIX "%u\n", DB_FORMAT);
@@ -58,7 +59,7 @@ db_save_internal(BufferedOutputStream &os, const Directory &music_root)
 	os.Format("%s%s\n", DIRECTORY_FS_CHARSET, GetFSCharset());
 
 	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
-		if (IsTagEnabled(i))
+		if (IsTagEnabled(i) && (tag_mask & (tag_mask_t(1) << i)) != 0)
 			os.Format(DB_TAG_PREFIX "%s\n", tag_item_names[i]);
 
 	os.Format("%s\n", DIRECTORY_INFO_END);
@@ -67,7 +68,8 @@ db_save_internal(BufferedOutputStream &os, const Directory &music_root)
 }
 
 bool
-db_load_internal(TextFile &file, Directory &music_root, Error &error)
+db_load_internal(TextFile &file, Directory &music_root, tag_mask_t tag_mask,
+		 Error &error)
 {
 	char *line;
 	unsigned format = 0;
@@ -141,7 +143,8 @@ db_load_internal(TextFile &file, Directory &music_root, Error &error)
 	}
 
 	for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i) {
-		if (IsTagEnabled(i) && !tags[i]) {
+		if (IsTagEnabled(i) && (tag_mask & (tag_mask_t(1) << i)) != 0 &&
+		    !tags[i]) {
 			error.Set(db_domain,
 				  "Tag list mismatch, "
 				  "discarding database file");
@@ -20,15 +20,26 @@
 #ifndef MPD_DATABASE_SAVE_HXX
 #define MPD_DATABASE_SAVE_HXX
 
+#include "tag/Mask.hxx"
+
 struct Directory;
 class BufferedOutputStream;
 class TextFile;
 class Error;
 
+/**
+ * @param tag_mask the tag types which are stored in the file
+ */
 void
-db_save_internal(BufferedOutputStream &os, const Directory &root);
+db_save_internal(BufferedOutputStream &os, const Directory &root,
+		 tag_mask_t tag_mask);
 
+/**
+ * @param tag_mask the tag types which must be stored in the file;
+ * the file is rejected if one of them is missing
+ */
 bool
-db_load_internal(TextFile &file, Directory &root, Error &error);
+db_load_internal(TextFile &file, Directory &root, tag_mask_t tag_mask,
+		 Error &error);
 
 #endif
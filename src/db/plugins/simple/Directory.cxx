@@ -19,6 +19,8 @@
 
 #include "config.h"
 #include "Directory.hxx"
+#include "TagCounters.hxx"
+#include "SongIndex.hxx"
 #include "SongSort.hxx"
 #include "Song.hxx"
 #include "Mount.hxx"
@@ -28,12 +30,18 @@
 #include "db/DatabaseLock.hxx"
 #include "db/Interface.hxx"
 #include "SongFilter.hxx"
+#include "tag/TagBuilder.hxx"
 #include "lib/icu/Collate.hxx"
 #include "fs/Traits.hxx"
 #include "util/Alloc.hxx"
+#include "util/AllocatedString.hxx"
 #include "util/DeleteDisposer.hxx"
 #include "util/Error.hxx"
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
@@ -43,7 +51,10 @@ Directory::Directory(std::string &&_path_utf8, Directory *_parent)
 	 mtime(0),
 	 inode(0), device(0),
 	 path(std::move(_path_utf8)),
-	 mounted_database(nullptr)
+	 mounted_database(nullptr),
+	 counters(_parent == nullptr ? new TagCounters() : nullptr),
+	 index(_parent == nullptr ? new SongIndex() : nullptr),
+	 dirty(true)
 {
 }
 
@@ -53,14 +64,21 @@ Directory::~Directory()
 
 	songs.clear_and_dispose(Song::Disposer());
 	children.clear_and_dispose(DeleteDisposer());
+
+	delete index;
+	delete counters;
 }
 
 void
 Directory::Delete()
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 	assert(parent != nullptr);
 
+	GetRootCounters().Remove(*this);
+	GetRootIndex().Remove(*this);
+
+	parent->Modified();
 	parent->children.erase_and_dispose(parent->children.iterator_to(*this),
 					   DeleteDisposer());
 }
@@ -76,7 +94,7 @@ Directory::GetName() const
 Directory *
 Directory::CreateChild(const char *name_utf8)
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 	assert(name_utf8 != nullptr);
 	assert(*name_utf8 != 0);
 
@@ -86,6 +104,7 @@ Directory::CreateChild(const char *name_utf8)
 
 	Directory *child = new Directory(std::move(path_utf8), this);
 	children.push_back(*child);
+	Modified();
 	return child;
 }
 
@@ -101,19 +120,107 @@ Directory::FindChild(const char *name) const
 	return nullptr;
 }
 
+void
+Directory::Modified()
+{
+	assert(holding_db_write_lock());
+
+	dirty = true;
+}
+
+TagCounters &
+Directory::GetRootCounters()
+{
+	Directory *d = this;
+	while (d->parent != nullptr)
+		d = d->parent;
+
+	return *d->counters;
+}
+
+SongIndex &
+Directory::GetRootIndex()
+{
+	Directory *d = this;
+	while (d->parent != nullptr)
+		d = d->parent;
+
+	return *d->index;
+}
+
+void
+Directory::ClearDirty()
+{
+	assert(holding_db_write_lock());
+
+	dirty = false;
+
+	for (auto &child : children)
+		child.ClearDirty();
+}
+
+/**
+ * Does the #Tag contain an item which is not in the given mask?
+ */
+gcc_pure
+static bool
+HasItemNotInMask(const Tag &tag, tag_mask_t mask)
+{
+	for (const auto &item : tag)
+		if ((mask & (tag_mask_t(1) << unsigned(item.type))) == 0)
+			return true;
+
+	return false;
+}
+
+void
+Directory::FilterTags(tag_mask_t mask)
+{
+	assert(holding_db_write_lock());
+
+	bool modified = false;
+	for (auto &song : songs) {
+		if (!HasItemNotInMask(song.tag, mask))
+			continue;
+
+		auto &root_counters = GetRootCounters();
+		auto &root_index = GetRootIndex();
+		root_counters.Remove(song.tag);
+		root_index.Remove(song);
+
+		TagBuilder builder(std::move(song.tag));
+		for (unsigned i = 0; i < TAG_NUM_OF_ITEM_TYPES; ++i)
+			if ((mask & (tag_mask_t(1) << i)) == 0)
+				builder.RemoveType(TagType(i));
+		builder.Commit(song.tag);
+		root_counters.Add(song.tag);
+		root_index.Add(song);
+		modified = true;
+	}
+
+	if (modified)
+		Modified();
+
+	for (auto &child : children)
+		child.FilterTags(mask);
+}
+
 void
 Directory::PruneEmpty()
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 
 	for (auto child = children.begin(), end = children.end();
 	     child != end;) {
 		child->PruneEmpty();
 
-		if (child->IsEmpty())
+		if (child->IsEmpty()) {
 			child = children.erase_and_dispose(child,
 							   DeleteDisposer());
-		else
+
+			/* the journal must record the removal */
+			Modified();
+		} else
 			++child;
 	}
 }
@@ -166,21 +273,43 @@ Directory::LookupDirectory(const char *uri)
 void
 Directory::AddSong(Song *song)
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 	assert(song != nullptr);
 	assert(song->parent == this);
 
 	songs.push_back(*song);
+	GetRootCounters().Add(song->tag);
+	GetRootIndex().Add(*song);
+	Modified();
 }
 
 void
 Directory::RemoveSong(Song *song)
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 	assert(song != nullptr);
 	assert(song->parent == this);
 
+	GetRootCounters().Remove(song->tag);
+	GetRootIndex().Remove(*song);
 	songs.erase(songs.iterator_to(*song));
+	Modified();
+}
+
+void
+Directory::ReplaceSongTag(Song &song, Tag &&tag)
+{
+	assert(holding_db_write_lock());
+	assert(song.parent == this);
+
+	auto &root_counters = GetRootCounters();
+	auto &root_index = GetRootIndex();
+	root_counters.Remove(song.tag);
+	root_index.Remove(song);
+	song.tag = std::move(tag);
+	root_counters.Add(song.tag);
+	root_index.Add(song);
+	Modified();
 }
 
 const Song *
@@ -199,6 +328,30 @@ Directory::FindSong(const char *name_utf8) const
 	return nullptr;
 }
 
+const Song *
+Directory::FindSong(const char *name_utf8, const Song *hint) const
+{
+	assert(holding_db_lock());
+	assert(name_utf8 != nullptr);
+
+	if (hint == nullptr)
+		return FindSong(name_utf8);
+
+	assert(hint->parent == this);
+
+	const auto start = std::next(songs.iterator_to(*hint));
+
+	for (auto i = start, end = songs.end(); i != end; ++i)
+		if (strcmp(i->uri, name_utf8) == 0)
+			return &*i;
+
+	for (auto i = songs.begin(); i != start; ++i)
+		if (strcmp(i->uri, name_utf8) == 0)
+			return &*i;
+
+	return nullptr;
+}
+
 gcc_pure
 static bool
 directory_cmp(const Directory &a, const Directory &b)
@@ -206,12 +359,50 @@ directory_cmp(const Directory &a, const Directory &b)
 	return IcuCollate(a.path.c_str(), b.path.c_str()) < 0;
 }
 
+/**
+ * Sort the directories by their collation sort keys (see
+ * IcuSortKey()), which are generated only once for each directory,
+ * instead of calling IcuCollate() for each comparison.
+ */
+static void
+directory_list_sort(Directory::List &list)
+{
+	if (std::is_sorted(list.begin(), list.end(), directory_cmp))
+		/* this is the common case: only few directories are
+		   modified by a database update */
+		return;
+
+	typedef std::pair<AllocatedString<>, Directory *> Item;
+	std::vector<Item> items;
+	for (auto &directory : list) {
+		auto key = IcuSortKey(directory.path.c_str());
+		if (key.IsNull()) {
+			/* sort keys and raw strings can't be compared
+			   with each other */
+			list.sort(directory_cmp);
+			return;
+		}
+
+		items.emplace_back(std::move(key), &directory);
+	}
+
+	std::stable_sort(items.begin(), items.end(),
+			 [](const Item &a, const Item &b){
+				 return strcmp(a.first.c_str(),
+					       b.first.c_str()) < 0;
+			 });
+
+	list.clear();
+	for (auto &i : items)
+		list.push_back(*i.second);
+}
+
 void
 Directory::Sort()
 {
-	assert(holding_db_lock());
+	assert(holding_db_write_lock());
 
-	children.sort(directory_cmp);
+	directory_list_sort(children);
 	song_list_sort(songs);
 
 	for (auto &child : children)
@@ -232,8 +423,8 @@ Directory::Walk(bool recursive, const SongFilter *filter,
 		/* TODO: eliminate this unlock/lock; it is necessary
 		   because the child's SimpleDatabasePlugin::Visit()
 		   call will lock it again */
-		const ScopeDatabaseUnlock unlock;
-		return WalkMount(GetPath(), *mounted_database,
+		const ScopeDatabaseSharedUnlock unlock;
+		return WalkMount(GetPath(), *mounted_database, "",
 				 recursive, filter,
 				 visit_directory, visit_song,
 				 visit_playlist,
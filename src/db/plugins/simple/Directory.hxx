@@ -24,12 +24,15 @@
 #include "Compiler.h"
 #include "db/Visitor.hxx"
 #include "db/PlaylistVector.hxx"
+#include "tag/Mask.hxx"
 #include "Song.hxx"
 
 #include <boost/intrusive/list.hpp>
 
 #include <string>
 
+#include <assert.h>
+
 /**
  * Virtual directory that is really an archive file or a folder inside
  * the archive (special value for Directory::device).
@@ -46,6 +49,8 @@ static constexpr unsigned DEVICE_CONTAINER = -2;
 class SongFilter;
 class Error;
 class Database;
+class TagCounters;
+class SongIndex;
 
 struct Directory {
 	static constexpr auto link_mode = boost::intrusive::normal_link;
@@ -97,6 +102,32 @@ struct Directory {
 	 */
 	Database *mounted_database;
 
+	/**
+	 * Aggregate counters over all songs in this tree.  This is
+	 * only allocated in the root directory (nullptr elsewhere).
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	TagCounters *counters;
+
+	/**
+	 * An index of all songs in this tree by tag value.  This is
+	 * only allocated in the root directory (nullptr elsewhere).
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	SongIndex *index;
+
+	/**
+	 * Have the attributes, the songs, the playlists or the list
+	 * of children of this directory been modified since the
+	 * database was saved?  This is used to write the database
+	 * journal.
+	 *
+	 * This attribute is protected with the global #db_mutex.
+	 */
+	bool dirty;
+
 public:
 	Directory(std::string &&_path_utf8, Directory *_parent);
 	~Directory();
@@ -117,14 +148,14 @@ public:
 	 * Remove this #Directory object from its parent and free it.  This
 	 * must not be called with the root Directory.
 	 *
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 */
 	void Delete();
 
 	/**
 	 * Create a new #Directory object as a child of the given one.
 	 *
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 *
 	 * @param name_utf8 the UTF-8 encoded name of the new sub directory
 	 */
@@ -147,7 +178,7 @@ public:
 	 * Look up a sub directory, and create the object if it does not
 	 * exist.
 	 *
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 */
 	Directory *MakeChild(const char *name_utf8) {
 		Directory *child = FindChild(name_utf8);
@@ -238,6 +269,17 @@ public:
 		return const_cast<Song *>(cthis->FindSong(name_utf8));
 	}
 
+	/**
+	 * Like FindSong(), but begin searching after the given song
+	 * (which must be in this directory, or nullptr), and wrap
+	 * around at the end.  This is fast when looking up many
+	 * songs in the order of this directory.
+	 *
+	 * Caller must lock the #db_mutex.
+	 */
+	gcc_pure
+	const Song *FindSong(const char *name_utf8, const Song *hint) const;
+
 	/**
 	 * Add a song object to this directory.  Its "parent" attribute must
 	 * be set already.
@@ -251,20 +293,86 @@ public:
 	 */
 	void RemoveSong(Song *song);
 
+	/**
+	 * Replace the tag of a song in this directory, e.g. after the
+	 * song file has been modified.  Implies Modified().
+	 *
+	 * Caller must lock the #db_mutex exclusively.
+	 */
+	void ReplaceSongTag(Song &song, Tag &&tag);
+
+	/**
+	 * Mark this directory as modified (see #dirty).  This is
+	 * called implicitly by methods which add or remove songs and
+	 * children; it must be called explicitly after a playlist or
+	 * the directory's attributes have been changed.
+	 *
+	 * Caller must lock the #db_mutex exclusively.
+	 */
+	void Modified();
+
+	/**
+	 * Clear the #dirty flag of this directory and all of its
+	 * descendants.
+	 *
+	 * Caller must lock the #db_mutex exclusively.
+	 */
+	void ClearDirty();
+
+	/**
+	 * Caller must lock the #db_mutex.
+	 */
+	const TagCounters &GetCounters() const {
+		assert(IsRoot());
+
+		return *counters;
+	}
+
+	/**
+	 * Returns the #TagCounters of the tree this directory
+	 * belongs to.
+	 */
+	gcc_pure
+	TagCounters &GetRootCounters();
+
 	/**
 	 * Caller must lock the #db_mutex.
 	 */
+	SongIndex &GetIndex() {
+		assert(IsRoot());
+
+		return *index;
+	}
+
+	/**
+	 * Returns the #SongIndex of the tree this directory belongs
+	 * to.
+	 */
+	gcc_pure
+	SongIndex &GetRootIndex();
+
+	/**
+	 * Caller must lock the #db_mutex exclusively.
+	 */
 	void PruneEmpty();
 
+	/**
+	 * Remove all tag items whose type is not in the given mask
+	 * from all songs, recursively.
+	 *
+	 * Caller must lock the #db_mutex exclusively.
+	 */
+	void FilterTags(tag_mask_t mask);
+
 	/**
 	 * Sort all directory entries recursively.
 	 *
-	 * Caller must lock the #db_mutex.
+	 * Caller must lock the #db_mutex exclusively.
 	 */
 	void Sort();
 
 	/**
-	 * Caller must lock #db_mutex.
+	 * Caller must lock #db_mutex in shared mode.
 	 */
 	bool Walk(bool recursive, const SongFilter *match,
 		  VisitDirectory visit_directory, VisitSong visit_song,
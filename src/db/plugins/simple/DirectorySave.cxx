@@ -31,6 +31,10 @@
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 
+#include <list>
+#include <set>
+#include <string>
+
 #include <string.h>
 
 #define DIRECTORY_DIR "directory: "
@@ -200,3 +204,140 @@ directory_load(TextFile &file, Directory &directory, Error &error)
 
 	return true;
 }
+
+void
+directory_save_shallow(BufferedOutputStream &os, const Directory &directory)
+{
+	const char *type = DeviceToTypeString(directory.device);
+	if (type != nullptr)
+		os.Format(DIRECTORY_TYPE "%s\n", type);
+
+	if (directory.mtime != 0)
+		os.Format(DIRECTORY_MTIME "%lu\n",
+			  (unsigned long)directory.mtime);
+
+	os.Format("%s%s\n", DIRECTORY_BEGIN, directory.GetPath());
+
+	for (const auto &child : directory.children)
+		if (!child.IsMount())
+			os.Format(DIRECTORY_DIR "%s\n", child.GetName());
+
+	for (const auto &song : directory.songs)
+		song_save(os, song);
+
+	playlist_vector_save(os, directory.playlists);
+
+	os.Format(DIRECTORY_END "%s\n", directory.GetPath());
+}
+
+/**
+ * Look up a directory by its path, and create all missing path
+ * components.
+ */
+static Directory &
+MakeDirectoryPath(Directory &root, const char *path)
+{
+	Directory *directory = &root;
+
+	while (*path != 0) {
+		const char *slash = strchr(path, '/');
+		if (slash == nullptr)
+			return *directory->MakeChild(path);
+
+		const std::string name(path, slash);
+		directory = directory->MakeChild(name.c_str());
+		path = slash + 1;
+	}
+
+	return *directory;
+}
+
+bool
+directory_load_shallow(TextFile &file, Directory &root, Error &error)
+{
+	const char *line = file.ReadLine();
+	if (line == nullptr)
+		return false;
+
+	/* parse the whole record before applying it, so a truncated
+	   record (e.g. after a crash while the journal was being
+	   written) does not leave a half-loaded directory behind */
+
+	time_t mtime = 0;
+	unsigned device = 0;
+
+	const char *p;
+	while ((p = StringAfterPrefix(line, DIRECTORY_BEGIN)) == nullptr) {
+		if ((p = StringAfterPrefix(line, DIRECTORY_MTIME))) {
+			mtime = ParseUint64(p);
+		} else if ((p = StringAfterPrefix(line, DIRECTORY_TYPE))) {
+			device = ParseTypeString(p);
+		} else {
+			error.Format(directory_domain,
+				     "Malformed line: %s", line);
+			return false;
+		}
+
+		line = file.ReadLine();
+		if (line == nullptr) {
+			error.Set(directory_domain, "Unexpected end of file");
+			return false;
+		}
+	}
+
+	const std::string path(p);
+	std::set<std::string> children;
+	std::list<DetachedSong> songs;
+	PlaylistVector playlists;
+
+	while ((line = file.ReadLine()) != nullptr &&
+	       !StringStartsWith(line, DIRECTORY_END)) {
+		if ((p = StringAfterPrefix(line, DIRECTORY_DIR))) {
+			children.emplace(p);
+		} else if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
+			DetachedSong *song = song_load(file, p, error);
+			if (song == nullptr)
+				return false;
+
+			songs.emplace_back(std::move(*song));
+			delete song;
+		} else if ((p = StringAfterPrefix(line, PLAYLIST_META_BEGIN))) {
+			if (!playlist_metadata_load(file, playlists, p, error))
+				return false;
+		} else {
+			error.Format(directory_domain,
+				     "Malformed line: %s", line);
+			return false;
+		}
+	}
+
+	if (line == nullptr) {
+		error.Set(directory_domain, "Unexpected end of file");
+		return false;
+	}
+
+	Directory &directory = MakeDirectoryPath(root, path.c_str());
+	directory.mtime = mtime;
+	directory.device = device;
+
+	directory.ForEachChildSafe([&children](Directory &child){
+			if (!child.IsMount() &&
+			    children.find(child.GetName()) == children.end())
+				child.Delete();
+		});
+
+	for (const auto &name : children)
+		directory.MakeChild(name.c_str());
+
+	directory.ForEachSongSafe([&directory](Song &song){
+			directory.RemoveSong(&song);
+			song.Free();
+		});
+
+	for (auto &song : songs)
+		directory.AddSong(Song::NewFrom(std::move(song), directory));
+
+	directory.playlists = std::move(playlists);
+	directory.Modified();
+	return true;
+}
@@ -31,4 +31,26 @@ directory_save(BufferedOutputStream &os, const Directory &directory);
 bool
 directory_load(TextFile &file, Directory &directory, Error &error);
 
+/**
+ * Save the attributes, the songs, the playlists and the names of the
+ * children of one directory, but not the contents of its children.
+ * This is used for the database journal.
+ */
+void
+directory_save_shallow(BufferedOutputStream &os, const Directory &directory);
+
+/**
+ * Load one record written by directory_save_shallow() and apply it to
+ * the tree: the directory is created if it does not exist yet, and
+ * its contents are replaced.  Nothing is modified unless the whole
+ * record could be read.
+ *
+ * Caller must lock the #db_mutex.
+ *
+ * @return false on error (with #error set) or at the end of the file
+ * (without #error set)
+ */
+bool
+directory_load_shallow(TextFile &file, Directory &root, Error &error);
+
 #endif
@@ -26,8 +26,12 @@ class Database;
 class SongFilter;
 class Error;
 
+/**
+ * Visit the specified URI (relative to the mount point) of a mounted
+ * database, prefixing all URIs with the path of the mount point.
+ */
 bool
-WalkMount(const char *base, const Database &db,
+WalkMount(const char *base, const Database &db, const char *uri,
 	  bool recursive, const SongFilter *filter,
 	  const VisitDirectory &visit_directory, const VisitSong &visit_song,
 	  const VisitPlaylist &visit_playlist,
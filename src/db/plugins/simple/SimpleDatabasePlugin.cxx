@@ -28,6 +28,11 @@
 #include "Directory.hxx"
 #include "Song.hxx"
 #include "DatabaseSave.hxx"
+#include "DatabaseJournal.hxx"
+#include "BinaryDatabase.hxx"
+#include "Mount.hxx"
+#include "TagCounters.hxx"
+#include "SongIndex.hxx"
 #include "db/DatabaseLock.hxx"
 #include "db/DatabaseError.hxx"
 #include "fs/io/TextFile.hxx"
@@ -35,6 +40,8 @@
 #include "fs/io/FileOutputStream.hxx"
 #include "fs/FileInfo.hxx"
 #include "config/Block.hxx"
+#include "tag/Settings.hxx"
+#include "tag/TagConfig.hxx"
 #include "fs/FileSystem.hxx"
 #include "util/CharUtil.hxx"
 #include "util/Error.hxx"
@@ -45,9 +52,12 @@
 #include "fs/io/GzipOutputStream.hxx"
 #endif
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <errno.h>
+#include <string.h>
 
 static constexpr Domain simple_db_domain("simple_db");
 
@@ -57,6 +67,9 @@ inline SimpleDatabase::SimpleDatabase()
 #ifdef ENABLE_ZLIB
 	 compress(true),
 #endif
+	 binary(false), journal(false), journal_broken(false),
+	 journal_path(AllocatedPath::Null()),
+	 resident_tags(~tag_mask_t(0)),
 	 cache_path(AllocatedPath::Null()),
 	 prefixed_light_song(nullptr) {}
 
@@ -71,6 +84,9 @@ inline SimpleDatabase::SimpleDatabase(AllocatedPath &&_path,
 #ifdef ENABLE_ZLIB
 	 compress(_compress),
 #endif
+	 binary(false), journal(false), journal_broken(false),
+	 journal_path(AllocatedPath::Null()),
+	 resident_tags(~tag_mask_t(0)),
 	 cache_path(AllocatedPath::Null()),
 	 prefixed_light_song(nullptr) {
 }
@@ -101,6 +117,8 @@ SimpleDatabase::Configure(const ConfigBlock &block, Error &error)
 	}
 
 	path_utf8 = path.ToUTF8();
+	journal_path = AllocatedPath::FromFS(path.c_str() +
+					     PathTraitsFS::string(PATH_LITERAL(".journal")));
 
 	cache_path = block.GetBlockPath("cache_directory", error);
 	if (path.IsNull() && error.IsDefined())
@@ -110,6 +128,27 @@ SimpleDatabase::Configure(const ConfigBlock &block, Error &error)
 	compress = block.GetBlockValue("compress", compress);
 #endif
 
+	const char *format = block.GetBlockValue("format", "text");
+	if (strcmp(format, "binary") == 0)
+		binary = true;
+	else if (strcmp(format, "text") != 0) {
+		error.Format(simple_db_domain,
+			     "Unrecognized database format: %s", format);
+		return false;
+	}
+
+	journal = block.GetBlockValue("journal", false);
+
+	const char *tags = block.GetBlockValue("resident_tags");
+	if (tags != nullptr) {
+		try {
+			resident_tags = ParseTagMask(tags);
+		} catch (const std::runtime_error &e) {
+			error.Set(simple_db_domain, e.what());
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -172,18 +211,73 @@ SimpleDatabase::Load(Error &error)
 	assert(!path.IsNull());
 	assert(root != nullptr);
 
-	TextFile file(path);
+	if (db_is_binary(path)) {
+		if (!db_load_binary(path, *root, resident_tags, error))
+			return false;
+	} else {
+		TextFile file(path);
 
-	if (!db_load_internal(file, *root, error))
-		return false;
+		if (!db_load_internal(file, *root, resident_tags, error))
+			return false;
+	}
 
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
 		mtime = fi.GetModificationTime();
 
+	const bool replayed = LoadJournal();
+
+	{
+		const ScopeDatabaseLock protect;
+
+		if (HasPartialTags())
+			root->FilterTags(resident_tags);
+
+		if (replayed)
+			/* directories created by the journal were
+			   appended to their parents */
+			root->Sort();
+
+		root->ClearDirty();
+	}
+
+	return true;
+}
+
+bool
+SimpleDatabase::LoadJournal()
+{
+	FileInfo fi;
+	if (!GetFileInfo(journal_path, fi))
+		return false;
+
+	LogDebug(simple_db_domain, "replaying DB journal");
+
+	try {
+		TextFile file(journal_path);
+
+		Error error;
+		if (!db_journal_load(file, *root, error)) {
+			LogError(error, "Failed to replay the database journal");
+			journal_broken = true;
+		}
+	} catch (const std::exception &e) {
+		LogError(e);
+		journal_broken = true;
+	}
+
+	if (fi.GetModificationTime() > mtime)
+		mtime = fi.GetModificationTime();
+
 	return true;
 }
 
+bool
+SimpleDatabase::HasPartialTags() const
+{
+	return (global_tag_mask & ~resident_tags) != 0;
+}
+
 void
 SimpleDatabase::Open()
 {
@@ -194,6 +288,7 @@ SimpleDatabase::Open()
 
 #ifndef NDEBUG
 	borrowed_song_count = 0;
+	open_thread = ThreadId::GetCurrent();
 #endif
 
 	try {
@@ -201,6 +296,11 @@ SimpleDatabase::Open()
 		if (!Load(error2)) {
 			LogError(error2);
 
+			/* the journal refers to the database file
+			   which could not be loaded; don't append to
+			   it */
+			journal_broken = true;
+
 			delete root;
 
 			Check();
@@ -210,6 +310,8 @@ SimpleDatabase::Open()
 	} catch (const std::exception &e) {
 		LogError(e);
 
+		journal_broken = true;
+
 		delete root;
 
 		Check();
@@ -234,8 +336,9 @@ SimpleDatabase::GetSong(const char *uri) const
 	assert(root != nullptr);
 	assert(prefixed_light_song == nullptr);
 	assert(borrowed_song_count == 0);
+	assert(open_thread.IsInside());
 
-	ScopeDatabaseLock protect;
+	ScopeDatabaseSharedLock protect;
 
 	auto r = root->LookupDirectory(uri);
 
@@ -270,6 +373,7 @@ SimpleDatabase::GetSong(const char *uri) const
 				    "No such song");
 
 	light_song = song->Export();
+	light_song.partial_tag = HasPartialTags();
 
 #ifndef NDEBUG
 	++borrowed_song_count;
@@ -283,6 +387,7 @@ SimpleDatabase::ReturnSong(gcc_unused const LightSong *song) const
 {
 	assert(song != nullptr);
 	assert(song == &light_song || song == prefixed_light_song);
+	assert(open_thread.IsInside());
 
 	delete prefixed_light_song;
 	prefixed_light_song = nullptr;
@@ -295,6 +400,86 @@ SimpleDatabase::ReturnSong(gcc_unused const LightSong *song) const
 #endif
 }
 
+void
+SimpleDatabase::LookupSongs(ConstBuffer<const char *> uris,
+			    VisitIndexedSong visit) const
+{
+	assert(root != nullptr);
+
+	/* songs in mounted databases are looked up after the lock
+	   has been released, just like GetSong() does */
+	std::vector<size_t> mounted;
+
+	{
+		ScopeDatabaseSharedLock protect;
+
+		/* visit the URIs in sorted order, so all songs of a
+		   directory are looked up one after another, and the
+		   directory needs to be looked up only once */
+		std::vector<size_t> sorted(uris.size);
+		for (size_t i = 0; i < uris.size; ++i)
+			sorted[i] = i;
+
+		std::sort(sorted.begin(), sorted.end(),
+			  [&uris](size_t a, size_t b){
+				  return strcmp(uris[a], uris[b]) < 0;
+			  });
+
+		const char *prev_uri = nullptr;
+		size_t prev_length = 0;
+		const Directory *directory = nullptr;
+		const Song *prev_song = nullptr;
+
+		for (size_t i : sorted) {
+			const char *uri = uris[i];
+			const char *slash = strrchr(uri, '/');
+			const size_t length = slash != nullptr
+				? size_t(slash - uri)
+				: 0;
+			const char *name = slash != nullptr ? slash + 1 : uri;
+
+			if (directory == nullptr || length != prev_length ||
+			    memcmp(uri, prev_uri, length) != 0) {
+				auto r = root->LookupDirectory(uri);
+				if (r.directory->IsMount()) {
+					mounted.push_back(i);
+					directory = nullptr;
+					continue;
+				}
+
+				if (r.uri == nullptr ||
+				    strchr(r.uri, '/') != nullptr) {
+					/* not a song */
+					directory = nullptr;
+					continue;
+				}
+
+				directory = r.directory;
+				prev_uri = uri;
+				prev_length = length;
+				prev_song = nullptr;
+			}
+
+			const Song *song = directory->FindSong(name, prev_song);
+			if (song == nullptr)
+				continue;
+
+			prev_song = song;
+
+			LightSong light = song->Export();
+			light.partial_tag = HasPartialTags();
+			visit(i, light);
+		}
+	}
+
+	for (size_t i : mounted)
+		Database::LookupSongs({&uris[i], 1},
+				      [i, &visit](size_t,
+						  const LightSong &song){
+					      visit(i, song);
+				      });
+}
+
 bool
 SimpleDatabase::Visit(const DatabaseSelection &selection,
 		      VisitDirectory visit_directory,
@@ -302,7 +487,16 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		      VisitPlaylist visit_playlist,
 		      Error &error) const
 {
-	ScopeDatabaseLock protect;
+	if (visit_song && HasPartialTags()) {
+		const VisitSong inner = std::move(visit_song);
+		visit_song = [inner](const LightSong &song, Error &error2){
+			LightSong song2 = song;
+			song2.partial_tag = true;
+			return inner(song2, error2);
+		};
+	}
+
+	ScopeDatabaseSharedLock protect;
 
 	auto r = root->LookupDirectory(selection.uri.c_str());
 	if (r.uri == nullptr) {
@@ -312,12 +506,45 @@ SimpleDatabase::Visit(const DatabaseSelection &selection,
 		    !visit_directory(r.directory->Export(), error))
 			return false;
 
+		if (visit_song && !visit_directory && !visit_playlist &&
+		    selection.filter != nullptr &&
+		    SongIndex::CanFilter(*selection.filter)) {
+			auto &index = root->GetIndex();
+
+			{
+				/* the shared database lock allows
+				   concurrent readers; the index has
+				   its own lock because Build() may
+				   have to build it */
+				const ScopeLock index_lock(index_mutex);
+				index.Build(*root);
+			}
+
+			if (index.IsUsable())
+				return index.Visit(*r.directory,
+						   selection.recursive,
+						   *selection.filter,
+						   visit_song, error);
+		}
+
 		return r.directory->Walk(selection.recursive, selection.filter,
 					 visit_directory, visit_song,
 					 visit_playlist,
 					 error);
 	}
 
+	if (r.directory->IsMount()) {
+		/* pass the request to the mounted database */
+		const std::string base(r.directory->GetPath());
+		const Database &db = *r.directory->mounted_database;
+		protect.unlock();
+
+		return WalkMount(base.c_str(), db, r.uri,
+				 selection.recursive, selection.filter,
+				 visit_directory, visit_song, visit_playlist,
+				 error);
+	}
+
 	if (strchr(r.uri, '/') == nullptr) {
 		if (visit_song) {
 			Song *song = r.directory->FindSong(r.uri);
@@ -344,16 +571,105 @@ SimpleDatabase::VisitUniqueTags(const DatabaseSelection &selection,
 				 error);
 }
 
+/**
+ * Can this selection be answered by the root directory's
+ * #TagCounters?
+ */
+gcc_pure
+static bool
+IsWholeDatabase(const DatabaseSelection &selection)
+{
+	return selection.recursive && selection.IsEmpty();
+}
+
 bool
 SimpleDatabase::GetStats(const DatabaseSelection &selection,
 			 DatabaseStats &stats, Error &error) const
 {
+	if (IsWholeDatabase(selection)) {
+		const ScopeDatabaseSharedLock protect;
+		const auto &counters = root->GetCounters();
+		if (counters.IsUsable()) {
+			counters.GetStats(stats);
+			return true;
+		}
+	}
+
 	return ::GetStats(*this, selection, stats, error);
 }
 
+bool
+SimpleDatabase::GetGroupStats(const DatabaseSelection &selection,
+			      TagType group, VisitGroupStats visit,
+			      gcc_unused Error &error) const
+{
+	if (!IsWholeDatabase(selection))
+		return false;
+
+	const ScopeDatabaseSharedLock protect;
+	const auto &counters = root->GetCounters();
+	if (!counters.IsUsable())
+		return false;
+
+	counters.VisitGroup(group, visit);
+	return true;
+}
+
+bool
+SimpleDatabase::SaveJournal()
+{
+	if (journal_broken)
+		return false;
+
+	FileInfo db_info;
+	if (!GetFileInfo(path, db_info))
+		return false;
+
+	FileInfo journal_info;
+	const bool exists = GetFileInfo(journal_path, journal_info);
+	if (exists && journal_info.GetSize() > db_info.GetSize())
+		/* the journal has become too large; replaying it would
+		   be more expensive than loading a fresh database
+		   file */
+		return false;
+
+	LogDebug(simple_db_domain, "writing DB journal");
+
+	if (exists) {
+		AppendFileOutputStream fos(journal_path);
+		BufferedOutputStream bos(fos);
+		db_journal_save(bos, *root, false);
+		bos.Flush();
+		fos.Commit();
+	} else {
+		FileOutputStream fos(journal_path);
+		BufferedOutputStream bos(fos);
+		db_journal_save(bos, *root, true);
+		bos.Flush();
+		fos.Commit();
+	}
+
+	{
+		const ScopeDatabaseLock protect;
+		root->ClearDirty();
+	}
+
+	if (GetFileInfo(journal_path, journal_info))
+		mtime = journal_info.GetModificationTime();
+
+	return true;
+}
+
 void
 SimpleDatabase::Save()
 {
+	if (HasPartialTags()) {
+		/* discard the tags of new and modified songs which are
+		   not supposed to be kept in memory */
+		const ScopeDatabaseLock protect;
+		root->FilterTags(resident_tags);
+	}
+
 	{
 		const ScopeDatabaseLock protect;
 
@@ -364,6 +680,17 @@ SimpleDatabase::Save()
 		root->Sort();
 	}
 
+	if (journal && FileExists() && SaveJournal())
+		return;
+
+	/* the new database file will contain everything which is in
+	   the journal; delete it first, because replaying an obsolete
+	   journal on top of the new file would revert changes; until
+	   the new file has been committed, the journal must not be
+	   appended to */
+	RemoveFile(journal_path);
+	journal_broken = true;
+
 	LogDebug(simple_db_domain, "writing DB");
 
 	FileOutputStream fos(path);
@@ -372,7 +699,7 @@ SimpleDatabase::Save()
 
 #ifdef ENABLE_ZLIB
 	std::unique_ptr<GzipOutputStream> gzip;
-	if (compress) {
+	if (compress && !binary) {
 		gzip.reset(new GzipOutputStream(*os));
 		os = gzip.get();
 	}
@@ -380,7 +707,10 @@ SimpleDatabase::Save()
 
 	BufferedOutputStream bos(*os);
 
-	db_save_internal(bos, *root);
+	if (binary)
+		db_save_binary(bos, *root, resident_tags);
+	else
+		db_save_internal(bos, *root, resident_tags);
 
 	bos.Flush();
 
@@ -392,6 +722,12 @@ SimpleDatabase::Save()
 #endif
 
 	fos.Commit();
+	journal_broken = false;
+
+	{
+		const ScopeDatabaseLock protect;
+		root->ClearDirty();
+	}
 
 	FileInfo fi;
 	if (GetFileInfo(path, fi))
@@ -421,6 +757,9 @@ SimpleDatabase::Mount(const char *uri, Database *db)
 
 	Directory *mnt = r.directory->CreateChild(r.uri);
 	mnt->mounted_database = db;
+	mnt->Modified();
+	root->GetRootCounters().AddMount();
+	root->GetIndex().AddMount();
 }
 
 static constexpr bool
@@ -487,6 +826,8 @@ SimpleDatabase::LockUmountSteal(const char *uri)
 
 	Database *db = r.directory->mounted_database;
 	r.directory->mounted_database = nullptr;
+	root->GetRootCounters().RemoveMount();
+	root->GetIndex().RemoveMount();
 	r.directory->Delete();
 
 	return db;
@@ -506,6 +847,7 @@ SimpleDatabase::Unmount(const char *uri)
 
 const DatabasePlugin simple_db_plugin = {
 	"simple",
-	DatabasePlugin::FLAG_REQUIRE_STORAGE,
+	DatabasePlugin::FLAG_REQUIRE_STORAGE |
+	DatabasePlugin::FLAG_CONCURRENT_VISIT,
 	SimpleDatabase::Create,
 };
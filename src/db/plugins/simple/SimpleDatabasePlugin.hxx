@@ -24,8 +24,14 @@
 #include "db/Interface.hxx"
 #include "fs/AllocatedPath.hxx"
 #include "db/LightSong.hxx"
+#include "tag/Mask.hxx"
+#include "thread/Mutex.hxx"
 #include "Compiler.h"
 
+#ifndef NDEBUG
+#include "thread/Id.hxx"
+#endif
+
 #include <cassert>
 
 struct ConfigBlock;
@@ -43,6 +49,43 @@ class SimpleDatabase : public Database {
 	bool compress;
 #endif
 
+	/**
+	 * Write the database file in the binary format (see
+	 * BinaryDatabase.hxx) instead of the text format?  Both
+	 * formats can always be loaded.
+	 */
+	bool binary;
+
+	/**
+	 * Append modified directories to a journal file instead of
+	 * rewriting the whole database file after each update (see
+	 * DatabaseJournal.hxx)?
+	 */
+	bool journal;
+
+	/**
+	 * Set if the journal could not be replayed completely (or the
+	 * database file could not be loaded at all); the next Save()
+	 * call will then write the whole database file and discard
+	 * the journal.
+	 */
+	bool journal_broken;
+
+	/**
+	 * The path of the journal file.  It is loaded (if it exists)
+	 * even if #journal is disabled.
+	 */
+	AllocatedPath journal_path;
+
+	/**
+	 * The tag types which are kept in memory (and in the database
+	 * file).  All other tags are discarded after the songs have
+	 * been scanned, and are loaded from the song file when a song
+	 * is detached from the database, e.g. when it is added to the
+	 * queue.
+	 */
+	tag_mask_t resident_tags;
+
 	/**
 	 * The path where cache files for Mount() are located.
 	 */
@@ -52,9 +95,22 @@ class SimpleDatabase : public Database {
 
 	time_t mtime;
 
+	/**
+	 * Protects the root directory's #SongIndex while it is being
+	 * built.  Visit() holds the #db_mutex only in "shared" mode,
+	 * so this separate lock is needed.  Once built, the index is
+	 * only modified by writers holding the exclusive lock, and
+	 * readers may walk it without this lock.
+	 */
+	mutable Mutex index_mutex;
+
 	/**
 	 * A buffer for GetSong() when prefixing the #LightSong
 	 * instance from a mounted #Database.
+	 *
+	 * This and #light_song are not protected by the #db_mutex;
+	 * GetSong() may only be called by the thread which has opened
+	 * the database (i.e. the main thread).
 	 */
 	mutable PrefixedLightSong *prefixed_light_song;
 
@@ -65,6 +121,12 @@ class SimpleDatabase : public Database {
 
 #ifndef NDEBUG
 	mutable unsigned borrowed_song_count;
+
+	/**
+	 * The thread which has called Open(); see
+	 * #prefixed_light_song.
+	 */
+	ThreadId open_thread;
 #endif
 
 	SimpleDatabase();
@@ -112,6 +174,8 @@ public:
 
 	const LightSong *GetSong(const char *uri_utf8) const override;
 	void ReturnSong(const LightSong *song) const override;
+	void LookupSongs(ConstBuffer<const char *> uris,
+			 VisitIndexedSong visit) const override;
 
 	virtual bool Visit(const DatabaseSelection &selection,
 			   VisitDirectory visit_directory,
@@ -128,6 +192,10 @@ public:
 			      DatabaseStats &stats,
 			      Error &error) const override;
 
+	virtual bool GetGroupStats(const DatabaseSelection &selection,
+				   TagType group, VisitGroupStats visit,
+				   Error &error) const override;
+
 	virtual time_t GetUpdateStamp() const override {
 		return mtime;
 	}
@@ -139,6 +207,27 @@ private:
 
 	bool Load(Error &error);
 
+	/**
+	 * Replay the journal file on top of the loaded database.
+	 *
+	 * @return true if a journal was found
+	 */
+	bool LoadJournal();
+
+	/**
+	 * Append all modified directories to the journal file.
+	 *
+	 * @return false if the whole database file should be written
+	 * instead
+	 */
+	bool SaveJournal();
+
+	/**
+	 * Are some tag types not kept in memory?  See #resident_tags.
+	 */
+	gcc_pure
+	bool HasPartialTags() const;
+
 	Database *LockUmountSteal(const char *uri);
 };
 
@@ -104,6 +104,7 @@ Song::Export() const
 	dest.uri = uri;
 	dest.real_uri = nullptr;
 	dest.tag = &tag;
+	dest.partial_tag = false;
 	dest.mtime = mtime;
 	dest.start_time = start_time;
 	dest.end_time = end_time;
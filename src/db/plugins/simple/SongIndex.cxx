@@ -0,0 +1,340 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "SongIndex.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "db/LightSong.hxx"
+#include "db/DatabaseLock.hxx"
+#include "SongFilter.hxx"
+#include "tag/TagPool.hxx"
+
+#include <algorithm>
+#include <iterator>
+
+#include <assert.h>
+
+/**
+ * Is this the first occurrence of the item in the tag?  A tag may
+ * contain the same (interned) item several times, but each song must
+ * be in a posting list only once.
+ */
+gcc_pure
+static bool
+IsFirstOccurrence(const Tag &tag, unsigned i)
+{
+	for (unsigned j = 0; j < i; ++j)
+		if (tag.items[j] == tag.items[i])
+			return false;
+
+	return true;
+}
+
+void
+SongIndex::Add(const Song &song)
+{
+	if (!valid)
+		return;
+
+	const Tag &tag = song.tag;
+	for (unsigned i = 0; i < tag.num_items; ++i)
+		if (IsFirstOccurrence(tag, i))
+			postings[tag.items[i]].insert(&song);
+}
+
+void
+SongIndex::Remove(const Song &song)
+{
+	if (!valid)
+		return;
+
+	const Tag &tag = song.tag;
+	for (unsigned i = 0; i < tag.num_items; ++i) {
+		if (!IsFirstOccurrence(tag, i))
+			continue;
+
+		auto p = postings.find(tag.items[i]);
+		assert(p != postings.end());
+
+		auto &list = p->second;
+		gcc_unused const size_t n = list.erase(&song);
+		assert(n == 1);
+
+		if (list.empty())
+			/* the item may be freed after this, and its
+			   address may be reused for another value */
+			postings.erase(p);
+	}
+}
+
+void
+SongIndex::AddRecursive(const Directory &directory)
+{
+	for (const auto &song : directory.songs)
+		Add(song);
+
+	for (const auto &child : directory.children)
+		AddRecursive(child);
+}
+
+void
+SongIndex::Remove(const Directory &directory)
+{
+	if (directory.IsMount())
+		RemoveMount();
+
+	for (const auto &song : directory.songs)
+		Remove(song);
+
+	for (const auto &child : directory.children)
+		Remove(child);
+}
+
+void
+SongIndex::Build(const Directory &root)
+{
+	assert(holding_db_lock());
+	assert(root.IsRoot());
+
+	if (valid)
+		return;
+
+	/* mount points are counted even while the index is not
+	   valid, see AddMount() */
+	valid = true;
+	AddRecursive(root);
+}
+
+gcc_pure
+static bool
+IsIndexable(const SongFilter::Item &item)
+{
+	return item.GetTag() < TAG_NUM_OF_ITEM_TYPES &&
+		!item.GetFoldCase() && *item.GetValue() != 0;
+}
+
+bool
+SongIndex::CanFilter(const SongFilter &filter)
+{
+	for (const auto &item : filter.GetItems())
+		if (IsIndexable(item))
+			return true;
+
+	return false;
+}
+
+void
+SongIndex::Collect(unsigned tag, const char *value,
+		   std::vector<const PostingList *> &dest) const
+{
+	std::vector<const TagItem *> items;
+
+	{
+		const ScopeLock protect(tag_pool_lock);
+		tag_pool_find_items(TagType(tag), value, items);
+	}
+
+	for (const TagItem *item : items) {
+		auto i = postings.find(item);
+		if (i != postings.end())
+			dest.push_back(&i->second);
+	}
+}
+
+gcc_pure
+static bool
+IsInside(const Song &song, const Directory &base, bool recursive)
+{
+	if (!recursive)
+		return song.parent == &base;
+
+	for (const Directory *d = song.parent; d != nullptr; d = d->parent)
+		if (d == &base)
+			return true;
+
+	return false;
+}
+
+/**
+ * Determine the position of the directory in the tree: the index of
+ * each directory between the root and this one within its parent's
+ * list of children.  Comparing these lexicographically yields the
+ * order in which Directory::Walk() visits the directories' songs,
+ * because it visits a directory's songs before its children.
+ */
+static std::vector<unsigned>
+GetWalkPosition(const Directory &directory)
+{
+	std::vector<unsigned> position;
+	for (const Directory *d = &directory; !d->IsRoot(); d = d->parent) {
+		unsigned i = 0;
+		for (const auto &sibling : d->parent->children) {
+			if (&sibling == d)
+				break;
+			++i;
+		}
+
+		position.push_back(i);
+	}
+
+	std::reverse(position.begin(), position.end());
+	return position;
+}
+
+/**
+ * Sort the songs in the order in which Directory::Walk() would visit
+ * them.  The posting lists are unordered, and the tree may have been
+ * sorted or modified since the songs were indexed, so this is
+ * determined from the current tree, for the (few) matching songs
+ * only.
+ */
+static void
+SortWalkOrder(std::vector<const Song *> &songs)
+{
+	if (songs.size() < 2)
+		return;
+
+	/* group the songs by directory */
+
+	std::sort(songs.begin(), songs.end(),
+		  [](const Song *a, const Song *b){
+			  return a->parent != b->parent
+				  ? a->parent < b->parent
+				  : a < b;
+		  });
+
+	struct Group {
+		std::vector<unsigned> position;
+		size_t begin, end;
+	};
+
+	std::vector<Group> groups;
+	for (size_t i = 0; i != songs.size();) {
+		const Directory &directory = *songs[i]->parent;
+		const size_t begin = i;
+		while (i != songs.size() && songs[i]->parent == &directory)
+			++i;
+
+		groups.push_back({GetWalkPosition(directory), begin, i});
+	}
+
+	std::sort(groups.begin(), groups.end(),
+		  [](const Group &a, const Group &b){
+			  return a.position < b.position;
+		  });
+
+	/* within each directory, use the order of its song list */
+
+	std::vector<const Song *> result;
+	result.reserve(songs.size());
+
+	for (const auto &group : groups) {
+		const auto begin = std::next(songs.begin(), group.begin);
+		const auto end = std::next(songs.begin(), group.end);
+
+		if (group.end - group.begin == 1) {
+			result.push_back(*begin);
+			continue;
+		}
+
+		/* the group is sorted by address, which allows a
+		   binary search */
+		for (const auto &song : (*begin)->parent->songs)
+			if (std::binary_search(begin, end, &song))
+				result.push_back(&song);
+	}
+
+	assert(result.size() == songs.size());
+	songs.swap(result);
+}
+
+bool
+SongIndex::Visit(const Directory &base, bool recursive,
+		 const SongFilter &filter, const VisitSong &visit_song,
+		 Error &error) const
+{
+	assert(holding_db_lock());
+	assert(IsUsable());
+
+	/* find the filter item with the fewest candidates */
+
+	std::vector<const PostingList *> best, lists;
+	size_t best_size = 0;
+	bool found = false;
+
+	for (const auto &item : filter.GetItems()) {
+		if (!IsIndexable(item))
+			continue;
+
+		lists.clear();
+		Collect(item.GetTag(), item.GetValue(), lists);
+		if (item.GetTag() == TAG_ALBUM_ARTIST)
+			/* SongFilter falls back to "artist" if there
+			   is no "album artist" */
+			Collect(TAG_ARTIST, item.GetValue(), lists);
+
+		size_t size = 0;
+		for (const auto *list : lists)
+			size += list->size();
+
+		if (!found || size < best_size) {
+			best.swap(lists);
+			best_size = size;
+			found = true;
+		}
+	}
+
+	assert(found);
+
+	/* there may be several posting lists (see
+	   tag_pool_find_items()); merge them */
+
+	if (best.empty())
+		return true;
+
+	std::vector<const Song *> candidates;
+	candidates.reserve(best_size);
+	for (const auto *list : best)
+		candidates.insert(candidates.end(), list->begin(), list->end());
+
+	if (best.size() > 1) {
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(),
+					     candidates.end()),
+				 candidates.end());
+	}
+
+	/* the index only narrows down the candidates; the filter
+	   still decides */
+
+	std::vector<const Song *> matches;
+	for (const Song *song : candidates)
+		if (IsInside(*song, base, recursive) &&
+		    filter.Match(song->Export()))
+			matches.push_back(song);
+
+	SortWalkOrder(matches);
+
+	for (const Song *song : matches)
+		if (!visit_song(song->Export(), error))
+			return false;
+
+	return true;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_DB_SIMPLE_SONG_INDEX_HXX
+#define MPD_DB_SIMPLE_SONG_INDEX_HXX
+
+#include "db/Visitor.hxx"
+#include "Compiler.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <assert.h>
+
+struct Directory;
+struct Song;
+struct TagItem;
+class SongFilter;
+class Error;
+
+/**
+ * An inverted index which maps tag values to the songs which have
+ * them.  It is keyed on the interned #TagItem pointers from the tag
+ * pool, which means that building and querying it does not need to
+ * compare strings.
+ *
+ * The index is built lazily by Build() when it is first needed.
+ * After that, like #TagCounters, it is updated incrementally while
+ * songs are added, removed and modified (see Directory::AddSong(),
+ * Directory::RemoveSong(), Directory::ReplaceSongTag()), so queries
+ * stay cheap while the database is being updated.
+ *
+ * An instance is owned by the root #Directory.  All methods must be
+ * called while holding the #db_mutex; modifications require the
+ * exclusive lock, except for Build(), which needs an additional lock
+ * (see SimpleDatabase::index_mutex).
+ */
+class SongIndex {
+	/**
+	 * Has Build() been called?  Until then, modifications are
+	 * ignored.
+	 */
+	bool valid = false;
+
+	/**
+	 * The number of mount points in the tree.  Songs in mounted
+	 * databases are not indexed, so queries must fall back to
+	 * walking the tree if there are any.
+	 */
+	unsigned n_mounts = 0;
+
+	/**
+	 * The songs which have a tag value, in no particular order;
+	 * Visit() sorts the matching songs.  This is a hash set,
+	 * because removing a song from a long list (e.g. a common
+	 * genre) must not require a linear search.
+	 */
+	typedef std::unordered_set<const Song *> PostingList;
+
+	std::unordered_map<const TagItem *, PostingList> postings;
+
+public:
+	bool IsValid() const {
+		return valid;
+	}
+
+	/**
+	 * Build the index from the given tree if that has not been
+	 * done yet.
+	 */
+	void Build(const Directory &root);
+
+	/**
+	 * Can the index be used to answer queries?  Build() must be
+	 * called first.
+	 */
+	bool IsUsable() const {
+		return valid && n_mounts == 0;
+	}
+
+	void Add(const Song &song);
+	void Remove(const Song &song);
+
+	/**
+	 * Remove all songs and mount points of the given #Directory
+	 * recursively.
+	 */
+	void Remove(const Directory &directory);
+
+	void AddMount() {
+		++n_mounts;
+	}
+
+	void RemoveMount() {
+		assert(n_mounts > 0);
+
+		--n_mounts;
+	}
+
+	/**
+	 * Does the filter contain at least one item which can be
+	 * looked up in the index?  These are case sensitive exact
+	 * matches of a tag value which is not empty.
+	 */
+	gcc_pure
+	static bool CanFilter(const SongFilter &filter);
+
+	/**
+	 * Visit all songs matching the filter, in the same order as
+	 * Directory::Walk() would.
+	 *
+	 * @param base only songs within this directory are visited
+	 */
+	bool Visit(const Directory &base, bool recursive,
+		   const SongFilter &filter, const VisitSong &visit_song,
+		   Error &error) const;
+
+private:
+	void AddRecursive(const Directory &directory);
+
+	void Collect(unsigned tag, const char *value,
+		     std::vector<const PostingList *> &dest) const;
+};
+
+#endif
@@ -21,88 +21,189 @@
 #include "SongSort.hxx"
 #include "Song.hxx"
 #include "tag/Tag.hxx"
+#include "tag/TagPool.hxx"
 #include "lib/icu/Collate.hxx"
+#include "util/AllocatedString.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
 
 #include <stdlib.h>
+#include <string.h>
 
-static int
-compare_utf8_string(const char *a, const char *b)
-{
-	if (a == nullptr)
-		return b == nullptr ? 0 : -1;
+/**
+ * A #Song with its sort criteria.  They are determined once for each
+ * song before sorting, which means that comparing two songs is a
+ * cheap strcmp() on collation sort keys (see IcuSortKey()), instead
+ * of an IcuCollate() call.
+ */
+struct SongSortItem {
+	Song *song;
 
-	if (b == nullptr)
-		return 1;
+	/**
+	 * The song's (first) album name; nullptr if it has none.
+	 */
+	const char *album;
+
+	/**
+	 * The sort key of #album, cached in the tag pool (see
+	 * tag_pool_get_sort_key()); nullptr if the song has no album
+	 * or if no sort key could be generated.
+	 */
+	const char *album_key;
+
+	long disc, track;
+
+	explicit SongSortItem(Song &_song);
+};
 
-	return IcuCollate(a, b);
+/**
+ * Parse a tag value which should contain an integer value (e.g. disc
+ * or track number).  Missing, invalid and non-positive numbers are
+ * all equal and sort before the valid ones.
+ */
+gcc_pure
+static long
+ParseSortNumber(const char *s)
+{
+	long i = s == nullptr ? 0 : strtol(s, nullptr, 10);
+	return i > 0 ? i : 0;
+}
+
+SongSortItem::SongSortItem(Song &_song)
+	:song(&_song), album(nullptr), album_key(nullptr),
+	 disc(ParseSortNumber(_song.tag.GetValue(TAG_DISC))),
+	 track(ParseSortNumber(_song.tag.GetValue(TAG_TRACK)))
+{
 }
 
 /**
- * Compare two string tag values, ignoring case.  Either one may be
- * nullptr.
+ * Look up the song's (first) album name and its sort key.  The sort
+ * key is generated only once for each album and then cached in the
+ * tag pool.
+ *
+ * Caller must lock #tag_pool_lock.
+ *
+ * @return false if no sort key could be generated
  */
-static int
-compare_string_tag_item(const Tag &a, const Tag &b,
-			TagType type)
+static bool
+LoadAlbumSortKey(SongSortItem &item)
 {
-	return compare_utf8_string(a.GetValue(type),
-				   b.GetValue(type));
+	for (const auto &i : item.song->tag) {
+		if (i.type == TAG_ALBUM) {
+			item.album = i.value;
+
+			const char *key = tag_pool_get_sort_key(i);
+			if (key == nullptr) {
+				auto k = IcuSortKey(i.value);
+				if (k.IsNull())
+					return false;
+
+				key = tag_pool_set_sort_key(i, k.Steal());
+			}
+
+			item.album_key = key;
+			return true;
+		}
+	}
+
+	return true;
 }
 
 /**
- * Compare two tag values which should contain an integer value
- * (e.g. disc or track number).  Either one may be nullptr.
+ * Compare two strings with the given function.  Either one may be
+ * nullptr, which sorts first.
  */
+template<typename F>
+gcc_pure
 static int
-compare_number_string(const char *a, const char *b)
+compare_nullable(const char *a, const char *b, F &&f)
 {
-	long ai = a == nullptr ? 0 : strtol(a, nullptr, 10);
-	long bi = b == nullptr ? 0 : strtol(b, nullptr, 10);
-
-	if (ai <= 0)
-		return bi <= 0 ? 0 : -1;
+	if (a == nullptr)
+		return b == nullptr ? 0 : -1;
 
-	if (bi <= 0)
+	if (b == nullptr)
 		return 1;
 
-	return ai - bi;
+	return f(a, b);
+}
+
+gcc_pure
+static int
+compare_album_keys(const SongSortItem &a, const SongSortItem &b)
+{
+	return compare_nullable(a.album_key, b.album_key, strcmp);
 }
 
+/**
+ * Fallback for compare_album_keys() if some sort keys could not be
+ * generated.
+ */
+gcc_pure
 static int
-compare_tag_item(const Tag &a, const Tag &b, TagType type)
+compare_album_names(const SongSortItem &a, const SongSortItem &b)
 {
-	return compare_number_string(a.GetValue(type),
-				     b.GetValue(type));
+	return compare_nullable(a.album, b.album, IcuCollate);
 }
 
 /* Only used for sorting/searchin a songvec, not general purpose compares */
+template<int (*compare_album)(const SongSortItem &, const SongSortItem &)>
 gcc_pure
 static bool
-song_cmp(const Song &a, const Song &b)
+song_cmp(const SongSortItem &a, const SongSortItem &b)
 {
-	int ret;
-
 	/* first sort by album */
-	ret = compare_string_tag_item(a.tag, b.tag, TAG_ALBUM);
+	int ret = compare_album(a, b);
 	if (ret != 0)
 		return ret < 0;
 
 	/* then sort by disc */
-	ret = compare_tag_item(a.tag, b.tag, TAG_DISC);
-	if (ret != 0)
-		return ret < 0;
+	if (a.disc != b.disc)
+		return a.disc < b.disc;
 
 	/* then by track number */
-	ret = compare_tag_item(a.tag, b.tag, TAG_TRACK);
-	if (ret != 0)
-		return ret < 0;
+	if (a.track != b.track)
+		return a.track < b.track;
 
 	/* still no difference?  compare file name */
-	return IcuCollate(a.uri, b.uri) < 0;
+	return IcuCollate(a.song->uri, b.song->uri) < 0;
 }
 
 void
 song_list_sort(SongList &songs)
 {
-	songs.sort(song_cmp);
+	if (songs.empty() || std::next(songs.begin()) == songs.end())
+		/* nothing to sort */
+		return;
+
+	std::vector<SongSortItem> items;
+	for (auto &song : songs)
+		items.emplace_back(song);
+
+	bool have_keys = true;
+
+	{
+		const ScopeLock protect(tag_pool_lock);
+		for (auto &item : items)
+			if (!LoadAlbumSortKey(item))
+				have_keys = false;
+	}
+
+	/* sort keys and raw strings can't be compared with each
+	   other; if a sort key is missing, collate all album names */
+	const auto cmp = have_keys
+		? song_cmp<compare_album_keys>
+		: song_cmp<compare_album_names>;
+
+	if (std::is_sorted(items.begin(), items.end(), cmp))
+		/* this is the common case: only few directories are
+		   modified by a database update */
+		return;
+
+	std::stable_sort(items.begin(), items.end(), cmp);
+
+	songs.clear();
+	for (auto &item : items)
+		songs.push_back(*item.song);
 }
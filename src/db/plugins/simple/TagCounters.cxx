@@ -0,0 +1,189 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "config.h"
+#include "TagCounters.hxx"
+#include "Directory.hxx"
+#include "Song.hxx"
+#include "tag/Tag.hxx"
+#include "tag/TagPool.hxx"
+#include "thread/Mutex.hxx"
+
+#include <string.h>
+
+size_t
+TagCounters::ItemHash::operator()(const TagItem *item) const
+{
+	size_t hash = 5381;
+
+	for (const char *p = item->value; *p != 0; ++p)
+		hash = (hash << 5) + hash + *p;
+
+	return hash;
+}
+
+bool
+TagCounters::ItemEqual::operator()(const TagItem *a, const TagItem *b) const
+{
+	return strcmp(a->value, b->value) == 0;
+}
+
+TagCounters::TagCounters()
+	:n_mounts(0)
+{
+}
+
+TagCounters::~TagCounters()
+{
+	const ScopeLock protect(tag_pool_lock);
+	for (auto &map : items)
+		Clear(map);
+	Clear(artist_fallback);
+}
+
+void
+TagCounters::Clear(Map &map)
+{
+	for (const auto &i : map)
+		tag_pool_put_item(const_cast<TagItem *>(i.first));
+	map.clear();
+}
+
+inline void
+TagCounters::Increment(Map &map, const TagItem &item, const Tag &tag)
+{
+	auto i = map.find(&item);
+	if (i == map.end()) {
+		/* hold a reference to the value, because the song's
+		   item may be freed before this counter is */
+		const ScopeLock protect(tag_pool_lock);
+		i = map.emplace(tag_pool_dup_item(const_cast<TagItem *>(&item)),
+				SearchStats()).first;
+	}
+
+	SearchStats &stats = i->second;
+	++stats.n_songs;
+	if (!tag.duration.IsNegative())
+		stats.total_duration += tag.duration;
+}
+
+inline void
+TagCounters::Decrement(Map &map, const TagItem &item, const Tag &tag)
+{
+	auto i = map.find(&item);
+	assert(i != map.end());
+
+	SearchStats &stats = i->second;
+	assert(stats.n_songs > 0);
+
+	if (--stats.n_songs > 0) {
+		if (!tag.duration.IsNegative())
+			stats.total_duration -= tag.duration;
+		return;
+	}
+
+	const TagItem *key = i->first;
+	map.erase(i);
+
+	const ScopeLock protect(tag_pool_lock);
+	tag_pool_put_item(const_cast<TagItem *>(key));
+}
+
+void
+TagCounters::Add(const Tag &tag)
+{
+	++total.n_songs;
+	if (!tag.duration.IsNegative())
+		total.total_duration += tag.duration;
+
+	for (const auto &item : tag)
+		Increment(items[item.type], item, tag);
+
+	if (!tag.HasType(TAG_ALBUM_ARTIST))
+		for (const auto &item : tag)
+			if (item.type == TAG_ARTIST)
+				Increment(artist_fallback, item, tag);
+}
+
+void
+TagCounters::Remove(const Tag &tag)
+{
+	assert(total.n_songs > 0);
+
+	--total.n_songs;
+	if (!tag.duration.IsNegative())
+		total.total_duration -= tag.duration;
+
+	for (const auto &item : tag)
+		Decrement(items[item.type], item, tag);
+
+	if (!tag.HasType(TAG_ALBUM_ARTIST))
+		for (const auto &item : tag)
+			if (item.type == TAG_ARTIST)
+				Decrement(artist_fallback, item, tag);
+}
+
+void
+TagCounters::Add(const Directory &directory)
+{
+	if (directory.IsMount())
+		++n_mounts;
+
+	for (const auto &song : directory.songs)
+		Add(song.tag);
+
+	for (const auto &child : directory.children)
+		Add(child);
+}
+
+void
+TagCounters::Remove(const Directory &directory)
+{
+	if (directory.IsMount())
+		RemoveMount();
+
+	for (const auto &song : directory.songs)
+		Remove(song.tag);
+
+	for (const auto &child : directory.children)
+		Remove(child);
+}
+
+void
+TagCounters::GetStats(DatabaseStats &stats) const
+{
+	stats.song_count = total.n_songs;
+	stats.total_duration = total.total_duration;
+	stats.artist_count = items[TAG_ARTIST].size();
+	stats.album_count = items[TAG_ALBUM].size();
+}
+
+void
+TagCounters::VisitGroup(TagType group, const VisitGroupStats &visit) const
+{
+	assert(unsigned(group) < TAG_NUM_OF_ITEM_TYPES);
+
+	for (const auto &i : items[group])
+		visit(i.first->value, i.second);
+
+	if (group == TAG_ALBUM_ARTIST)
+		for (const auto &i : artist_fallback)
+			visit(i.first->value, i.second);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_DB_SIMPLE_TAG_COUNTERS_HXX
+#define MPD_DB_SIMPLE_TAG_COUNTERS_HXX
+
+#include "db/Stats.hxx"
+#include "db/Visitor.hxx"
+#include "tag/TagType.h"
+#include "Compiler.h"
+
+#include <unordered_map>
+
+#include <assert.h>
+
+struct Directory;
+struct Tag;
+struct TagItem;
+
+/**
+ * Aggregate counters over all songs of a #Directory tree: the number
+ * of songs and their total duration, overall and for each tag value.
+ * Unlike #SongIndex, these are not rebuilt after a modification, but
+ * updated incrementally while songs are added and removed (see
+ * Directory::AddSong(), Directory::RemoveSong(),
+ * Directory::ReplaceSongTag()), which makes "stats" and "count
+ * group" cheap even right after a database update.
+ *
+ * The tag values are kept alive by holding a reference on the
+ * #TagItem in the tag pool.
+ *
+ * An instance is owned by the root #Directory.  All methods must be
+ * called while holding the #db_mutex; modifications require the
+ * exclusive lock.
+ */
+class TagCounters {
+	struct ItemHash {
+		gcc_pure
+		size_t operator()(const TagItem *item) const;
+	};
+
+	struct ItemEqual {
+		gcc_pure
+		bool operator()(const TagItem *a, const TagItem *b) const;
+	};
+
+	/**
+	 * Maps tag values to counters.  The keys are compared by
+	 * value, not by address, because the tag pool may contain
+	 * several #TagItem instances with the same value.
+	 */
+	typedef std::unordered_map<const TagItem *, SearchStats,
+				   ItemHash, ItemEqual> Map;
+
+	SearchStats total;
+
+	/**
+	 * Counters for each tag value of all songs, one map per tag
+	 * type.
+	 */
+	Map items[TAG_NUM_OF_ITEM_TYPES];
+
+	/**
+	 * Counters for the "Artist" values of songs which have no
+	 * "AlbumArtist"; command "count group albumartist" falls back
+	 * to these.
+	 */
+	Map artist_fallback;
+
+	/**
+	 * The number of mount points in the tree.  Songs in mounted
+	 * databases are not counted, so the counters are only usable
+	 * if there are none.
+	 */
+	unsigned n_mounts;
+
+public:
+	TagCounters();
+	~TagCounters();
+
+	TagCounters(const TagCounters &) = delete;
+	TagCounters &operator=(const TagCounters &) = delete;
+
+	bool IsUsable() const {
+		return n_mounts == 0;
+	}
+
+	void Add(const Tag &tag);
+	void Remove(const Tag &tag);
+
+	/**
+	 * Add all songs and mount points of the given #Directory
+	 * recursively.
+	 */
+	void Add(const Directory &directory);
+
+	/**
+	 * Remove all songs and mount points of the given #Directory
+	 * recursively.
+	 */
+	void Remove(const Directory &directory);
+
+	void AddMount() {
+		++n_mounts;
+	}
+
+	void RemoveMount() {
+		assert(n_mounts > 0);
+
+		--n_mounts;
+	}
+
+	void GetStats(DatabaseStats &stats) const;
+
+	void VisitGroup(TagType group, const VisitGroupStats &visit) const;
+
+private:
+	static void Increment(Map &map, const TagItem &item,
+			      const Tag &tag);
+	static void Decrement(Map &map, const TagItem &item,
+			      const Tag &tag);
+
+	static void Clear(Map &map);
+};
+
+#endif
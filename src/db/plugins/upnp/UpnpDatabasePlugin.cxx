@@ -64,6 +64,7 @@ public:
 		uri = uri2.c_str();
 		real_uri = real_uri2.c_str();
 		tag = &tag2;
+		partial_tag = false;
 		mtime = 0;
 		start_time = end_time = SongTime::zero();
 	}
@@ -336,6 +337,7 @@ visitSong(const UPnPDirObject &meta, const char *path,
 	song.uri = path;
 	song.real_uri = meta.url.c_str();
 	song.tag = &meta.tag;
+	song.partial_tag = false;
 	song.mtime = 0;
 	song.start_time = song.end_time = SongTime::zero();
 
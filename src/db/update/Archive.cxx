@@ -41,7 +41,7 @@
 static Directory *
 LockFindChild(Directory &directory, const char *name)
 {
-	const ScopeDatabaseLock protect;
+	const ScopeDatabaseSharedLock protect;
 	return directory.FindChild(name);
 }
 
@@ -55,7 +55,7 @@ LockMakeChild(Directory &directory, const char *name)
 static Song *
 LockFindSong(Directory &directory, const char *name)
 {
-	const ScopeDatabaseLock protect;
+	const ScopeDatabaseSharedLock protect;
 	return directory.FindSong(name);
 }
 
@@ -95,11 +95,18 @@ UpdateWalk::UpdateArchiveTree(ArchiveFile &archive, Directory &directory,
 					      directory.GetPath(), name);
 			}
 		} else {
-			if (!song->UpdateFileInArchive(archive)) {
+			Song *result = Song::LoadFromArchive(archive, name,
+							     directory);
+			if (result == nullptr) {
 				FormatDebug(update_domain,
 					    "deleting unrecognized file %s/%s",
 					    directory.GetPath(), name);
 				editor.LockDeleteSong(directory, song);
+			} else {
+				const ScopeDatabaseLock protect;
+				directory.ReplaceSongTag(*song,
+							 std::move(result->tag));
+				result->Free();
 			}
 		}
 	}
@@ -172,7 +179,11 @@ UpdateWalk::UpdateArchiveFile(Directory &parent, const char *name,
 		directory->device = DEVICE_INARCHIVE;
 	}
 
-	directory->mtime = info.mtime;
+	{
+		const ScopeDatabaseLock protect;
+		directory->mtime = info.mtime;
+		directory->Modified();
+	}
 
 	UpdateArchiveVisitor visitor(*this, *file, directory);
 	file->Visit(visitor);
@@ -108,7 +108,8 @@ DatabaseEditor::DeleteNameIn(Directory &parent, const char *name)
 		modified = true;
 	}
 
-	parent.playlists.erase(name);
+	if (parent.playlists.erase(name))
+		parent.Modified();
 
 	return modified;
 }
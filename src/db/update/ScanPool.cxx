@@ -0,0 +1,146 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "ScanPool.hxx"
+#include "db/plugins/simple/Song.hxx"
+#include "thread/Name.hxx"
+#include "thread/Util.hxx"
+
+#include <assert.h>
+
+/**
+ * The maximum number of jobs per thread waiting in the queue.  This
+ * limits the memory usage and lets the walk thread merge results
+ * while the workers are busy.
+ */
+static constexpr unsigned MAX_PENDING_PER_THREAD = 16;
+
+ScanPool::ScanPool(Storage &_storage, unsigned _n_threads)
+	:storage(_storage), n_threads(_n_threads),
+	 threads(new Thread[_n_threads])
+{
+	assert(n_threads > 0);
+
+	for (unsigned i = 0; i < n_threads; ++i)
+		threads[i].Start(Run, this);
+}
+
+ScanPool::~ScanPool()
+{
+	{
+		const ScopeLock protect(mutex);
+		quit = true;
+		worker_cond.broadcast();
+	}
+
+	for (unsigned i = 0; i < n_threads; ++i)
+		if (threads[i].IsDefined())
+			threads[i].Join();
+
+	/* free results which have not been merged */
+	pending.splice(pending.end(), finished);
+	for (auto &job : pending)
+		if (job.result != nullptr)
+			job.result->Free();
+}
+
+void
+ScanPool::Push(Directory &directory, Song *song, const char *name)
+{
+	const ScopeLock protect(mutex);
+
+	while (pending.size() >= n_threads * MAX_PENDING_PER_THREAD)
+		finished_cond.wait(mutex);
+
+	pending.emplace_back(directory, song, name);
+	worker_cond.signal();
+}
+
+void
+ScanPool::Cancel()
+{
+	const ScopeLock protect(mutex);
+	finished.splice(finished.end(), pending);
+	finished_cond.broadcast();
+}
+
+void
+ScanPool::WaitAll()
+{
+	const ScopeLock protect(mutex);
+
+	while (!pending.empty() || busy > 0)
+		finished_cond.wait(mutex);
+}
+
+ScanPool::JobList
+ScanPool::TakeFinished(size_t min_size)
+{
+	JobList result;
+
+	const ScopeLock protect(mutex);
+	if (finished.size() >= min_size)
+		result.swap(finished);
+
+	return result;
+}
+
+inline void
+ScanPool::Run()
+{
+	SetThreadName("update_scan");
+	SetThreadIdlePriority();
+
+	JobList current;
+
+	const ScopeLock protect(mutex);
+
+	while (!quit) {
+		if (pending.empty()) {
+			worker_cond.wait(mutex);
+			continue;
+		}
+
+		current.splice(current.end(), pending, pending.begin());
+		++busy;
+
+		/* the pending list has become shorter */
+		finished_cond.broadcast();
+
+		Job &job = current.front();
+
+		{
+			const ScopeUnlock unlock(mutex);
+			job.result = Song::LoadFile(storage, job.name.c_str(),
+						    job.directory);
+		}
+
+		--busy;
+		finished.splice(finished.end(), current);
+		finished_cond.broadcast();
+	}
+}
+
+void
+ScanPool::Run(void *ctx)
+{
+	ScanPool &pool = *(ScanPool *)ctx;
+	pool.Run();
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_UPDATE_SCAN_POOL_HXX
+#define MPD_UPDATE_SCAN_POOL_HXX
+
+#include "check.h"
+#include "thread/Mutex.hxx"
+#include "thread/Cond.hxx"
+#include "thread/Thread.hxx"
+
+#include <list>
+#include <memory>
+#include <string>
+
+struct Directory;
+struct Song;
+class Storage;
+
+/**
+ * A pool of threads which load the tags of song files on behalf of
+ * #UpdateWalk.  This allows the walk to continue while files are
+ * being scanned, which helps with high-latency storages such as
+ * NFS or SMB.
+ *
+ * The worker threads do not modify the #Directory tree; the
+ * results are merged by the walk thread, see TakeFinished().
+ */
+class ScanPool {
+public:
+	struct Job {
+		Directory &directory;
+
+		/**
+		 * The existing song which is being updated, or
+		 * nullptr if this is a new file.
+		 */
+		Song *const song;
+
+		const std::string name;
+
+		/**
+		 * The result: a new #Song object which is not yet
+		 * part of the tree, or nullptr if the file could not
+		 * be loaded (or if the job was cancelled).
+		 */
+		Song *result = nullptr;
+
+		Job(Directory &_directory, Song *_song, const char *_name)
+			:directory(_directory), song(_song), name(_name) {}
+	};
+
+	typedef std::list<Job> JobList;
+
+private:
+	Storage &storage;
+
+	const unsigned n_threads;
+	std::unique_ptr<Thread[]> threads;
+
+	Mutex mutex;
+
+	/**
+	 * Signalled when a job is added to #pending or when the pool
+	 * shall quit.
+	 */
+	Cond worker_cond;
+
+	/**
+	 * Signalled when a job has been moved to #finished.
+	 */
+	Cond finished_cond;
+
+	JobList pending, finished;
+
+	/**
+	 * The number of jobs currently being worked on.
+	 */
+	unsigned busy = 0;
+
+	bool quit = false;
+
+public:
+	ScanPool(Storage &_storage, unsigned _n_threads);
+	~ScanPool();
+
+	ScanPool(const ScanPool &) = delete;
+	ScanPool &operator=(const ScanPool &) = delete;
+
+	/**
+	 * Submit a new job.  Blocks while there are too many
+	 * pending jobs.
+	 */
+	void Push(Directory &directory, Song *song, const char *name);
+
+	/**
+	 * Discard all jobs which have not been started yet.  They
+	 * will be returned by TakeFinished() without a result.
+	 */
+	void Cancel();
+
+	/**
+	 * Wait until all submitted jobs are finished.
+	 */
+	void WaitAll();
+
+	/**
+	 * Remove the finished jobs and return them.  Does nothing
+	 * if there are fewer than the specified number.
+	 */
+	JobList TakeFinished(size_t min_size=1);
+
+private:
+	void Run();
+	static void Run(void *ctx);
+};
+
+#endif
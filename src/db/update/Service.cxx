@@ -77,7 +77,7 @@ UpdateService::CancelMount(const char *uri)
 
 	Directory::LookupResult lr;
 	{
-		const ScopeDatabaseLock protect;
+		const ScopeDatabaseSharedLock protect;
 		lr = db.GetRoot().LookupDirectory(uri);
 	}
 
@@ -185,7 +185,7 @@ UpdateService::Enqueue(const char *path, bool discard)
 
 	Directory::LookupResult lr;
 	{
-		const ScopeDatabaseLock protect;
+		const ScopeDatabaseSharedLock protect;
 		lr = db.GetRoot().LookupDirectory(path);
 	}
 
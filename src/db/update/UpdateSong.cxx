@@ -19,6 +19,7 @@
 
 #include "config.h" /* must be first for large file support */
 #include "Walk.hxx"
+#include "ScanPool.hxx"
 #include "UpdateIO.hxx"
 #include "UpdateDomain.hxx"
 #include "db/DatabaseLock.hxx"
@@ -28,6 +29,7 @@
 #include "storage/FileInfo.hxx"
 #include "Log.hxx"
 
+#include <assert.h>
 #include <unistd.h>
 
 inline void
@@ -37,7 +39,7 @@ UpdateWalk::UpdateSongFile2(Directory &directory,
 {
 	Song *song;
 	{
-		const ScopeDatabaseLock protect;
+		const ScopeDatabaseSharedLock protect;
 		song = directory.FindSong(name);
 	}
 
@@ -63,6 +65,13 @@ UpdateWalk::UpdateSongFile2(Directory &directory,
 	if (song == nullptr) {
 		FormatDebug(update_domain, "reading %s/%s",
 			    directory.GetPath(), name);
+
+		if (scan_pool) {
+			scan_pool->Push(directory, nullptr, name);
+			MergeScans(false);
+			return;
+		}
+
 		song = Song::LoadFile(storage, name, directory);
 		if (song == nullptr) {
 			FormatDebug(update_domain,
@@ -82,11 +91,87 @@ UpdateWalk::UpdateSongFile2(Directory &directory,
 	} else if (info.mtime != song->mtime || walk_discard) {
 		FormatDefault(update_domain, "updating %s/%s",
 			      directory.GetPath(), name);
-		if (!song->UpdateFile(storage)) {
+
+		if (scan_pool) {
+			scan_pool->Push(directory, song, name);
+			MergeScans(false);
+			return;
+		}
+
+		/* load the new tag into a temporary Song object, so
+		   the TagCounters can be updated by
+		   Directory::ReplaceSongTag() */
+		Song *result = Song::LoadFile(storage, name, directory);
+		if (result == nullptr) {
 			FormatDebug(update_domain,
 				    "deleting unrecognized file %s/%s",
 				    directory.GetPath(), name);
 			editor.LockDeleteSong(directory, song);
+		} else {
+			const ScopeDatabaseLock protect;
+			song->mtime = result->mtime;
+			directory.ReplaceSongTag(*song, std::move(result->tag));
+			result->Free();
+		}
+
+		modified = true;
+	}
+}
+
+/**
+ * The minimum number of finished jobs merged into the tree at a time,
+ * to reduce contention on the database lock.
+ */
+static constexpr size_t SCAN_MERGE_BATCH = 64;
+
+void
+UpdateWalk::MergeScans(bool wait)
+{
+	assert(scan_pool);
+
+	if (wait)
+		scan_pool->WaitAll();
+
+	auto jobs = scan_pool->TakeFinished(wait ? 1 : SCAN_MERGE_BATCH);
+	if (jobs.empty())
+		return;
+
+	const ScopeDatabaseLock protect;
+
+	for (auto &job : jobs) {
+		Directory &directory = job.directory;
+		Song *result = job.result;
+
+		if (job.song == nullptr) {
+			/* a new file */
+
+			if (result == nullptr) {
+				if (!cancel)
+					FormatDebug(update_domain,
+						    "ignoring unrecognized file %s/%s",
+						    directory.GetPath(),
+						    job.name.c_str());
+				continue;
+			}
+
+			directory.AddSong(result);
+			FormatDefault(update_domain, "added %s/%s",
+				      directory.GetPath(), job.name.c_str());
+		} else if (result != nullptr) {
+			/* an existing song was modified */
+
+			Song &song = *job.song;
+			song.mtime = result->mtime;
+			directory.ReplaceSongTag(song, std::move(result->tag));
+			result->Free();
+		} else if (cancel) {
+			/* the job was not started; keep the old song */
+			continue;
+		} else {
+			FormatDebug(update_domain,
+				    "deleting unrecognized file %s/%s",
+				    directory.GetPath(), job.name.c_str());
+			editor.DeleteSong(directory, job.song);
 		}
 
 		modified = true;
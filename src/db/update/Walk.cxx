@@ -19,6 +19,7 @@
 
 #include "config.h" /* must be first for large file support */
 #include "Walk.hxx"
+#include "ScanPool.hxx"
 #include "UpdateIO.hxx"
 #include "Editor.hxx"
 #include "UpdateDomain.hxx"
@@ -63,6 +64,15 @@ UpdateWalk::UpdateWalk(EventLoop &_loop, DatabaseListener &_listener,
 		config_get_bool(ConfigOption::FOLLOW_OUTSIDE_SYMLINKS,
 				DEFAULT_FOLLOW_OUTSIDE_SYMLINKS);
 #endif
+
+	const unsigned n_threads =
+		config_get_positive(ConfigOption::UPDATE_THREADS, 1);
+	if (n_threads > 1)
+		scan_pool.reset(new ScanPool(storage, n_threads));
+}
+
+UpdateWalk::~UpdateWalk()
+{
 }
 
 static void
@@ -127,6 +137,7 @@ UpdateWalk::PurgeDeletedFromDirectory(Directory &directory)
 						i->name.c_str())) {
 			const ScopeDatabaseLock protect;
 			i = directory.playlists.erase(i);
+			directory.Modified();
 		} else
 			++i;
 	}
@@ -194,8 +205,10 @@ UpdateWalk::UpdatePlaylistFile(Directory &directory,
 	PlaylistInfo pi(name, info.mtime);
 
 	const ScopeDatabaseLock protect;
-	if (directory.playlists.UpdateOrInsert(std::move(pi)))
+	if (directory.playlists.UpdateOrInsert(std::move(pi))) {
+		directory.Modified();
 		modified = true;
+	}
 	return true;
 }
 
@@ -379,7 +392,11 @@ UpdateWalk::UpdateDirectory(Directory &directory,
 		UpdateDirectoryChild(directory, child_exclude_list, name_utf8, info2);
 	}
 
-	directory.mtime = info.mtime;
+	if (directory.mtime != info.mtime) {
+		const ScopeDatabaseLock protect;
+		directory.mtime = info.mtime;
+		directory.Modified();
+	}
 
 	return true;
 }
@@ -391,7 +408,7 @@ UpdateWalk::DirectoryMakeChildChecked(Directory &parent,
 {
 	Directory *directory;
 	{
-		const ScopeDatabaseLock protect;
+		const ScopeDatabaseSharedLock protect;
 		directory = parent.FindChild(name_utf8);
 	}
 
@@ -496,5 +513,12 @@ UpdateWalk::Walk(Directory &root, const char *path, bool discard)
 		UpdateDirectory(root, exclude_list, info);
 	}
 
+	if (scan_pool) {
+		if (cancel)
+			scan_pool->Cancel();
+
+		MergeScans(true);
+	}
+
 	return modified;
 }
@@ -24,12 +24,15 @@
 #include "Editor.hxx"
 #include "Compiler.h"
 
+#include <memory>
+
 struct StorageFileInfo;
 struct Directory;
 struct ArchivePlugin;
 class ArchiveFile;
 class Storage;
 class ExcludeList;
+class ScanPool;
 
 class UpdateWalk final {
 #ifdef ENABLE_ARCHIVE
@@ -58,9 +61,17 @@ class UpdateWalk final {
 
 	DatabaseEditor editor;
 
+	/**
+	 * Loads song tags in worker threads; nullptr if the update
+	 * is configured to run in a single thread (see
+	 * "update_threads").
+	 */
+	std::unique_ptr<ScanPool> scan_pool;
+
 public:
 	UpdateWalk(EventLoop &_loop, DatabaseListener &_listener,
 		   Storage &_storage);
+	~UpdateWalk();
 
 	/**
 	 * Cancel the current update and quit the Walk() method as
@@ -85,6 +96,14 @@ private:
 
 	void PurgeDeletedFromDirectory(Directory &directory);
 
+	/**
+	 * Merge the songs loaded by the #scan_pool into the tree.
+	 *
+	 * @param wait wait for all jobs to finish, and merge even a
+	 * partial batch
+	 */
+	void MergeScans(bool wait);
+
 	void UpdateSongFile2(Directory &directory,
 			     const char *name, const char *suffix,
 			     const StorageFileInfo &info);
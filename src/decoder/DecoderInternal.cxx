@@ -25,6 +25,7 @@
 #include "MusicBuffer.hxx"
 #include "MusicChunk.hxx"
 #include "tag/Tag.hxx"
+#include "PipelineStats.hxx"
 
 #include <assert.h>
 
@@ -97,8 +98,10 @@ Decoder::FlushChunk()
 
 	if (chunk->IsEmpty())
 		dc.buffer->Return(chunk);
-	else
+	else {
+		chunk->decoded_time = pipeline_stats_now();
 		dc.pipe->Push(chunk);
+	}
 
 	chunk = nullptr;
 
@@ -23,6 +23,8 @@
 
 #include <assert.h>
 
+Mutex decoder_plugin_scan_mutex;
+
 bool
 DecoderPlugin::SupportsSuffix(const char *suffix) const
 {
@@ -20,6 +20,7 @@
 #ifndef MPD_DECODER_PLUGIN_HXX
 #define MPD_DECODER_PLUGIN_HXX
 
+#include "thread/Mutex.hxx"
 #include "Compiler.h"
 
 struct ConfigBlock;
@@ -34,6 +35,12 @@ template<typename T> class AllocatedString;
  */
 struct Decoder;
 
+/**
+ * Serializes calls to scan_file() and scan_stream() of plugins which
+ * don't set DecoderPlugin::scan_thread_safe.
+ */
+extern Mutex decoder_plugin_scan_mutex;
+
 struct DecoderPlugin {
 	const char *name;
 
@@ -103,6 +110,15 @@ struct DecoderPlugin {
 	const char *const*suffixes;
 	const char *const*mime_types;
 
+	/**
+	 * May scan_file() and scan_stream() be called from several
+	 * threads at the same time?  If false (the default), the
+	 * database update serializes these calls (see
+	 * "update_threads"), because the plugin or its library keeps
+	 * global state.
+	 */
+	bool scan_thread_safe;
+
 	/**
 	 * Initialize a decoder plugin.
 	 *
@@ -145,9 +161,14 @@ struct DecoderPlugin {
 	template<typename P>
 	bool ScanFile(P path_fs,
 		      const TagHandler &handler, void *handler_ctx) const {
-		return scan_file != nullptr
-			? scan_file(path_fs, handler, handler_ctx)
-			: false;
+		if (scan_file == nullptr)
+			return false;
+
+		if (scan_thread_safe)
+			return scan_file(path_fs, handler, handler_ctx);
+
+		const ScopeLock protect(decoder_plugin_scan_mutex);
+		return scan_file(path_fs, handler, handler_ctx);
 	}
 
 	/**
@@ -155,9 +176,14 @@ struct DecoderPlugin {
 	 */
 	bool ScanStream(InputStream &is,
 			const TagHandler &handler, void *handler_ctx) const {
-		return scan_stream != nullptr
-			? scan_stream(is, handler, handler_ctx)
-			: false;
+		if (scan_stream == nullptr)
+			return false;
+
+		if (scan_thread_safe)
+			return scan_stream(is, handler, handler_ctx);
+
+		const ScopeLock protect(decoder_plugin_scan_mutex);
+		return scan_stream(is, handler, handler_ctx);
 	}
 
 	/**
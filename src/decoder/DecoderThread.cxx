@@ -387,14 +387,9 @@ try {
  */
 static void
 decoder_run_song(DecoderControl &dc,
-		 const DetachedSong &song, const char *uri, Path path_fs)
+		 DetachedSong &song, const char *uri, Path path_fs)
 {
-	Decoder decoder(dc, dc.start_time.IsPositive(),
-			/* pass the song tag only if it's
-			   authoritative, i.e. if it's a local file -
-			   tags on "stream" songs are just remembered
-			   from the last time we played it*/
-			song.IsFile() ? new Tag(song.GetTag()) : nullptr);
+	Decoder decoder(dc, dc.start_time.IsPositive(), nullptr);
 
 	dc.state = DecoderState::START;
 	dc.CommandFinishedLocked();
@@ -403,6 +398,18 @@ decoder_run_song(DecoderControl &dc,
 	{
 		const ScopeUnlock unlock(dc.mutex);
 
+		/* the queue has only the tags which the database keeps
+		   in memory; load the rest here, because this may
+		   block for disk I/O */
+		song.CompleteTag();
+
+		/* pass the song tag only if it's authoritative,
+		   i.e. if it's a local file - tags on "stream" songs
+		   are just remembered from the last time we played
+		   it*/
+		if (song.IsFile())
+			decoder.song_tag = new Tag(song.GetTag());
+
 		success = DecoderUnlockedRunUri(decoder, uri, path_fs);
 
 		/* flush the last chunk */
@@ -443,7 +450,7 @@ decoder_run(DecoderControl &dc)
 	dc.ClearError();
 
 	assert(dc.song != nullptr);
-	const DetachedSong &song = *dc.song;
+	DetachedSong &song = *dc.song;
 
 	const char *const uri_utf8 = song.GetRealURI();
 
@@ -145,4 +145,5 @@ const struct DecoderPlugin adplug_decoder_plugin = {
 	nullptr,
 	adplug_suffixes,
 	nullptr,
+	false,
 };
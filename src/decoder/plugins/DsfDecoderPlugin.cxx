@@ -380,4 +380,5 @@ const struct DecoderPlugin dsf_decoder_plugin = {
 	nullptr,
 	dsf_suffixes,
 	dsf_mime_types,
+	true,
 };
@@ -312,4 +312,5 @@ const struct DecoderPlugin gme_decoder_plugin = {
 	gme_container_scan,
 	gme_suffixes,
 	nullptr,
+	false,
 };
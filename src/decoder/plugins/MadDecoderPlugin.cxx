@@ -1108,4 +1108,5 @@ const struct DecoderPlugin mad_decoder_plugin = {
 	nullptr,
 	mp3_suffixes,
 	mp3_mime_types,
+	true,
 };
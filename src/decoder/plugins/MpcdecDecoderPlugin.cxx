@@ -272,4 +272,5 @@ const struct DecoderPlugin mpcdec_decoder_plugin = {
 	nullptr,
 	mpcdec_suffixes,
 	nullptr,
+	true,
 };
@@ -339,4 +339,5 @@ const struct DecoderPlugin mpg123_decoder_plugin = {
 	nullptr,
 	mpg123_suffixes,
 	nullptr,
+	true,
 };
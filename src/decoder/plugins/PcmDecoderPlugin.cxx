@@ -185,4 +185,5 @@ const struct DecoderPlugin pcm_decoder_plugin = {
 	nullptr,
 	nullptr,
 	pcm_mime_types,
+	false,
 };
@@ -379,4 +379,5 @@ const struct DecoderPlugin sidplay_decoder_plugin = {
 	sidplay_container_scan,
 	sidplay_suffixes,
 	nullptr, /* mime_types */
+	false,
 };
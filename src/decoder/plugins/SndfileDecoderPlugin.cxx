@@ -336,4 +336,5 @@ const struct DecoderPlugin sndfile_decoder_plugin = {
 	nullptr,
 	sndfile_suffixes,
 	sndfile_mime_types,
+	true,
 };
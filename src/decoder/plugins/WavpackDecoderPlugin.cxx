@@ -583,5 +583,6 @@ const struct DecoderPlugin wavpack_decoder_plugin = {
 	nullptr,
 	nullptr,
 	wavpack_suffixes,
-	wavpack_mime_types
+	wavpack_mime_types,
+	true,
 };
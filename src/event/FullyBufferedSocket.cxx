@@ -107,6 +107,9 @@ FullyBufferedSocket::OnSocketReady(unsigned flags)
 
 		if (!Flush())
 			return false;
+
+		if (IsOutputEmpty() && !OnSocketDrained())
+			return false;
 	}
 
 	if (!BufferedSocket::OnSocketReady(flags))
@@ -118,6 +121,11 @@ FullyBufferedSocket::OnSocketReady(unsigned flags)
 void
 FullyBufferedSocket::OnIdle()
 {
-	if (Flush() && !output.IsEmpty())
+	if (!Flush())
+		return;
+
+	if (!output.IsEmpty())
 		ScheduleWrite();
+	else
+		OnSocketDrained();
 }
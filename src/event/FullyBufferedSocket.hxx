@@ -61,6 +61,21 @@ protected:
 	 */
 	bool Write(const void *data, size_t length);
 
+	bool IsOutputEmpty() const {
+		return output.IsEmpty();
+	}
+
+	/**
+	 * The output buffer has been sent to the socket completely.
+	 * The method may write more data, e.g. the next portion of a
+	 * huge response.
+	 *
+	 * @return false if the socket has been closed
+	 */
+	virtual bool OnSocketDrained() {
+		return true;
+	}
+
 	virtual bool OnSocketReady(unsigned flags) override;
 	virtual void OnIdle() override;
 };
@@ -26,12 +26,13 @@
 #define MPD_FILTER_INTERNAL_HXX
 
 #include "AudioFormat.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <stddef.h>
 
 struct AudioFormat;
 class Error;
-template<typename T> struct ConstBuffer;
 
 class Filter {
 protected:
@@ -58,9 +59,46 @@ public:
 	 * @param error location to store the error occurring
 	 * @return the destination buffer on success (will be
 	 * invalidated by deleting this object or the next FilterPCM()
-	 * call), nullptr on error
+	 * call), nullptr on error; this is either #src or a buffer
+	 * owned by this object
 	 */
 	virtual ConstBuffer<void> FilterPCM(ConstBuffer<void> src, Error &error) = 0;
+
+	/**
+	 * Like FilterPCM(), but the filter is allowed to modify the
+	 * input buffer instead of copying the result into a private
+	 * buffer.  Filters which can operate in place should
+	 * override this method; the default implementation calls
+	 * FilterPCM().
+	 *
+	 * @return the destination buffer on success (either #src or
+	 * a buffer owned by this object; the caller may modify it
+	 * until the next call), nullptr on error
+	 */
+	virtual WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+						   Error &error) {
+		auto dest = FilterPCM({src.data, src.size}, error);
+		return { const_cast<void *>(dest.data), dest.size };
+	}
+
+	/**
+	 * Calls FilterInPlace() if #writable is true, and FilterPCM()
+	 * otherwise.  On return, #writable tells whether the caller
+	 * owns the returned buffer, i.e. whether it may be passed to
+	 * FilterInPlace().
+	 */
+	ConstBuffer<void> FilterMaybeInPlace(ConstBuffer<void> src,
+					     bool &writable, Error &error) {
+		if (writable) {
+			auto dest = FilterInPlace({const_cast<void *>(src.data),
+						   src.size}, error);
+			return { dest.data, dest.size };
+		}
+
+		auto dest = FilterPCM(src, error);
+		writable = dest.data != src.data;
+		return dest;
+	}
 };
 
 class PreparedFilter {
@@ -36,6 +36,12 @@ extern const struct filter_plugin normalize_filter_plugin;
 extern const struct filter_plugin volume_filter_plugin;
 extern const struct filter_plugin replay_gain_filter_plugin;
 
+/**
+ * A nullptr-terminated list of all filter plugins which can be
+ * configured with a "filter" block.
+ */
+extern const struct filter_plugin *const filter_plugins[];
+
 gcc_pure
 const struct filter_plugin *
 filter_plugin_by_name(const char *name);
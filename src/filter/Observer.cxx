@@ -21,6 +21,7 @@
 #include "Observer.hxx"
 #include "FilterInternal.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <assert.h>
 
@@ -76,6 +77,11 @@ public:
 				    Error &error) override {
 		return filter->FilterPCM(src, error);
 	}
+
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override {
+		return filter->FilterInPlace(src, error);
+	}
 };
 
 Filter *
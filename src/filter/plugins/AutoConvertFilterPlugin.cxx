@@ -25,6 +25,7 @@
 #include "filter/FilterRegistry.hxx"
 #include "AudioFormat.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <assert.h>
 
@@ -51,6 +52,8 @@ public:
 
 	virtual ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 					    Error &error) override;
+	virtual WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+						   Error &error) override;
 };
 
 class PreparedAutoConvertFilter final : public PreparedFilter {
@@ -110,6 +113,18 @@ AutoConvertFilter::FilterPCM(ConstBuffer<void> src, Error &error)
 	return filter->FilterPCM(src, error);
 }
 
+WritableBuffer<void>
+AutoConvertFilter::FilterInPlace(WritableBuffer<void> src, Error &error)
+{
+	if (convert != nullptr) {
+		src = convert->FilterInPlace(src, error);
+		if (src.IsNull())
+			return nullptr;
+	}
+
+	return filter->FilterInPlace(src, error);
+}
+
 PreparedFilter *
 autoconvert_filter_new(PreparedFilter *filter)
 {
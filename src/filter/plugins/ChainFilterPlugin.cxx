@@ -26,6 +26,7 @@
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <memory>
 #include <list>
@@ -64,6 +65,20 @@ public:
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 					    Error &error) override;
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override;
+
+private:
+	/**
+	 * Feed the data through all children.  As soon as the data
+	 * is in a buffer owned by us (or by a child), the following
+	 * children operate in place, therefore the data is copied
+	 * at most once by filters which don't change its size.
+	 *
+	 * @param writable true if the caller allows modifying #src
+	 */
+	ConstBuffer<void> Run(ConstBuffer<void> src, bool writable,
+			      Error &error);
 };
 
 class PreparedChainFilter final : public PreparedFilter {
@@ -144,13 +159,13 @@ PreparedChainFilter::Open(AudioFormat &in_audio_format, Error &error)
 	return chain.release();
 }
 
-ConstBuffer<void>
-ChainFilter::FilterPCM(ConstBuffer<void> src, Error &error)
+inline ConstBuffer<void>
+ChainFilter::Run(ConstBuffer<void> src, bool writable, Error &error)
 {
 	for (auto &child : children) {
 		/* feed the output of the previous filter as input
 		   into the current one */
-		src = child.filter->FilterPCM(src, error);
+		src = child.filter->FilterMaybeInPlace(src, writable, error);
 		if (src.IsNull())
 			return nullptr;
 	}
@@ -159,6 +174,19 @@ ChainFilter::FilterPCM(ConstBuffer<void> src, Error &error)
 	return src;
 }
 
+ConstBuffer<void>
+ChainFilter::FilterPCM(ConstBuffer<void> src, Error &error)
+{
+	return Run(src, false, error);
+}
+
+WritableBuffer<void>
+ChainFilter::FilterInPlace(WritableBuffer<void> src, Error &error)
+{
+	auto dest = Run({src.data, src.size}, true, error);
+	return { const_cast<void *>(dest.data), dest.size };
+}
+
 const struct filter_plugin chain_filter_plugin = {
 	"chain",
 	chain_filter_init,
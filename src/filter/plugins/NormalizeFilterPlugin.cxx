@@ -25,6 +25,7 @@
 #include "AudioFormat.hxx"
 #include "AudioCompress/compress.h"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <string.h>
 
@@ -45,6 +46,8 @@ public:
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 				    Error &error) override;
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override;
 };
 
 class PreparedNormalizeFilter final : public PreparedFilter {
@@ -78,6 +81,15 @@ NormalizeFilter::FilterPCM(ConstBuffer<void> src, gcc_unused Error &error)
 	return { (const void *)dest, src.size };
 }
 
+WritableBuffer<void>
+NormalizeFilter::FilterInPlace(WritableBuffer<void> src,
+			       gcc_unused Error &error)
+{
+	Compressor_Process_int16(compressor, (int16_t *)src.data,
+				 src.size / 2);
+	return src;
+}
+
 const struct filter_plugin normalize_filter_plugin = {
 	"normalize",
 	normalize_filter_init,
@@ -28,6 +28,7 @@
 #include "mixer/MixerControl.hxx"
 #include "pcm/Volume.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 #include "util/Error.hxx"
 #include "util/Domain.hxx"
 #include "Log.hxx"
@@ -110,6 +111,8 @@ public:
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 				    Error &error) override;
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override;
 };
 
 class PreparedReplayGainFilter final : public PreparedFilter {
@@ -192,6 +195,12 @@ ReplayGainFilter::FilterPCM(ConstBuffer<void> src, gcc_unused Error &error)
 	return pv.Apply(src);
 }
 
+WritableBuffer<void>
+ReplayGainFilter::FilterInPlace(WritableBuffer<void> src, gcc_unused Error &error)
+{
+	return pv.ApplyInPlace(src);
+}
+
 const struct filter_plugin replay_gain_filter_plugin = {
 	"replay_gain",
 	replay_gain_filter_init,
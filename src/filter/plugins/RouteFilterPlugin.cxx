@@ -50,6 +50,7 @@
 #include "util/StringUtil.hxx"
 #include "util/Error.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 #include <algorithm>
 #include <array>
@@ -57,6 +58,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <assert.h>
 
 class RouteFilter final : public Filter {
 	/**
@@ -96,6 +98,15 @@ public:
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 				    Error &error) override;
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override;
+
+private:
+	/**
+	 * Perform the copy operations for one frame.  The buffers
+	 * must not overlap.
+	 */
+	void RouteFrame(uint8_t *dest, const uint8_t *src) const;
 };
 
 class PreparedRouteFilter final : public PreparedFilter {
@@ -246,13 +257,36 @@ PreparedRouteFilter::Open(AudioFormat &audio_format, gcc_unused Error &error)
 	return new RouteFilter(audio_format, min_output_channels, sources);
 }
 
+inline void
+RouteFilter::RouteFrame(uint8_t *dest, const uint8_t *src) const
+{
+	const size_t bytes_per_frame_per_channel = input_format.GetSampleSize();
+
+	// Need to perform one copy per output channel
+	for (unsigned c = 0; c < out_audio_format.channels; ++c) {
+		if (sources[c] == -1 ||
+		    (unsigned)sources[c] >= input_format.channels) {
+			// No source for this destination output,
+			// give it zeroes as input
+			memset(dest, 0x00, bytes_per_frame_per_channel);
+		} else {
+			// Get the data from channel sources[c]
+			// and copy it to the output
+			memcpy(dest,
+			       src + sources[c] * bytes_per_frame_per_channel,
+			       bytes_per_frame_per_channel);
+		}
+
+		// Move on to the next output channel
+		dest += bytes_per_frame_per_channel;
+	}
+}
+
 ConstBuffer<void>
 RouteFilter::FilterPCM(ConstBuffer<void> src, gcc_unused Error &error)
 {
 	size_t number_of_frames = src.size / input_frame_size;
 
-	const size_t bytes_per_frame_per_channel = input_format.GetSampleSize();
-
 	// A moving pointer that always refers to channel 0 in the input, at the currently handled frame
 	const uint8_t *base_source = (const uint8_t *)src.data;
 
@@ -260,43 +294,46 @@ RouteFilter::FilterPCM(ConstBuffer<void> src, gcc_unused Error &error)
 	const size_t result_size = number_of_frames * output_frame_size;
 	void *const result = output_buffer.Get(result_size);
 
-	// A moving pointer that always refers to the currently filled channel of the currently handled frame, in the output
-	uint8_t *chan_destination = (uint8_t *)result;
+	// A moving pointer that always refers to the current frame, in the output
+	uint8_t *destination = (uint8_t *)result;
 
 	// Perform our copy operations, with N input channels and M output channels
 	for (unsigned int s=0; s<number_of_frames; ++s) {
-
-		// Need to perform one copy per output channel
-		for (unsigned c = 0; c < out_audio_format.channels; ++c) {
-			if (sources[c] == -1 ||
-			    (unsigned)sources[c] >= input_format.channels) {
-				// No source for this destination output,
-				// give it zeroes as input
-				memset(chan_destination,
-					0x00,
-					bytes_per_frame_per_channel);
-			} else {
-				// Get the data from channel sources[c]
-				// and copy it to the output
-				const uint8_t *data = base_source +
-					(sources[c] * bytes_per_frame_per_channel);
-				memcpy(chan_destination,
-					  data,
-					  bytes_per_frame_per_channel);
-			}
-			// Move on to the next output channel
-			chan_destination += bytes_per_frame_per_channel;
-		}
-
+		RouteFrame(destination, base_source);
 
 		// Go on to the next N input samples
 		base_source += input_frame_size;
+		destination += output_frame_size;
 	}
 
 	// Here it is, ladies and gentlemen! Rerouted data!
 	return { result, result_size };
 }
 
+WritableBuffer<void>
+RouteFilter::FilterInPlace(WritableBuffer<void> src, Error &error)
+{
+	if (output_frame_size != input_frame_size)
+		/* the frame size changes, can't do that in place */
+		return Filter::FilterInPlace(src, error);
+
+	size_t number_of_frames = src.size / input_frame_size;
+	uint8_t *p = (uint8_t *)src.data;
+
+	/* each frame is copied to a small stack buffer, and then
+	   routed back into the same location */
+	uint8_t frame[MAX_CHANNELS * 8];
+	assert(input_frame_size <= sizeof(frame));
+
+	for (size_t s = 0; s < number_of_frames; ++s) {
+		memcpy(frame, p, input_frame_size);
+		RouteFrame(p, frame);
+		p += input_frame_size;
+	}
+
+	return src;
+}
+
 const struct filter_plugin route_filter_plugin = {
 	"route",
 	route_filter_init,
@@ -25,6 +25,7 @@
 #include "pcm/Volume.hxx"
 #include "AudioFormat.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 
 class VolumeFilter final : public Filter {
 	PcmVolume pv;
@@ -48,6 +49,8 @@ public:
 	/* virtual methods from class Filter */
 	ConstBuffer<void> FilterPCM(ConstBuffer<void> src,
 				    Error &error) override;
+	WritableBuffer<void> FilterInPlace(WritableBuffer<void> src,
+					   Error &error) override;
 };
 
 class PreparedVolumeFilter final : public PreparedFilter {
@@ -83,6 +86,12 @@ VolumeFilter::FilterPCM(ConstBuffer<void> src, gcc_unused Error &error)
 	return pv.Apply(src);
 }
 
+WritableBuffer<void>
+VolumeFilter::FilterInPlace(WritableBuffer<void> src, gcc_unused Error &error)
+{
+	return pv.ApplyInPlace(src);
+}
+
 const struct filter_plugin volume_filter_plugin = {
 	"volume",
 	volume_filter_init,
@@ -214,3 +214,87 @@ try {
 } catch (const std::runtime_error &) {
 	return AllocatedString<>::Duplicate(src);
 }
+
+AllocatedString<>
+IcuSortKey(const char *src)
+try {
+#ifdef HAVE_ICU
+	assert(collator != nullptr);
+#if !CLANG_CHECK_VERSION(3,6)
+	/* disabled on clang due to -Wtautological-pointer-compare */
+	assert(src != nullptr);
+#endif
+
+	/* substitute malformed sequences with U+FFFD, just like
+	   ucol_strcollUTF8() does */
+	const size_t src_length = strlen(src);
+	AllocatedArray<UChar> u(src_length);
+	int32_t u_length;
+	UErrorCode error_code = U_ZERO_ERROR;
+	u_strFromUTF8WithSub(u.begin(), u.size(), &u_length,
+			     src, src_length, 0xfffd, nullptr,
+			     &error_code);
+	if (U_FAILURE(error_code))
+		return AllocatedString<>::Null();
+
+	/* the key is usually not much longer than the string; the
+	   size includes the null terminator */
+	int32_t size = 2 * u_length + 16;
+	std::unique_ptr<char[]> buffer(new char[size]);
+	int32_t needed = ucol_getSortKey(collator, u.begin(), u_length,
+					 (uint8_t *)buffer.get(), size);
+	if (needed > size) {
+		/* buffer too small - reallocate and try again */
+		buffer.reset();
+		size = needed;
+		buffer.reset(new char[size]);
+		needed = ucol_getSortKey(collator, u.begin(), u_length,
+					 (uint8_t *)buffer.get(), size);
+	}
+
+	if (needed <= 0 || needed > size)
+		return AllocatedString<>::Null();
+
+	return AllocatedString<>::Donate(buffer.release());
+
+#elif defined(WIN32)
+	const auto u = MultiByteToWideChar(CP_UTF8, src);
+
+	/* with LCMAP_SORTKEY, the destination is a byte array, and
+	   the sizes are specified in bytes */
+	const int size = LCMapStringEx(LOCALE_NAME_INVARIANT,
+				       LCMAP_SORTKEY|LINGUISTIC_IGNORECASE,
+				       u.c_str(), -1, nullptr, 0,
+				       nullptr, nullptr, 0);
+	if (size <= 0)
+		return AllocatedString<>::Null();
+
+	std::unique_ptr<char[]> buffer(new char[size]);
+	if (LCMapStringEx(LOCALE_NAME_INVARIANT,
+			  LCMAP_SORTKEY|LINGUISTIC_IGNORECASE,
+			  u.c_str(), -1, (LPWSTR)buffer.get(), size,
+			  nullptr, nullptr, 0) <= 0)
+		return AllocatedString<>::Null();
+
+	return AllocatedString<>::Donate(buffer.release());
+
+#else
+	size_t size = strlen(src) + 1;
+	std::unique_ptr<char[]> buffer(new char[size]);
+	size_t nbytes = strxfrm(buffer.get(), src, size);
+	if (nbytes >= size) {
+		/* buffer too small - reallocate and try again */
+		buffer.reset();
+		size = nbytes + 1;
+		buffer.reset(new char[size]);
+		nbytes = strxfrm(buffer.get(), src, size);
+	}
+
+	assert(nbytes < size);
+	assert(buffer[nbytes] == 0);
+
+	return AllocatedString<>::Donate(buffer.release());
+#endif
+} catch (const std::runtime_error &) {
+	return AllocatedString<>::Null();
+}
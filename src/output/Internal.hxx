@@ -23,7 +23,9 @@
 #include "AudioFormat.hxx"
 #include "pcm/PcmBuffer.hxx"
 #include "pcm/PcmDither.hxx"
+#include "util/AllocatedArray.hxx"
 #include "ReplayGainInfo.hxx"
+#include "PipelineStats.hxx"
 #include "filter/Observer.hxx"
 #include "thread/Mutex.hxx"
 #include "thread/Cond.hxx"
@@ -36,6 +38,7 @@ class Filter;
 class MusicPipe;
 class EventLoop;
 class Mixer;
+class SharedResampler;
 class MixerListener;
 struct MusicChunk;
 struct ConfigBlock;
@@ -177,11 +180,40 @@ struct AudioOutput {
 	 */
 	AudioFormat out_audio_format;
 
+	/**
+	 * If not nullptr, the chunks are resampled by this object
+	 * (shared with other outputs) before they are passed to the
+	 * filters.  It is protected by #mutex, and it is assigned
+	 * by the player thread (see
+	 * MultipleOutputs::AssignResamplers()) only when the input
+	 * format or the set of enabled outputs changes: while this
+	 * output is closed, or right before it is reopened with a new
+	 * input format, when the #MusicPipe is empty.
+	 */
+	SharedResampler *shared_resampler = nullptr;
+
 	/**
 	 * The buffer used to allocate the cross-fading result.
 	 */
 	PcmBuffer cross_fade_buffer;
 
+	/**
+	 * The buffer used to join #cross_fade_rest with the next
+	 * chunk of the song being faded out.
+	 */
+	PcmBuffer cross_fade_join_buffer;
+
+	/**
+	 * The part of the song being faded out which was longer than
+	 * the song being faded in, and has not been mixed yet.  With
+	 * a #SharedResampler, both songs are resampled separately,
+	 * and the resampler of the new song starts cold and returns
+	 * less data at first.  The first #cross_fade_rest_size bytes
+	 * are used.
+	 */
+	AllocatedArray<uint8_t> cross_fade_rest;
+	size_t cross_fade_rest_size = 0;
+
 	/**
 	 * The dithering state for cross-fading two streams.
 	 */
@@ -235,6 +267,12 @@ struct AudioOutput {
 	 */
 	FilterObserver convert_filter;
 
+	/**
+	 * Statistics collected by the output thread if
+	 * #pipeline_stats_enabled is set.
+	 */
+	PipelineOutputStats pipeline_stats;
+
 	/**
 	 * The thread handle, or nullptr if the output thread isn't
 	 * running.
@@ -300,6 +338,14 @@ struct AudioOutput {
 		return command == Command::NONE;
 	}
 
+	/**
+	 * Returns the audio format of the data passed to the
+	 * filters: #in_audio_format, or the output format of the
+	 * #shared_resampler.
+	 */
+	gcc_pure
+	AudioFormat GetFilterInAudioFormat() const;
+
 	/**
 	 * Waits for command completion.
 	 *
@@ -21,10 +21,12 @@
 #include "MultipleOutputs.hxx"
 #include "player/Control.hxx"
 #include "Internal.hxx"
+#include "SharedResampler.hxx"
 #include "Domain.hxx"
 #include "MusicBuffer.hxx"
 #include "MusicPipe.hxx"
 #include "MusicChunk.hxx"
+#include "PipelineStats.hxx"
 #include "system/FatalError.hxx"
 #include "util/Error.hxx"
 #include "config/Block.hxx"
@@ -104,6 +106,8 @@ MultipleOutputs::FindByName(const char *name) const
 void
 MultipleOutputs::EnableDisable()
 {
+	resamplers_dirty = true;
+
 	for (auto ao : outputs) {
 		bool enabled;
 
@@ -161,6 +165,75 @@ MultipleOutputs::ResetReopen()
 		audio_output_reset_reopen(ao);
 }
 
+SharedResampler *
+MultipleOutputs::GetResampler(unsigned sample_rate)
+{
+	assert(input_audio_format.IsValid());
+	assert(pipe != nullptr);
+
+	if (sample_rate == 0 ||
+	    sample_rate == input_audio_format.sample_rate ||
+	    input_audio_format.format == SampleFormat::DSD)
+		return nullptr;
+
+	for (auto &i : resamplers)
+		if (i.GetInAudioFormat() == input_audio_format &&
+		    i.GetSampleRate() == sample_rate)
+			return &i;
+
+	resamplers.emplace_front(input_audio_format, sample_rate);
+	auto &r = resamplers.front();
+
+	/* catch up with the chunks which are already in the pipe */
+	for (auto chunk = pipe->Peek(); chunk != nullptr; chunk = chunk->next)
+		r.Convert(*chunk);
+
+	return &r;
+}
+
+void
+MultipleOutputs::AssignResamplers()
+{
+	for (auto ao : outputs) {
+		ao->mutex.lock();
+		/* an output which is open with the current input
+		   format keeps its resampler; all others are closed,
+		   or will be reopened with the new input format
+		   (and the pipe is empty in that case) */
+		const bool reassign = !ao->open ||
+			ao->in_audio_format != input_audio_format;
+		const bool enabled = ao->enabled;
+		ao->mutex.unlock();
+
+		if (!reassign)
+			continue;
+
+		auto r = enabled
+			? GetResampler(ao->config_audio_format.sample_rate)
+			: nullptr;
+
+		const ScopeLock protect(ao->mutex);
+		ao->shared_resampler = r;
+	}
+}
+
+void
+MultipleOutputs::PruneResamplers()
+{
+	for (auto ao : outputs) {
+		const ScopeLock protect(ao->mutex);
+		if (!ao->open && !ao->enabled)
+			ao->shared_resampler = nullptr;
+	}
+
+	resamplers.remove_if([this](const SharedResampler &r){
+			for (auto ao : outputs)
+				if (ao->shared_resampler == &r)
+					return false;
+			return true;
+		});
+}
+
 bool
 MultipleOutputs::Update()
 {
@@ -169,10 +242,21 @@ MultipleOutputs::Update()
 	if (!input_audio_format.IsDefined())
 		return false;
 
+	const bool reconcile = resamplers_dirty;
+	if (reconcile)
+		AssignResamplers();
+
 	for (auto ao : outputs)
 		ret = ao->LockUpdate(input_audio_format, *pipe)
 			|| ret;
 
+	if (reconcile) {
+		/* now that the disabled outputs are closed, their
+		   resamplers can be deleted */
+		PruneResamplers();
+		resamplers_dirty = false;
+	}
+
 	return ret;
 }
 
@@ -197,8 +281,15 @@ MultipleOutputs::Play(MusicChunk *chunk, Error &error)
 		return false;
 	}
 
+	for (auto &r : resamplers)
+		r.Convert(*chunk);
+
+	chunk->queued_time = pipeline_stats_now();
 	pipe->Push(chunk);
 
+	if (pipeline_stats_enabled)
+		pipeline_player_stats.output_depth.Add(pipe->GetSize());
+
 	for (auto ao : outputs)
 		ao->LockPlay();
 
@@ -229,6 +320,7 @@ MultipleOutputs::Open(const AudioFormat audio_format,
 		assert(pipe->IsEmpty() || audio_format == input_audio_format);
 
 	input_audio_format = audio_format;
+	resamplers_dirty = true;
 
 	ResetReopen();
 	EnableDisable();
@@ -360,6 +452,9 @@ MultipleOutputs::Check()
 				if (locked[i])
 					outputs[i]->mutex.unlock();
 
+		for (auto &r : resamplers)
+			r.Release(*shifted);
+
 		/* return the chunk to the buffer */
 		buffer->Return(shifted);
 	}
@@ -418,6 +513,9 @@ MultipleOutputs::Cancel()
 	if (pipe != nullptr)
 		pipe->Clear(*buffer);
 
+	for (auto &r : resamplers)
+		r.Clear();
+
 	/* the audio outputs are now waiting for a signal, to
 	   synchronize the cleared music pipe */
 
@@ -442,6 +540,9 @@ MultipleOutputs::Close()
 		pipe = nullptr;
 	}
 
+	for (auto &r : resamplers)
+		r.Clear();
+
 	buffer = nullptr;
 
 	input_audio_format.Clear();
@@ -463,6 +564,9 @@ MultipleOutputs::Release()
 		pipe = nullptr;
 	}
 
+	for (auto &r : resamplers)
+		r.Clear();
+
 	buffer = nullptr;
 
 	input_audio_format.Clear();
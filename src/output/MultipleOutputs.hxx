@@ -31,6 +31,7 @@
 #include "Chrono.hxx"
 #include "Compiler.h"
 
+#include <forward_list>
 #include <vector>
 
 #include <assert.h>
@@ -42,6 +43,7 @@ class MixerListener;
 struct MusicChunk;
 struct PlayerControl;
 struct AudioOutput;
+class SharedResampler;
 class Error;
 
 class MultipleOutputs {
@@ -68,6 +70,21 @@ class MultipleOutputs {
 	 */
 	SignedSongTime elapsed_time = SignedSongTime::Negative();
 
+	/**
+	 * Resamplers shared by all audio outputs which are configured
+	 * with the same sample rate.  This is only accessed by the
+	 * player thread.
+	 */
+	std::forward_list<SharedResampler> resamplers;
+
+	/**
+	 * Must the #resamplers be reassigned to the audio outputs?
+	 * This is set when the input format or the set of enabled
+	 * audio outputs changes, and avoids doing that for each
+	 * chunk.
+	 */
+	bool resamplers_dirty = true;
+
 public:
 	/**
 	 * Load audio outputs from the configuration file and
@@ -251,6 +268,26 @@ private:
 	 */
 	void ResetReopen();
 
+	/**
+	 * Returns the #SharedResampler which converts the input to
+	 * the given sample rate, and creates it if necessary.
+	 * Returns nullptr if no resampling is needed.
+	 */
+	SharedResampler *GetResampler(unsigned sample_rate);
+
+	/**
+	 * Assign a #SharedResampler to each audio output which is
+	 * going to be (re)opened.
+	 */
+	void AssignResamplers();
+
+	/**
+	 * Detach the #SharedResampler from disabled audio outputs
+	 * which have been closed, and delete the ones which are not
+	 * used anymore.
+	 */
+	void PruneResamplers();
+
 	/**
 	 * Opens all output devices which are enabled, but closed.
 	 *
@@ -20,6 +20,7 @@
 #include "config.h"
 #include "Internal.hxx"
 #include "OutputAPI.hxx"
+#include "SharedResampler.hxx"
 #include "Domain.hxx"
 #include "pcm/PcmMix.hxx"
 #include "pcm/Domain.hxx"
@@ -90,11 +91,21 @@ AudioOutput::Disable()
 	}
 }
 
+AudioFormat
+AudioOutput::GetFilterInAudioFormat() const
+{
+	return shared_resampler != nullptr
+		? shared_resampler->GetOutAudioFormat()
+		: in_audio_format;
+}
+
 inline AudioFormat
 AudioOutput::OpenFilter(AudioFormat &format, Error &error_r)
 {
 	assert(format.IsValid());
 
+	cross_fade_rest_size = 0;
+
 	/* the replay_gain filter cannot fail here */
 	if (prepared_replay_gain_filter != nullptr) {
 		replay_gain_filter_instance =
@@ -158,8 +169,9 @@ AudioOutput::Open()
 
 	/* open the filter */
 
+	AudioFormat filter_in_audio_format = GetFilterInAudioFormat();
 	const AudioFormat filter_audio_format =
-		OpenFilter(in_audio_format, error);
+		OpenFilter(filter_in_audio_format, error);
 	if (!filter_audio_format.IsDefined()) {
 		FormatError(error, "Failed to open filter for \"%s\" [%s]",
 			    name, plugin.name);
@@ -288,8 +300,9 @@ AudioOutput::ReopenFilter()
 	CloseFilter();
 	mutex.lock();
 
+	AudioFormat filter_in_audio_format = GetFilterInAudioFormat();
 	const AudioFormat filter_audio_format =
-		OpenFilter(in_audio_format, error);
+		OpenFilter(filter_in_audio_format, error);
 	if (!filter_audio_format.IsDefined() ||
 	    !convert_filter_set(convert_filter.Get(), out_audio_format,
 				error)) {
@@ -364,17 +377,18 @@ AudioOutput::WaitForDelay()
 static ConstBuffer<void>
 ao_chunk_data(AudioOutput *ao, const MusicChunk *chunk,
 	      Filter *replay_gain_filter,
-	      unsigned *replay_gain_serial_p)
+	      unsigned *replay_gain_serial_p,
+	      bool &writable)
 {
 	assert(chunk != nullptr);
 	assert(!chunk->IsEmpty());
 	assert(chunk->CheckFormat(ao->in_audio_format));
 
-	ConstBuffer<void> data(chunk->data, chunk->length);
-
-	(void)ao;
+	ConstBuffer<void> data = ao->shared_resampler != nullptr
+		? ao->shared_resampler->Get(*chunk)
+		: ConstBuffer<void>(chunk->data, chunk->length);
 
-	assert(data.size % ao->in_audio_format.GetFrameSize() == 0);
+	assert(data.size % ao->GetFilterInAudioFormat().GetFrameSize() == 0);
 
 	if (!data.IsEmpty() && replay_gain_filter != nullptr) {
 		replay_gain_filter_set_mode(replay_gain_filter,
@@ -389,7 +403,8 @@ ao_chunk_data(AudioOutput *ao, const MusicChunk *chunk,
 		}
 
 		Error error;
-		data = replay_gain_filter->FilterPCM(data, error);
+		data = replay_gain_filter->FilterMaybeInPlace(data, writable,
+							      error);
 		if (data.IsNull())
 			FormatError(error, "\"%s\" [%s] failed to filter",
 				    ao->name, ao->plugin.name);
@@ -401,61 +416,114 @@ ao_chunk_data(AudioOutput *ao, const MusicChunk *chunk,
 static ConstBuffer<void>
 ao_filter_chunk(AudioOutput *ao, const MusicChunk *chunk)
 {
+	/* the chunk data is const; as soon as a filter has copied it
+	   into a buffer we own, the following steps operate in
+	   place */
+	bool writable = false;
+
 	ConstBuffer<void> data =
 		ao_chunk_data(ao, chunk, ao->replay_gain_filter_instance,
-			      &ao->replay_gain_serial);
+			      &ao->replay_gain_serial, writable);
 	if (data.IsEmpty())
 		return data;
 
 	/* cross-fade */
 
 	if (chunk->other != nullptr) {
+		bool other_writable = false;
 		ConstBuffer<void> other_data =
 			ao_chunk_data(ao, chunk->other,
 				      ao->other_replay_gain_filter_instance,
-				      &ao->other_replay_gain_serial);
+				      &ao->other_replay_gain_serial,
+				      other_writable);
 		if (other_data.IsNull())
 			return nullptr;
 
-		if (other_data.IsEmpty())
-			return data;
+		if (ao->cross_fade_rest_size > 0) {
+			/* prepend what was left over from the
+			   previous chunk of the song being faded
+			   out */
+			const size_t rest_size = ao->cross_fade_rest_size;
+			uint8_t *p = (uint8_t *)
+				ao->cross_fade_join_buffer.Get(rest_size +
+							       data.size);
+			memcpy(p, ao->cross_fade_rest.begin(), rest_size);
+			memcpy(p + rest_size, data.data, data.size);
+			data = {p, rest_size + data.size};
+			writable = true;
+			ao->cross_fade_rest_size = 0;
+		}
 
-		/* if the "other" chunk is longer, then that trailer
-		   is used as-is, without mixing; it is part of the
-		   "next" song being faded in, and if there's a rest,
-		   it means cross-fading ends here */
+		if (!other_data.IsEmpty()) {
+			/* if the "other" chunk is longer, then that
+			   trailer is used as-is, without mixing; it
+			   is part of the "next" song being faded in,
+			   and if there's a rest, it means
+			   cross-fading ends here */
+
+			if (data.size > other_data.size) {
+				/* the song being faded in is
+				   shorter (e.g. its resampler has
+				   just started); keep the rest of the
+				   song being faded out for the next
+				   chunk instead of dropping it */
+				const size_t rest_size =
+					data.size - other_data.size;
+				ao->cross_fade_rest.GrowDiscard(rest_size);
+				memcpy(ao->cross_fade_rest.begin(),
+				       (const uint8_t *)data.data +
+				       other_data.size,
+				       rest_size);
+				ao->cross_fade_rest_size = rest_size;
+
+				data.size = other_data.size;
+			}
 
-		if (data.size > other_data.size)
-			data.size = other_data.size;
+			float mix_ratio = chunk->mix_ratio;
+			if (mix_ratio >= 0)
+				/* reverse the mix ratio (because the
+				   arguments to pcm_mix() are
+				   reversed), but only if the mix
+				   ratio is non-negative; a negative
+				   mix ratio is a MixRamp special
+				   case */
+				mix_ratio = 1.0 - mix_ratio;
+
+			const SampleFormat format =
+				ao->GetFilterInAudioFormat().format;
+
+			void *dest;
+			if (other_writable)
+				/* mix right into the replay gain
+				   filter's buffer */
+				dest = const_cast<void *>(other_data.data);
+			else {
+				dest = ao->cross_fade_buffer.Get(other_data.size);
+				memcpy(dest, other_data.data, other_data.size);
+			}
 
-		float mix_ratio = chunk->mix_ratio;
-		if (mix_ratio >= 0)
-			/* reverse the mix ratio (because the
-			   arguments to pcm_mix() are reversed), but
-			   only if the mix ratio is non-negative; a
-			   negative mix ratio is a MixRamp special
-			   case */
-			mix_ratio = 1.0 - mix_ratio;
-
-		void *dest = ao->cross_fade_buffer.Get(other_data.size);
-		memcpy(dest, other_data.data, other_data.size);
-		if (!pcm_mix(ao->cross_fade_dither, dest, data.data, data.size,
-			     ao->in_audio_format.format,
-			     mix_ratio)) {
-			FormatError(output_domain,
-				    "Cannot cross-fade format %s",
-				    sample_format_to_string(ao->in_audio_format.format));
-			return nullptr;
-		}
+			if (!pcm_mix(ao->cross_fade_dither, dest,
+				     data.data, data.size,
+				     format, mix_ratio)) {
+				FormatError(output_domain,
+					    "Cannot cross-fade format %s",
+					    sample_format_to_string(format));
+				return nullptr;
+			}
 
-		data.data = dest;
-		data.size = other_data.size;
-	}
+			data.data = dest;
+			data.size = other_data.size;
+			writable = true;
+		}
+	} else
+		/* the cross-fade is over (or there was none); the
+		   rest of the old song is obsolete */
+		ao->cross_fade_rest_size = 0;
 
 	/* apply filter chain */
 
 	Error error;
-	data = ao->filter_instance->FilterPCM(data, error);
+	data = ao->filter_instance->FilterMaybeInPlace(data, writable, error);
 	if (data.IsNull()) {
 		FormatError(error, "\"%s\" [%s] failed to filter",
 			    ao->name, ao->plugin.name);
@@ -476,7 +544,15 @@ AudioOutput::PlayChunk(const MusicChunk *chunk)
 		mutex.lock();
 	}
 
+	const uint64_t start_time = pipeline_stats_now();
+	if (start_time != 0 && chunk->queued_time != 0)
+		pipeline_stats.pickup.Add(start_time - chunk->queued_time);
+
 	auto data = ConstBuffer<char>::FromVoid(ao_filter_chunk(this, chunk));
+
+	if (start_time != 0)
+		pipeline_stats.filter.Add(pipeline_stats_now() - start_time);
+
 	if (data.IsNull()) {
 		Close(false);
 
@@ -487,14 +563,18 @@ AudioOutput::PlayChunk(const MusicChunk *chunk)
 	}
 
 	Error error;
+	uint64_t play_duration = 0;
 
 	while (!data.IsEmpty() && command == Command::NONE) {
 		if (!WaitForDelay())
 			break;
 
 		mutex.unlock();
+		const uint64_t play_time = pipeline_stats_now();
 		size_t nbytes = ao_plugin_play(this, data.data, data.size,
 					       error);
+		if (play_time != 0)
+			play_duration += pipeline_stats_now() - play_time;
 		mutex.lock();
 		if (nbytes == 0) {
 			/* play()==0 means failure */
@@ -518,6 +598,13 @@ AudioOutput::PlayChunk(const MusicChunk *chunk)
 		data.size -= nbytes;
 	}
 
+	if (start_time != 0) {
+		pipeline_stats.play.Add(play_duration);
+		if (chunk->decoded_time != 0)
+			pipeline_stats.total.Add(pipeline_stats_now()
+						 - chunk->decoded_time);
+	}
+
 	return true;
 }
 
@@ -679,6 +766,7 @@ AudioOutput::Task()
 
 		case Command::CANCEL:
 			current_chunk = nullptr;
+			cross_fade_rest_size = 0;
 
 			if (open) {
 				mutex.unlock();
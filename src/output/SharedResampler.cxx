@@ -0,0 +1,171 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "SharedResampler.hxx"
+#include "Domain.hxx"
+#include "MusicChunk.hxx"
+#include "util/Error.hxx"
+#include "util/ConstBuffer.hxx"
+#include "Log.hxx"
+
+#include <algorithm>
+#include <iterator>
+
+#include <assert.h>
+#include <string.h>
+
+void
+SharedResampler::Converter::Reopen(AudioFormat in_audio_format,
+				   AudioFormat out_audio_format)
+{
+	if (open)
+		convert.Close();
+
+	Error error;
+	open = convert.Open(in_audio_format, out_audio_format, error);
+	if (!open)
+		FormatError(error, "Failed to open the shared resampler to %u Hz",
+			    out_audio_format.sample_rate);
+}
+
+SharedResampler::SharedResampler(AudioFormat _in_audio_format,
+				 unsigned sample_rate)
+	:in_audio_format(_in_audio_format),
+	 out_audio_format(sample_rate, SampleFormat::FLOAT,
+			  _in_audio_format.channels)
+{
+	assert(in_audio_format.IsValid());
+	assert(in_audio_format.format != SampleFormat::DSD);
+	assert(sample_rate != in_audio_format.sample_rate);
+
+	for (auto &i : converters)
+		i.Reopen(in_audio_format, out_audio_format);
+
+	ok = converters[0].open && converters[1].open;
+}
+
+inline void
+SharedResampler::Convert(Converter &c, const MusicChunk &chunk)
+{
+	/* reuse a released item and its buffer; it is moved to a
+	   temporary list while it is being filled, so the mutex
+	   needs to be locked only to move it to #converted */
+	std::list<Converted> tmp;
+	if (unused.empty())
+		tmp.emplace_back();
+	else
+		tmp.splice(tmp.end(), unused, unused.begin());
+
+	Converted &item = tmp.front();
+	item.chunk = &chunk;
+	item.size = 0;
+
+	if (c.open && chunk.length > 0) {
+		const ConstBuffer<void> src(chunk.data, chunk.length);
+
+		Error error;
+		const auto result = c.convert.Convert(src, error);
+		if (result.IsNull())
+			LogError(error);
+		else {
+			item.buffer.GrowDiscard(result.size);
+			memcpy(item.buffer.begin(), result.data, result.size);
+			item.size = result.size;
+		}
+	}
+
+	const ScopeLock protect(mutex);
+	converted.splice(converted.end(), tmp);
+}
+
+void
+SharedResampler::Convert(const MusicChunk &chunk)
+{
+	if (!ok)
+		return;
+
+	if (chunk.other != nullptr) {
+		Convert(*other_convert, *chunk.other);
+		cross_fading = true;
+	} else if (cross_fading) {
+		/* the cross-fade is over, and the song which was
+		   faded in continues as the regular stream */
+		cross_fading = false;
+		std::swap(convert, other_convert);
+		other_convert->Reopen(in_audio_format, out_audio_format);
+	}
+
+	Convert(*convert, chunk);
+}
+
+ConstBuffer<void>
+SharedResampler::Get(const MusicChunk &chunk) const
+{
+	if (!ok)
+		return {chunk.data, chunk.length};
+
+	const ScopeLock protect(mutex);
+
+	for (const auto &i : converted)
+		if (i.chunk == &chunk)
+			/* the size is zero if the chunk is empty or
+			   if the conversion has failed */
+			return {i.buffer.begin(), i.size};
+
+	return {chunk.data, 0};
+}
+
+void
+SharedResampler::Release(const MusicChunk &chunk)
+{
+	if (!ok)
+		return;
+
+	const ScopeLock protect(mutex);
+
+	/* the chunk is usually at the front, because chunks are
+	   released in the order of the pipe */
+	unsigned n = chunk.other != nullptr ? 2 : 1;
+	for (auto i = converted.begin(); n > 0 && i != converted.end();) {
+		auto next = std::next(i);
+		if (i->chunk == &chunk || i->chunk == chunk.other) {
+			unused.splice(unused.end(), converted, i);
+			--n;
+		}
+
+		i = next;
+	}
+}
+
+void
+SharedResampler::Clear()
+{
+	if (!ok)
+		return;
+
+	{
+		const ScopeLock protect(mutex);
+		unused.splice(unused.end(), converted);
+	}
+
+	cross_fading = false;
+	for (auto &i : converters)
+		i.Reopen(in_audio_format, out_audio_format);
+}
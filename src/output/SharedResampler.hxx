@@ -0,0 +1,177 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_OUTPUT_SHARED_RESAMPLER_HXX
+#define MPD_OUTPUT_SHARED_RESAMPLER_HXX
+
+#include "AudioFormat.hxx"
+#include "pcm/PcmConvert.hxx"
+#include "thread/Mutex.hxx"
+#include "util/AllocatedArray.hxx"
+#include "Compiler.h"
+
+#include <list>
+
+#include <stdint.h>
+
+struct MusicChunk;
+template<typename T> struct ConstBuffer;
+
+/**
+ * Resamples the chunks of the #MusicPipe once for all audio outputs
+ * which are configured with the same sample rate, instead of once in
+ * each output's filter chain.  The result is floating point, and
+ * the outputs apply their filters (replay gain, volume, ...) on it.
+ *
+ * Chunks are converted by the player thread (in
+ * MultipleOutputs::Play()), and the result is kept until the chunk
+ * is returned to the #MusicBuffer.  The output threads obtain it
+ * with Get().
+ */
+class SharedResampler {
+	const AudioFormat in_audio_format;
+	const AudioFormat out_audio_format;
+
+	struct Converter {
+		PcmConvert convert;
+
+		bool open = false;
+
+		~Converter() {
+			if (open)
+				convert.Close();
+		}
+
+		/**
+		 * (Re-)open the converter, which resets its filter
+		 * state.  Errors are logged.
+		 */
+		void Reopen(AudioFormat in_audio_format,
+			    AudioFormat out_audio_format);
+	};
+
+	/**
+	 * Two converters: one for the regular stream, and one for
+	 * the "other" chunks of a cross-fade (the song which is
+	 * being faded in).  When the cross-fade ends, they swap
+	 * roles.
+	 */
+	Converter converters[2];
+
+	Converter *convert = &converters[0];
+	Converter *other_convert = &converters[1];
+
+	/**
+	 * Did the previous chunk have an "other" chunk?
+	 */
+	bool cross_fading = false;
+
+	/**
+	 * Could the converters be opened?  If not, Get() returns the
+	 * original chunk data, and the output's own filter chain
+	 * does the conversion.
+	 */
+	bool ok;
+
+	struct Converted {
+		const MusicChunk *chunk;
+
+		AllocatedArray<uint8_t> buffer;
+
+		/**
+		 * The number of bytes in #buffer which are used;
+		 * zero if the chunk is empty or the conversion has
+		 * failed.
+		 */
+		size_t size;
+	};
+
+	/**
+	 * Protects #converted.
+	 */
+	mutable Mutex mutex;
+
+	/**
+	 * The converted data of all chunks in the #MusicPipe, in
+	 * the order of the pipe.  Released chunks are removed from
+	 * the front, so lookups usually find the chunk an output is
+	 * playing within the first few items.
+	 */
+	std::list<Converted> converted;
+
+	/**
+	 * Items which have been released.  They are reused by
+	 * Convert(), which avoids allocating a buffer (and a list
+	 * node) for each chunk.  This is only accessed by the
+	 * player thread.
+	 */
+	std::list<Converted> unused;
+
+public:
+	SharedResampler(AudioFormat _in_audio_format, unsigned sample_rate);
+
+	SharedResampler(const SharedResampler &) = delete;
+	SharedResampler &operator=(const SharedResampler &) = delete;
+
+	AudioFormat GetInAudioFormat() const {
+		return in_audio_format;
+	}
+
+	/**
+	 * Returns the format of the data returned by Get().
+	 */
+	AudioFormat GetOutAudioFormat() const {
+		return ok ? out_audio_format : in_audio_format;
+	}
+
+	unsigned GetSampleRate() const {
+		return out_audio_format.sample_rate;
+	}
+
+	/**
+	 * Convert the next chunk (and its "other" chunk).  Chunks
+	 * must be passed in the order of the #MusicPipe.
+	 */
+	void Convert(const MusicChunk &chunk);
+
+	/**
+	 * Returns the converted data of a chunk which was passed to
+	 * Convert() before.  It remains valid until Release() or
+	 * Clear() is called.  This method is thread-safe.
+	 */
+	gcc_pure
+	ConstBuffer<void> Get(const MusicChunk &chunk) const;
+
+	/**
+	 * Free the converted data of the chunk (and its "other"
+	 * chunk), because it is being returned to the #MusicBuffer.
+	 */
+	void Release(const MusicChunk &chunk);
+
+	/**
+	 * Free all converted data and reset the filter state, after
+	 * the #MusicPipe has been cleared.
+	 */
+	void Clear();
+
+private:
+	void Convert(Converter &c, const MusicChunk &chunk);
+};
+
+#endif
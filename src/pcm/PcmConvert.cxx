@@ -19,7 +19,6 @@
 
 #include "config.h"
 #include "PcmConvert.hxx"
-#include "Domain.hxx"
 #include "ConfiguredResampler.hxx"
 #include "AudioFormat.hxx"
 #include "util/Error.hxx"
@@ -57,8 +56,19 @@ PcmConvert::Open(const AudioFormat _src_format, const AudioFormat _dest_format,
 	assert(_dest_format.IsValid());
 
 	AudioFormat format = _src_format;
-	if (format.format == SampleFormat::DSD)
+	if (format.format == SampleFormat::DSD) {
+#ifdef ENABLE_DSD
+		/* let the DSD converter do the first (cheap) part of
+		   the sample rate reduction */
+		const unsigned shift =
+			PcmDsd::ChooseDecimation(format.sample_rate,
+						 _dest_format.sample_rate);
+		dsd.Open(format.channels, shift);
+		format.sample_rate >>= shift;
+#endif
+
 		format.format = SampleFormat::FLOAT;
+	}
 
 	enable_resampler = format.sample_rate != _dest_format.sample_rate;
 	if (enable_resampler) {
@@ -123,14 +133,7 @@ PcmConvert::Convert(ConstBuffer<void> buffer, Error &error)
 #ifdef ENABLE_DSD
 	if (src_format.format == SampleFormat::DSD) {
 		auto s = ConstBuffer<uint8_t>::FromVoid(buffer);
-		auto d = dsd.ToFloat(src_format.channels, s);
-		if (d.IsNull()) {
-			error.Set(pcm_domain,
-				  "DSD to PCM conversion failed");
-			return nullptr;
-		}
-
-		buffer = d.ToVoid();
+		buffer = dsd.ToFloat(s).ToVoid();
 	}
 #endif
 
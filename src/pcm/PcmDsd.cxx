@@ -19,57 +19,282 @@
 
 #include "config.h"
 #include "PcmDsd.hxx"
-#include "dsd2pcm/dsd2pcm.h"
 #include "util/ConstBuffer.hxx"
+#include "util/Macros.hxx"
+#include "util/bit_reverse.h"
+
+#include <algorithm>
 
 #include <assert.h>
+#include <math.h>
+
+/**
+ * The second half of the 96 tap symmetric lowpass filter of
+ * dsd2pcm.c.
+ */
+static constexpr double dsd2pcm_taps[48] = {
+	0.09950731974056658,
+	0.09562845727714668,
+	0.08819647126516944,
+	0.07782552527068175,
+	0.06534876523171299,
+	0.05172629311427257,
+	0.0379429484910187,
+	0.02490921351762261,
+	0.0133774746265897,
+	0.003883043418804416,
+	-0.003284703416210726,
+	-0.008080250212687497,
+	-0.01067241812471033,
+	-0.01139427235000863,
+	-0.0106813877974587,
+	-0.009007905078766049,
+	-0.006828859761015335,
+	-0.004535184322001496,
+	-0.002425035959059578,
+	-0.0006922187080790708,
+	0.0005700762133516592,
+	0.001353838005269448,
+	0.001713709169690937,
+	0.001742046839472948,
+	0.001545601648013235,
+	0.001226696225277855,
+	0.0008704322683580222,
+	0.0005381636200535649,
+	0.000266446345425276,
+	7.002968738383528e-05,
+	-5.279407053811266e-05,
+	-0.0001140625650874684,
+	-0.0001304796361231895,
+	-0.0001189970287491285,
+	-9.396247155265073e-05,
+	-6.577634378272832e-05,
+	-4.07492895872535e-05,
+	-2.17407957554587e-05,
+	-9.163058931391722e-06,
+	-2.017460145032201e-06,
+	1.249721855219005e-06,
+	2.166655190537392e-06,
+	1.930520892991082e-06,
+	1.319400334374195e-06,
+	7.410039764949091e-07,
+	3.423230509967409e-07,
+	1.244182214744588e-07,
+	3.130441005359396e-08
+};
 
-PcmDsd::PcmDsd()
+/**
+ * The Kaiser window parameter for the half-band filters; more than
+ * 85 dB stopband attenuation.
+ */
+static constexpr double HALF_BAND_BETA = 8;
+
+/**
+ * The zeroth order modified Bessel function of the first kind.
+ */
+gcc_const
+static double
+BesselI0(double x)
 {
-	dsd2pcm.fill(nullptr);
+	double sum = 1, term = 1;
+	for (unsigned k = 1; term > sum * 1e-12; ++k) {
+		const double t = x / (2 * k);
+		term *= t * t;
+		sum += term;
+	}
+
+	return sum;
 }
 
-PcmDsd::~PcmDsd()
+void
+PcmDsd::HalfBand::Reset()
 {
-	for (auto i : dsd2pcm)
-		if (i != nullptr)
-			dsd2pcm_destroy(i);
+	for (auto &i : history)
+		std::fill_n(i, ARRAY_SIZE(i), 0.0f);
+	odd = false;
+}
+
+inline size_t
+PcmDsd::HalfBand::Decimate(const float *coefficients, unsigned channels,
+			   float *p, size_t n_frames, PcmBuffer &scratch)
+{
+	constexpr size_t n_history = ARRAY_SIZE(history[0]);
+	constexpr unsigned center = HALF_BAND_TAPS / 2;
+
+	/* the input index of the first output sample (its newest
+	   input sample, that is) */
+	const size_t first = odd ? 0 : 1;
+	const size_t n_out = n_frames > first
+		? (n_frames - first + 1) / 2
+		: 0;
+	if (n_frames % 2 != 0)
+		odd = !odd;
+
+	/* de-interleave everything first, which allows writing the
+	   output in place */
+	const size_t stride = n_history + n_frames;
+	float *const b = scratch.GetT<float>(channels * stride);
+	for (unsigned c = 0; c < channels; ++c) {
+		float *const d = b + c * stride;
+		std::copy_n(history[c], n_history, d);
+		for (size_t i = 0; i < n_frames; ++i)
+			d[n_history + i] = p[i * channels + c];
+		std::copy_n(d + n_frames, n_history, history[c]);
+	}
+
+	for (unsigned c = 0; c < channels; ++c) {
+		const float *const d = b + c * stride;
+
+		for (size_t j = 0; j < n_out; ++j) {
+			/* the window of this output sample, oldest
+			   first */
+			const float *window = d + first + 2 * j;
+
+			float acc = 0.5f * window[center];
+			for (unsigned k = 0; k < HALF_BAND_PAIRS; ++k)
+				acc += coefficients[k] *
+					(window[center - 1 - 2 * k] +
+					 window[center + 1 + 2 * k]);
+
+			p[j * channels + c] = acc;
+		}
+	}
+
+	return n_out;
+}
+
+void
+PcmDsd::Open(unsigned _channels, unsigned _decimation_shift)
+{
+	assert(_channels > 0);
+	assert(_channels <= MAX_CHANNELS);
+	assert(_decimation_shift <= MAX_DECIMATION_SHIFT);
+
+	channels = _channels;
+	decimation_shift = _decimation_shift;
+
+	for (unsigned t = 0; t < CTABLES; ++t) {
+		const unsigned k = std::min(ARRAY_SIZE(dsd2pcm_taps) - t * 8,
+					    size_t(8));
+		float *const table = ctables[CTABLES - 1 - t];
+
+		for (unsigned e = 0; e < 256; ++e) {
+			double acc = 0;
+			for (unsigned m = 0; m < k; ++m)
+				acc += (e & (0x80 >> m)
+					? dsd2pcm_taps[t * 8 + m]
+					: -dsd2pcm_taps[t * 8 + m]);
+			table[e] = (float)acc;
+		}
+	}
+
+	for (unsigned t = 0; t < CTABLES; ++t)
+		for (unsigned e = 0; e < 256; ++e)
+			ctables[CTABLES + t][e] = ctables[t][bit_reverse(e)];
+
+	/* windowed sinc; only the odd offsets from the center are
+	   non-zero */
+	constexpr double half_width = HALF_BAND_TAPS / 2;
+	const double i0_beta = BesselI0(HALF_BAND_BETA);
+	double sum = 0;
+	for (unsigned k = 0; k < HALF_BAND_PAIRS; ++k) {
+		const double n = 2 * k + 1;
+		const double r = n / half_width;
+		const double window =
+			BesselI0(HALF_BAND_BETA * sqrt(1 - r * r)) / i0_beta;
+		const double c = (k % 2 == 0 ? 1 : -1) / (M_PI * n) * window;
+		half_band[k] = c;
+		sum += c;
+	}
+
+	/* normalize to unity gain at DC: the side coefficients must
+	   add up to 0.5, just like the center one */
+	for (auto &i : half_band)
+		i *= 0.25 / sum;
+
+	Reset();
 }
 
 void
 PcmDsd::Reset()
 {
-	for (auto i : dsd2pcm)
-		if (i != nullptr)
-			dsd2pcm_reset(i);
+	/* start with the silence pattern 0x69 of dsd2pcm; it
+	   reverses one history byte per input byte in place, and the
+	   older part of its initial history is read before it has
+	   been reversed */
+	constexpr unsigned n_unreversed = HISTORY - CTABLES;
+	for (auto &i : history) {
+		std::fill_n(i, n_unreversed, bit_reverse(0x69));
+		std::fill_n(i + n_unreversed, HISTORY - n_unreversed, 0x69);
+	}
+
+	for (auto &i : stages)
+		i.Reset();
+}
+
+unsigned
+PcmDsd::ChooseDecimation(unsigned dsd_rate, unsigned pcm_rate)
+{
+	unsigned shift = 0;
+	while (shift < MAX_DECIMATION_SHIFT &&
+	       (dsd_rate >> (shift + 1)) >= pcm_rate * 2)
+		++shift;
+
+	/* if one more stage hits the requested rate exactly, the
+	   resampler can be omitted; but only at high rates, where
+	   the transition band of the half-band filter is above the
+	   audible range */
+	if (shift < MAX_DECIMATION_SHIFT && pcm_rate >= 88200 &&
+	    (dsd_rate >> (shift + 1)) == pcm_rate &&
+	    pcm_rate << (shift + 1) == dsd_rate)
+		++shift;
+
+	return shift;
+}
+
+inline void
+PcmDsd::Translate(const uint8_t *src, size_t n_frames, float *dest)
+{
+	uint8_t *const b = scratch.GetT<uint8_t>(HISTORY + n_frames);
+
+	for (unsigned c = 0; c < channels; ++c) {
+		std::copy_n(history[c], HISTORY, b);
+		for (size_t i = 0; i < n_frames; ++i)
+			b[HISTORY + i] = src[i * channels + c];
+
+		for (size_t i = 0; i < n_frames; ++i) {
+			/* p[HISTORY] is the current byte */
+			const uint8_t *p = b + i;
+
+			float acc = 0;
+			for (unsigned t = 0; t < CTABLES; ++t)
+				acc += ctables[t][p[HISTORY - t]] +
+					ctables[CTABLES + t][p[t]];
+			dest[i * channels + c] = acc;
+		}
+
+		std::copy_n(b + n_frames, HISTORY, history[c]);
+	}
 }
 
 ConstBuffer<float>
-PcmDsd::ToFloat(unsigned channels, ConstBuffer<uint8_t> src)
+PcmDsd::ToFloat(ConstBuffer<uint8_t> src)
 {
 	assert(!src.IsNull());
 	assert(!src.IsEmpty());
 	assert(src.size % channels == 0);
-	assert(channels <= dsd2pcm.max_size());
 
-	const unsigned num_samples = src.size;
-	const unsigned num_frames = src.size / channels;
+	size_t num_frames = src.size / channels;
 
-	float *dest = buffer.GetT<float>(num_samples);
+	float *dest = buffer.GetT<float>(src.size);
 
-	for (unsigned c = 0; c < channels; ++c) {
-		if (dsd2pcm[c] == nullptr) {
-			dsd2pcm[c] = dsd2pcm_init();
-			if (dsd2pcm[c] == nullptr)
-				return nullptr;
-		}
+	Translate(src.data, num_frames, dest);
 
-		dsd2pcm_translate(dsd2pcm[c], num_frames,
-				  src.data + c, channels,
-				  false, dest + c, channels);
-	}
+	for (unsigned i = 0; i < decimation_shift; ++i)
+		num_frames = stages[i].Decimate(half_band, channels,
+						dest, num_frames, scratch);
 
-	return { dest, num_samples };
+	return { dest, num_frames * channels };
 }
 
 /**
@@ -21,31 +21,145 @@
 #define MPD_PCM_DSD_HXX
 
 #include "check.h"
+#include "Compiler.h"
 #include "PcmBuffer.hxx"
 #include "AudioFormat.hxx"
 
 #include <array>
 
+#include <stddef.h>
 #include <stdint.h>
 
 template<typename T> struct ConstBuffer;
 
 /**
- * Wrapper for the dsd2pcm library.
+ * Convert DSD to floating point PCM.  This implements the filter of
+ * the dsd2pcm library, but it uses additional lookup tables instead
+ * of bit-reversing the history in place, and it filters a
+ * contiguous copy of each channel, without ring buffer arithmetic.
+ * Optionally, the output is decimated further by a cascade of
+ * half-band filters.
  */
 class PcmDsd {
+public:
+	/**
+	 * The maximum number of 2:1 decimation stages after the
+	 * initial 8:1 conversion.
+	 */
+	static constexpr unsigned MAX_DECIMATION_SHIFT = 4;
+
+private:
+	/**
+	 * The number of lookup tables for each half of the 96 tap
+	 * filter; each one covers 8 taps.
+	 */
+	static constexpr unsigned CTABLES = 6;
+
+	/**
+	 * The number of input bytes per channel which are needed
+	 * in addition to the current one.
+	 */
+	static constexpr unsigned HISTORY = CTABLES * 2 - 1;
+
+	/**
+	 * The length of the half-band filter.  Every other
+	 * coefficient is zero except for the center one, which
+	 * leaves (HALF_BAND_TAPS+1)/4 distinct non-zero
+	 * coefficients on each side.
+	 */
+	static constexpr unsigned HALF_BAND_TAPS = 47;
+	static constexpr unsigned HALF_BAND_PAIRS = (HALF_BAND_TAPS + 1) / 4;
+
+	struct HalfBand {
+		/**
+		 * The most recent input samples of each channel,
+		 * oldest first.
+		 */
+		float history[MAX_CHANNELS][HALF_BAND_TAPS - 1];
+
+		/**
+		 * Does the next input sample complete an output
+		 * sample?
+		 */
+		bool odd;
+
+		void Reset();
+
+		/**
+		 * Decimate interleaved samples in place.
+		 *
+		 * @return the number of output frames
+		 */
+		size_t Decimate(const float *coefficients, unsigned channels,
+				float *p, size_t n_frames,
+				PcmBuffer &scratch);
+	};
+
 	PcmBuffer buffer;
 
-	std::array<struct dsd2pcm_ctx_s *, MAX_CHANNELS> dsd2pcm;
+	/**
+	 * De-interleaved input, prepended with the history of each
+	 * channel.
+	 */
+	PcmBuffer scratch;
+
+	unsigned channels;
+
+	unsigned decimation_shift;
+
+	/**
+	 * The most recent input bytes of each channel, oldest first.
+	 */
+	uint8_t history[MAX_CHANNELS][HISTORY];
+
+	/**
+	 * Lookup tables for the most recent bytes (indexes 0 to
+	 * #CTABLES-1) and for the older bytes, which are applied to
+	 * the mirrored half of the filter and therefore index the
+	 * table with the bit-reversed byte (the others).
+	 */
+	float ctables[CTABLES * 2][256];
+
+	/**
+	 * The non-zero side coefficients of the half-band filter,
+	 * beginning at the center.
+	 */
+	float half_band[HALF_BAND_PAIRS];
+
+	std::array<HalfBand, MAX_DECIMATION_SHIFT> stages;
 
 public:
-	PcmDsd();
-	~PcmDsd();
+	/**
+	 * Prepare the conversion of a new stream.
+	 *
+	 * @param decimation_shift the number of 2:1 decimation
+	 * stages; the output sample rate is the DSD byte rate shifted
+	 * right by this number
+	 */
+	void Open(unsigned channels, unsigned decimation_shift=0);
 
+	/**
+	 * Reset the filter state, e.g. after seeking.
+	 */
 	void Reset();
 
-	ConstBuffer<float> ToFloat(unsigned channels,
-				   ConstBuffer<uint8_t> src);
+	/**
+	 * Choose the number of 2:1 decimation stages for converting
+	 * DSD with the given byte rate to PCM with (at least) the
+	 * given sample rate.  Usually, decimation stops while the
+	 * rate is still at least twice the requested one, to leave
+	 * the final (steep) filtering to the resampler; high
+	 * resolution rates which are a power of two below the DSD
+	 * rate are reached by decimation alone.
+	 */
+	gcc_const
+	static unsigned ChooseDecimation(unsigned dsd_rate,
+					 unsigned pcm_rate);
+
+	ConstBuffer<float> ToFloat(ConstBuffer<uint8_t> src);
+
+private:
+	void Translate(const uint8_t *src, size_t n_frames, float *dest);
 };
 
 /**
@@ -21,6 +21,7 @@
 #include "PcmExport.hxx"
 #include "Order.hxx"
 #include "PcmPack.hxx"
+#include "Simd.hxx"
 #include "util/ByteReverse.hxx"
 #include "util/ConstBuffer.hxx"
 
@@ -147,7 +148,11 @@ PcmExport::Export(ConstBuffer<void> data)
 		assert(dest != nullptr);
 		data.data = dest;
 
-		reverse_bytes(dest, src.begin(), src.end(), reverse_endian);
+		const size_t done = pcm_simd_reverse_bytes(dest, src.data,
+							   src.size,
+							   reverse_endian);
+		reverse_bytes(dest + done, src.begin() + done, src.end(),
+			      reverse_endian);
 	}
 
 	return data;
@@ -116,6 +116,27 @@ struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
 
 #endif
 
+#ifdef __SSE2__
+#include "Sse2.hxx"
+
+template<>
+struct FloatToInteger<SampleFormat::S16, SampleTraits<SampleFormat::S16>>
+	: GlueOptimizedConvert<Sse2FloatToInteger<SampleFormat::S16>,
+			       PortableFloatToInteger<SampleFormat::S16>> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S24_P32,
+		      SampleTraits<SampleFormat::S24_P32>>
+	: GlueOptimizedConvert<Sse2FloatToInteger<SampleFormat::S24_P32>,
+			       PortableFloatToInteger<SampleFormat::S24_P32>> {};
+
+template<>
+struct FloatToInteger<SampleFormat::S32, SampleTraits<SampleFormat::S32>>
+	: GlueOptimizedConvert<Sse2FloatToInteger<SampleFormat::S32>,
+			       PortableFloatToInteger<SampleFormat::S32>> {};
+
+#endif
+
 template<class C>
 static ConstBuffer<typename C::DstTraits::value_type>
 AllocateConvert(PcmBuffer &buffer, C convert,
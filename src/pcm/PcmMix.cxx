@@ -23,6 +23,7 @@
 #include "PcmUtils.hxx"
 #include "AudioFormat.hxx"
 #include "Traits.hxx"
+#include "Simd.hxx"
 #include "util/Clamp.hxx"
 
 #include "PcmDither.cxx" // including the .cxx file to get inlined templates
@@ -75,6 +76,13 @@ static void
 pcm_add_vol_float(float *buffer1, const float *buffer2,
 		  unsigned num_samples, float volume1, float volume2)
 {
+	const size_t done = pcm_simd_add_vol_float(buffer1, buffer2,
+						   num_samples,
+						   volume1, volume2);
+	buffer1 += done;
+	buffer2 += done;
+	num_samples -= done;
+
 	while (num_samples > 0) {
 		float sample1 = *buffer1;
 		float sample2 = *buffer2++;
@@ -145,12 +153,35 @@ template<SampleFormat F, class Traits=SampleTraits<F>>
 static void
 PcmAdd(typename Traits::pointer_type a,
        typename Traits::const_pointer_type b,
-       size_t n)
+       size_t n, size_t start=0)
 {
-	for (size_t i = 0; i != n; ++i)
+	for (size_t i = start; i != n; ++i)
 		a[i] = PcmAdd<F, Traits>(a[i], b[i]);
 }
 
+/*
+ * The following functions use the vectorized kernel for the bulk of
+ * the buffer, and the portable code for the remaining samples.
+ */
+
+static void
+PcmAdd16(int16_t *a, const int16_t *b, size_t n)
+{
+	PcmAdd<SampleFormat::S16>(a, b, n, pcm_simd_add_16(a, b, n));
+}
+
+static void
+PcmAdd24(int32_t *a, const int32_t *b, size_t n)
+{
+	PcmAdd<SampleFormat::S24_P32>(a, b, n, pcm_simd_add_24(a, b, n));
+}
+
+static void
+PcmAdd32(int32_t *a, const int32_t *b, size_t n)
+{
+	PcmAdd<SampleFormat::S32>(a, b, n, pcm_simd_add_32(a, b, n));
+}
+
 template<SampleFormat F, class Traits=SampleTraits<F>>
 static void
 PcmAddVoid(void *a, const void *b, size_t size)
@@ -166,6 +197,11 @@ PcmAddVoid(void *a, const void *b, size_t size)
 static void
 pcm_add_float(float *buffer1, const float *buffer2, unsigned num_samples)
 {
+	const size_t done = pcm_simd_add_float(buffer1, buffer2, num_samples);
+	buffer1 += done;
+	buffer2 += done;
+	num_samples -= done;
+
 	while (num_samples > 0) {
 		float sample1 = *buffer1;
 		float sample2 = *buffer2++;
@@ -189,15 +225,21 @@ pcm_add(void *buffer1, const void *buffer2, size_t size,
 		return true;
 
 	case SampleFormat::S16:
-		PcmAddVoid<SampleFormat::S16>(buffer1, buffer2, size);
+		assert(size % sizeof(int16_t) == 0);
+		PcmAdd16((int16_t *)buffer1, (const int16_t *)buffer2,
+			 size / sizeof(int16_t));
 		return true;
 
 	case SampleFormat::S24_P32:
-		PcmAddVoid<SampleFormat::S24_P32>(buffer1, buffer2, size);
+		assert(size % sizeof(int32_t) == 0);
+		PcmAdd24((int32_t *)buffer1, (const int32_t *)buffer2,
+			 size / sizeof(int32_t));
 		return true;
 
 	case SampleFormat::S32:
-		PcmAddVoid<SampleFormat::S32>(buffer1, buffer2, size);
+		assert(size % sizeof(int32_t) == 0);
+		PcmAdd32((int32_t *)buffer1, (const int32_t *)buffer2,
+			 size / sizeof(int32_t));
 		return true;
 
 	case SampleFormat::FLOAT:
@@ -18,6 +18,7 @@
  */
 
 #include "PcmPack.hxx"
+#include "Simd.hxx"
 #include "system/ByteOrder.hxx"
 
 static void
@@ -39,6 +40,10 @@ pcm_pack_24(uint8_t *dest, const int32_t *src, const int32_t *src_end)
 	/* duplicate loop to help the compiler's optimizer (constant
 	   parameter to the pack_sample() inline function) */
 
+	const size_t done = pcm_simd_pack_24(dest, src, src_end - src);
+	src += done;
+	dest += done * 3;
+
 	while (src < src_end) {
 		pack_sample(dest, src++);
 		dest += 3;
@@ -69,6 +74,11 @@ pcm_unpack_24(int32_t *dest, const uint8_t *src, const uint8_t *src_end)
 	/* duplicate loop to help the compiler's optimizer (constant
 	   parameter to the unpack_sample() inline function) */
 
+	const size_t done = pcm_simd_unpack_24(dest, src,
+					       (src_end - src) / 3);
+	src += done * 3;
+	dest += done;
+
 	while (src < src_end) {
 		unpack_sample(dest++, src);
 		src += 3;
@@ -0,0 +1,671 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "Simd.hxx"
+
+#if defined(__SSE2__)
+#define HAVE_SSE2_KERNELS
+#include <emmintrin.h>
+
+#if CLANG_OR_GCC_VERSION(4,9)
+/* SSSE3 and AVX2 code is compiled with a "target" attribute and
+   enabled only if the CPU supports it */
+#define HAVE_SSSE3_KERNELS
+#define HAVE_AVX2_KERNELS
+#define gcc_target_ssse3 __attribute__((target("ssse3")))
+#define gcc_target_avx2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef __ARM_NEON__
+#define HAVE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+PcmSimd
+pcm_simd_detect()
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (__builtin_cpu_supports("avx2"))
+		return PcmSimd::AVX2;
+#endif
+
+#ifdef HAVE_SSSE3_KERNELS
+	if (__builtin_cpu_supports("ssse3"))
+		return PcmSimd::SSSE3;
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return PcmSimd::SSE2;
+#elif defined(HAVE_NEON_KERNELS)
+	return PcmSimd::NEON;
+#else
+	return PcmSimd::NONE;
+#endif
+}
+
+const char *
+pcm_simd_name(PcmSimd simd)
+{
+	switch (simd) {
+	case PcmSimd::NONE:
+		break;
+
+	case PcmSimd::NEON:
+		return "neon";
+
+	case PcmSimd::SSE2:
+		return "sse2";
+
+	case PcmSimd::SSSE3:
+		return "ssse3";
+
+	case PcmSimd::AVX2:
+		return "avx2";
+	}
+
+	return "none";
+}
+
+/**
+ * Round down to a multiple of the given block size.
+ */
+static constexpr size_t
+FullBlocks(size_t n, size_t block_size)
+{
+	return n - n % block_size;
+}
+
+#ifdef HAVE_SSE2_KERNELS
+
+static size_t
+Sse2VolumeFloat(float *dest, const float *src, size_t n, float volume)
+{
+	const __m128 v = _mm_set1_ps(volume);
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4)
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), v));
+	return end;
+}
+
+static size_t
+Sse2AddVolFloat(float *a, const float *b, size_t n,
+		float volume1, float volume2)
+{
+	const __m128 v1 = _mm_set1_ps(volume1), v2 = _mm_set1_ps(volume2);
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4) {
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(a + i), v1);
+		const __m128 y = _mm_mul_ps(_mm_loadu_ps(b + i), v2);
+		_mm_storeu_ps(a + i, _mm_add_ps(x, y));
+	}
+	return end;
+}
+
+static size_t
+Sse2AddFloat(float *a, const float *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4)
+		_mm_storeu_ps(a + i, _mm_add_ps(_mm_loadu_ps(a + i),
+						_mm_loadu_ps(b + i)));
+	return end;
+}
+
+static size_t
+Sse2Add16(int16_t *a, const int16_t *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8) {
+		__m128i *p = (__m128i *)(a + i);
+		const __m128i *q = (const __m128i *)(b + i);
+		_mm_storeu_si128(p, _mm_adds_epi16(_mm_loadu_si128(p),
+						   _mm_loadu_si128(q)));
+	}
+	return end;
+}
+
+static size_t
+Sse2Add24(int32_t *a, const int32_t *b, size_t n)
+{
+	/* SSE2 has no 32 bit min/max instructions; emulate them
+	   with comparisons */
+	const __m128i min = _mm_set1_epi32(-0x800000);
+	const __m128i max = _mm_set1_epi32(0x7fffff);
+
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4) {
+		__m128i *p = (__m128i *)(a + i);
+		const __m128i *q = (const __m128i *)(b + i);
+		__m128i sum = _mm_add_epi32(_mm_loadu_si128(p),
+					    _mm_loadu_si128(q));
+
+		const __m128i above = _mm_cmpgt_epi32(sum, max);
+		sum = _mm_or_si128(_mm_and_si128(above, max),
+				   _mm_andnot_si128(above, sum));
+
+		const __m128i below = _mm_cmplt_epi32(sum, min);
+		sum = _mm_or_si128(_mm_and_si128(below, min),
+				   _mm_andnot_si128(below, sum));
+
+		_mm_storeu_si128(p, sum);
+	}
+	return end;
+}
+
+/**
+ * Add two vectors of 32 bit integers with signed saturation.
+ */
+static inline __m128i
+Sse2AddSaturate32(__m128i x, __m128i y)
+{
+	const __m128i sum = _mm_add_epi32(x, y);
+
+	/* the addition has overflowed if both operands have the same
+	   sign, but the sum has a different one */
+	const __m128i overflow =
+		_mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(x, y),
+						_mm_xor_si128(x, sum)),
+			       31);
+
+	/* INT32_MAX for positive operands, INT32_MIN for negative
+	   ones */
+	const __m128i saturated =
+		_mm_xor_si128(_mm_srai_epi32(x, 31),
+			      _mm_set1_epi32(0x7fffffff));
+
+	return _mm_or_si128(_mm_and_si128(overflow, saturated),
+			    _mm_andnot_si128(overflow, sum));
+}
+
+static size_t
+Sse2Add32(int32_t *a, const int32_t *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4) {
+		__m128i *p = (__m128i *)(a + i);
+		const __m128i *q = (const __m128i *)(b + i);
+		_mm_storeu_si128(p, Sse2AddSaturate32(_mm_loadu_si128(p),
+						      _mm_loadu_si128(q)));
+	}
+	return end;
+}
+
+#endif
+
+#ifdef HAVE_SSSE3_KERNELS
+
+gcc_target_ssse3
+static size_t
+Ssse3Pack24(uint8_t *dest, const int32_t *src, size_t n)
+{
+	/* drop the most significant byte of each sample */
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10,
+					      12, 13, 14, -1, -1, -1, -1);
+
+	/* 16 samples (48 bytes) per iteration */
+	const size_t end = FullBlocks(n, 16);
+	for (size_t i = 0; i != end; i += 16, src += 16, dest += 48) {
+		const __m128i *p = (const __m128i *)src;
+		const __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle);
+		const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), shuffle);
+		const __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), shuffle);
+		const __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), shuffle);
+
+		__m128i *q = (__m128i *)dest;
+		_mm_storeu_si128(q, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+		_mm_storeu_si128(q + 1, _mm_or_si128(_mm_srli_si128(b, 4),
+						     _mm_slli_si128(c, 8)));
+		_mm_storeu_si128(q + 2, _mm_or_si128(_mm_srli_si128(c, 8),
+						     _mm_slli_si128(d, 4)));
+	}
+
+	return end;
+}
+
+gcc_target_ssse3
+static inline __m128i
+Ssse3Unpack4(__m128i v)
+{
+	/* move the three bytes to the upper part of each 32 bit
+	   word, and shift back to extend the sign bit */
+	const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5,
+					      -1, 6, 7, 8, -1, 9, 10, 11);
+	return _mm_srai_epi32(_mm_shuffle_epi8(v, shuffle), 8);
+}
+
+gcc_target_ssse3
+static size_t
+Ssse3Unpack24(int32_t *dest, const uint8_t *src, size_t n)
+{
+	/* 16 samples (48 bytes) per iteration */
+	const size_t end = FullBlocks(n, 16);
+	for (size_t i = 0; i != end; i += 16, src += 48, dest += 16) {
+		const __m128i *p = (const __m128i *)src;
+		const __m128i a = _mm_loadu_si128(p);
+		const __m128i b = _mm_loadu_si128(p + 1);
+		const __m128i c = _mm_loadu_si128(p + 2);
+
+		__m128i *q = (__m128i *)dest;
+		_mm_storeu_si128(q, Ssse3Unpack4(a));
+		_mm_storeu_si128(q + 1, Ssse3Unpack4(_mm_alignr_epi8(b, a, 12)));
+		_mm_storeu_si128(q + 2, Ssse3Unpack4(_mm_alignr_epi8(c, b, 8)));
+		_mm_storeu_si128(q + 3, Ssse3Unpack4(_mm_srli_si128(c, 4)));
+	}
+
+	return end;
+}
+
+gcc_target_ssse3
+static size_t
+Ssse3ReverseBytes(uint8_t *dest, const uint8_t *src, size_t size,
+		  __m128i shuffle, size_t step)
+{
+	size_t i = 0;
+	for (; i + 16 <= size; i += step)
+		_mm_storeu_si128((__m128i *)(dest + i),
+				 _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)),
+						  shuffle));
+	return i;
+}
+
+gcc_target_ssse3
+static size_t
+Ssse3ReverseBytes(uint8_t *dest, const uint8_t *src, size_t size,
+		  size_t frame_size)
+{
+	switch (frame_size) {
+	case 3:
+		/* five frames per vector; the last byte is copied
+		   unmodified, and will be overwritten by the next
+		   iteration or by the caller */
+		return Ssse3ReverseBytes(dest, src, size,
+					 _mm_setr_epi8(2, 1, 0, 5, 4, 3,
+						       8, 7, 6, 11, 10, 9,
+						       14, 13, 12, 15),
+					 15);
+
+	case 4:
+		return Ssse3ReverseBytes(dest, src, size,
+					 _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+						       11, 10, 9, 8,
+						       15, 14, 13, 12),
+					 16);
+
+	default:
+		/* the compiler vectorizes the portable 16 bit code
+		   well enough */
+		return 0;
+	}
+}
+
+/**
+ * Can the SSSE3 kernels be used on this CPU?
+ */
+gcc_pure
+static bool
+HaveSsse3()
+{
+	const auto simd = pcm_simd_detect();
+	return simd == PcmSimd::SSSE3 || simd == PcmSimd::AVX2;
+}
+
+#endif
+
+#ifdef HAVE_AVX2_KERNELS
+
+gcc_target_avx2
+static size_t
+Avx2VolumeFloat(float *dest, const float *src, size_t n, float volume)
+{
+	const __m256 v = _mm256_set1_ps(volume);
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8)
+		_mm256_storeu_ps(dest + i,
+				 _mm256_mul_ps(_mm256_loadu_ps(src + i), v));
+	return end;
+}
+
+gcc_target_avx2
+static size_t
+Avx2AddVolFloat(float *a, const float *b, size_t n,
+		float volume1, float volume2)
+{
+	/* no FMA here: it would round differently than the portable
+	   code */
+	const __m256 v1 = _mm256_set1_ps(volume1);
+	const __m256 v2 = _mm256_set1_ps(volume2);
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8) {
+		const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(a + i), v1);
+		const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(b + i), v2);
+		_mm256_storeu_ps(a + i, _mm256_add_ps(x, y));
+	}
+	return end;
+}
+
+gcc_target_avx2
+static size_t
+Avx2AddFloat(float *a, const float *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8)
+		_mm256_storeu_ps(a + i,
+				 _mm256_add_ps(_mm256_loadu_ps(a + i),
+					       _mm256_loadu_ps(b + i)));
+	return end;
+}
+
+gcc_target_avx2
+static size_t
+Avx2Add16(int16_t *a, const int16_t *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 16);
+	for (size_t i = 0; i != end; i += 16) {
+		__m256i *p = (__m256i *)(a + i);
+		const __m256i *q = (const __m256i *)(b + i);
+		_mm256_storeu_si256(p,
+				    _mm256_adds_epi16(_mm256_loadu_si256(p),
+						      _mm256_loadu_si256(q)));
+	}
+	return end;
+}
+
+gcc_target_avx2
+static size_t
+Avx2Add24(int32_t *a, const int32_t *b, size_t n)
+{
+	const __m256i min = _mm256_set1_epi32(-0x800000);
+	const __m256i max = _mm256_set1_epi32(0x7fffff);
+
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8) {
+		__m256i *p = (__m256i *)(a + i);
+		const __m256i *q = (const __m256i *)(b + i);
+		const __m256i sum =
+			_mm256_add_epi32(_mm256_loadu_si256(p),
+					 _mm256_loadu_si256(q));
+		_mm256_storeu_si256(p, _mm256_min_epi32(_mm256_max_epi32(sum,
+									 min),
+							max));
+	}
+	return end;
+}
+
+gcc_target_avx2
+static size_t
+Avx2Add32(int32_t *a, const int32_t *b, size_t n)
+{
+	const __m256i int_max = _mm256_set1_epi32(0x7fffffff);
+
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8) {
+		__m256i *p = (__m256i *)(a + i);
+		const __m256i *q = (const __m256i *)(b + i);
+		const __m256i x = _mm256_loadu_si256(p);
+		const __m256i y = _mm256_loadu_si256(q);
+		const __m256i sum = _mm256_add_epi32(x, y);
+
+		/* see Sse2AddSaturate32() */
+		const __m256i overflow =
+			_mm256_andnot_si256(_mm256_xor_si256(x, y),
+					    _mm256_xor_si256(x, sum));
+		const __m256i saturated =
+			_mm256_xor_si256(_mm256_srai_epi32(x, 31), int_max);
+
+		/* blendv picks by the most significant bit, which is
+		   the overflow flag */
+		_mm256_storeu_si256(p, (__m256i)
+				    _mm256_blendv_ps((__m256)sum,
+						     (__m256)saturated,
+						     (__m256)overflow));
+	}
+	return end;
+}
+
+#endif
+
+#ifdef HAVE_NEON_KERNELS
+
+static size_t
+NeonVolumeFloat(float *dest, const float *src, size_t n, float volume)
+{
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4)
+		vst1q_f32(dest + i, vmulq_n_f32(vld1q_f32(src + i), volume));
+	return end;
+}
+
+static size_t
+NeonAddFloat(float *a, const float *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4)
+		vst1q_f32(a + i, vaddq_f32(vld1q_f32(a + i),
+					   vld1q_f32(b + i)));
+	return end;
+}
+
+static size_t
+NeonAdd16(int16_t *a, const int16_t *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 8);
+	for (size_t i = 0; i != end; i += 8)
+		vst1q_s16(a + i, vqaddq_s16(vld1q_s16(a + i),
+					    vld1q_s16(b + i)));
+	return end;
+}
+
+static size_t
+NeonAdd24(int32_t *a, const int32_t *b, size_t n)
+{
+	const int32x4_t min = vdupq_n_s32(-0x800000);
+	const int32x4_t max = vdupq_n_s32(0x7fffff);
+
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4) {
+		const int32x4_t sum = vaddq_s32(vld1q_s32(a + i),
+						vld1q_s32(b + i));
+		vst1q_s32(a + i, vminq_s32(vmaxq_s32(sum, min), max));
+	}
+	return end;
+}
+
+static size_t
+NeonAdd32(int32_t *a, const int32_t *b, size_t n)
+{
+	const size_t end = FullBlocks(n, 4);
+	for (size_t i = 0; i != end; i += 4)
+		vst1q_s32(a + i, vqaddq_s32(vld1q_s32(a + i),
+					    vld1q_s32(b + i)));
+	return end;
+}
+
+#endif
+
+size_t
+pcm_simd_volume_float(float *dest, const float *src, size_t n, float volume)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2VolumeFloat(dest, src, n, volume);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2VolumeFloat(dest, src, n, volume);
+#elif defined(HAVE_NEON_KERNELS)
+	return NeonVolumeFloat(dest, src, n, volume);
+#else
+	(void)dest;
+	(void)src;
+	(void)n;
+	(void)volume;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_add_vol_float(float *a, const float *b, size_t n,
+		       float volume1, float volume2)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2AddVolFloat(a, b, n, volume1, volume2);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2AddVolFloat(a, b, n, volume1, volume2);
+#else
+	/* no NEON implementation: on ARM, the compiler may contract
+	   the portable code to fused multiply-add instructions, and
+	   a NEON kernel would not be bit-exact */
+	(void)a;
+	(void)b;
+	(void)n;
+	(void)volume1;
+	(void)volume2;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_add_float(float *a, const float *b, size_t n)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2AddFloat(a, b, n);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2AddFloat(a, b, n);
+#elif defined(HAVE_NEON_KERNELS)
+	return NeonAddFloat(a, b, n);
+#else
+	(void)a;
+	(void)b;
+	(void)n;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_add_16(int16_t *a, const int16_t *b, size_t n)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2Add16(a, b, n);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2Add16(a, b, n);
+#elif defined(HAVE_NEON_KERNELS)
+	return NeonAdd16(a, b, n);
+#else
+	(void)a;
+	(void)b;
+	(void)n;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_add_24(int32_t *a, const int32_t *b, size_t n)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2Add24(a, b, n);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2Add24(a, b, n);
+#elif defined(HAVE_NEON_KERNELS)
+	return NeonAdd24(a, b, n);
+#else
+	(void)a;
+	(void)b;
+	(void)n;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_add_32(int32_t *a, const int32_t *b, size_t n)
+{
+#ifdef HAVE_AVX2_KERNELS
+	if (pcm_simd_detect() == PcmSimd::AVX2)
+		return Avx2Add32(a, b, n);
+#endif
+
+#if defined(HAVE_SSE2_KERNELS)
+	return Sse2Add32(a, b, n);
+#elif defined(HAVE_NEON_KERNELS)
+	return NeonAdd32(a, b, n);
+#else
+	(void)a;
+	(void)b;
+	(void)n;
+	return 0;
+#endif
+}
+
+size_t
+pcm_simd_pack_24(uint8_t *dest, const int32_t *src, size_t n)
+{
+#ifdef HAVE_SSSE3_KERNELS
+	if (HaveSsse3())
+		return Ssse3Pack24(dest, src, n);
+#endif
+
+	(void)dest;
+	(void)src;
+	(void)n;
+	return 0;
+}
+
+size_t
+pcm_simd_unpack_24(int32_t *dest, const uint8_t *src, size_t n)
+{
+#ifdef HAVE_SSSE3_KERNELS
+	if (HaveSsse3())
+		return Ssse3Unpack24(dest, src, n);
+#endif
+
+	(void)dest;
+	(void)src;
+	(void)n;
+	return 0;
+}
+
+size_t
+pcm_simd_reverse_bytes(uint8_t *dest, const uint8_t *src, size_t size,
+		       size_t frame_size)
+{
+#ifdef HAVE_SSSE3_KERNELS
+	if (HaveSsse3())
+		return Ssse3ReverseBytes(dest, src, size, frame_size);
+#endif
+
+	(void)dest;
+	(void)src;
+	(void)size;
+	(void)frame_size;
+	return 0;
+}
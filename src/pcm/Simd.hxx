@@ -0,0 +1,131 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_SIMD_HXX
+#define MPD_PCM_SIMD_HXX
+
+#include "Compiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Vectorized kernels for software volume, mixing and packing.
+ *
+ * Each function processes the largest multiple of its block size
+ * and returns the number of samples it has processed; the caller is
+ * responsible for the remaining samples (usually with the portable
+ * per-sample code).  The results are bit-exact with the portable
+ * code.  If no vectorized implementation is available, the
+ * functions return 0.
+ */
+
+/**
+ * An instruction set which is used by the functions in this header.
+ */
+enum class PcmSimd : uint8_t {
+	NONE,
+	NEON,
+	SSE2,
+	SSSE3,
+	AVX2,
+};
+
+/**
+ * Determine which instruction set is used on this CPU.  This is
+ * cheap enough to be called for each buffer.
+ */
+gcc_pure
+PcmSimd
+pcm_simd_detect();
+
+gcc_const
+const char *
+pcm_simd_name(PcmSimd simd);
+
+/**
+ * dest[i] = src[i] * volume
+ */
+size_t
+pcm_simd_volume_float(float *dest, const float *src, size_t n,
+		      float volume);
+
+/**
+ * a[i] = a[i] * volume1 + b[i] * volume2
+ */
+size_t
+pcm_simd_add_vol_float(float *a, const float *b, size_t n,
+		       float volume1, float volume2);
+
+/**
+ * a[i] = a[i] + b[i]
+ */
+size_t
+pcm_simd_add_float(float *a, const float *b, size_t n);
+
+/**
+ * a[i] = a[i] + b[i] with saturation (#SampleFormat::S16).
+ */
+size_t
+pcm_simd_add_16(int16_t *a, const int16_t *b, size_t n);
+
+/**
+ * a[i] = a[i] + b[i] with saturation (#SampleFormat::S24_P32).
+ */
+size_t
+pcm_simd_add_24(int32_t *a, const int32_t *b, size_t n);
+
+/**
+ * a[i] = a[i] + b[i] with saturation (#SampleFormat::S32).
+ */
+size_t
+pcm_simd_add_32(int32_t *a, const int32_t *b, size_t n);
+
+/**
+ * Pack 32 bit samples into 24 bit (3 bytes per sample, host byte
+ * order), see pcm_pack_24().
+ *
+ * @param n the number of samples
+ */
+size_t
+pcm_simd_pack_24(uint8_t *dest, const int32_t *src, size_t n);
+
+/**
+ * Unpack 24 bit samples (3 bytes per sample, host byte order) into
+ * 32 bit, see pcm_unpack_24().
+ *
+ * @param n the number of samples
+ */
+size_t
+pcm_simd_unpack_24(int32_t *dest, const uint8_t *src, size_t n);
+
+/**
+ * Reverse the byte order of each frame, see reverse_bytes().  Unlike
+ * the other functions in this header, sizes are in bytes.
+ *
+ * @param size the size of the buffers in bytes
+ * @param frame_size the size of one frame in bytes
+ * @return the number of bytes processed (a multiple of the frame
+ * size)
+ */
+size_t
+pcm_simd_reverse_bytes(uint8_t *dest, const uint8_t *src, size_t size,
+		       size_t frame_size);
+
+#endif
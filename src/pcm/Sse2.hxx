@@ -0,0 +1,96 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_PCM_SSE2_HXX
+#define MPD_PCM_SSE2_HXX
+
+#include "Traits.hxx"
+#include "FloatConvert.hxx"
+
+#include <emmintrin.h>
+
+/**
+ * Store four 32 bit values.  They must already be in the range of
+ * the destination type.
+ */
+static inline void
+Sse2Store4(int16_t *dest, __m128i v)
+{
+	_mm_storel_epi64((__m128i *)dest, _mm_packs_epi32(v, v));
+}
+
+static inline void
+Sse2Store4(int32_t *dest, __m128i v)
+{
+	_mm_storeu_si128((__m128i *)dest, v);
+}
+
+/**
+ * Returns a where the mask is set, and b elsewhere.
+ */
+static inline __m128i
+Sse2Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/**
+ * Convert floating point samples to integer using SSE2.  This is
+ * bit-exact with #FloatToIntegerSampleConvert (for all input values
+ * which fit into the intermediate integer type of the portable
+ * code).
+ */
+template<SampleFormat F, class Traits=SampleTraits<F>>
+struct Sse2FloatToInteger {
+	typedef SampleTraits<SampleFormat::FLOAT> SrcTraits;
+	typedef Traits DstTraits;
+
+	static constexpr size_t BLOCK_SIZE = 4;
+
+	void Convert(typename DstTraits::pointer_type dst, const float *src,
+		     size_t n) const {
+		const __m128 factor =
+			_mm_set1_ps(FloatToIntegerSampleConvert<F, Traits>::factor);
+
+		/* the smallest value which is too large; this is a
+		   power of two, therefore it can be represented
+		   exactly as float (unlike Traits::MAX) */
+		const __m128 limit = _mm_set1_ps(-float(Traits::MIN));
+
+		const __m128i min = _mm_set1_epi32(Traits::MIN);
+		const __m128i max = _mm_set1_epi32(Traits::MAX);
+
+		for (size_t i = 0; i < n / BLOCK_SIZE;
+		     ++i, src += BLOCK_SIZE, dst += BLOCK_SIZE) {
+			const __m128 v = _mm_mul_ps(_mm_loadu_ps(src), factor);
+
+			/* values which are too large for 32 bit (and
+			   NaN) become INT32_MIN here */
+			__m128i x = _mm_cvttps_epi32(v);
+
+			x = Sse2Select(_mm_cmplt_epi32(x, min), min, x);
+			x = Sse2Select(_mm_castps_si128(_mm_cmpge_ps(v, limit)),
+				       max, x);
+
+			Sse2Store4(dst, x);
+		}
+	}
+};
+
+#endif
@@ -21,7 +21,9 @@
 #include "Volume.hxx"
 #include "Domain.hxx"
 #include "Traits.hxx"
+#include "Simd.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 #include "util/Error.hxx"
 
 #include "PcmDither.cxx" // including the .cxx file to get inlined templates
@@ -91,7 +93,8 @@ static void
 pcm_volume_change_float(float *dest, const float *src, size_t n,
 			float volume)
 {
-	for (size_t i = 0; i != n; ++i)
+	for (size_t i = pcm_simd_volume_float(dest, src, n, volume);
+	     i != n; ++i)
 		dest[i] = src[i] * volume;
 }
 
@@ -123,20 +126,15 @@ PcmVolume::Open(SampleFormat _format, Error &error)
 	return true;
 }
 
-ConstBuffer<void>
-PcmVolume::Apply(ConstBuffer<void> src)
+inline void
+PcmVolume::Change(void *dest, const void *src, size_t size)
 {
-	if (volume == PCM_VOLUME_1)
-		return src;
-
-	void *data = buffer.Get(src.size);
-
 	if (volume == 0) {
 		/* optimized special case: 0% volume = memset(0) */
 		/* TODO: is this valid for all sample formats? What
 		   about floating point? */
-		memset(data, 0, src.size);
-		return { data, src.size };
+		memset(dest, 0, size);
+		return;
 	}
 
 	switch (format) {
@@ -145,44 +143,64 @@ PcmVolume::Apply(ConstBuffer<void> src)
 		gcc_unreachable();
 
 	case SampleFormat::S8:
-		pcm_volume_change_8(dither, (int8_t *)data,
-				    (const int8_t *)src.data,
-				    src.size / sizeof(int8_t),
+		pcm_volume_change_8(dither, (int8_t *)dest,
+				    (const int8_t *)src,
+				    size / sizeof(int8_t),
 				    volume);
 		break;
 
 	case SampleFormat::S16:
-		pcm_volume_change_16(dither, (int16_t *)data,
-				     (const int16_t *)src.data,
-				     src.size / sizeof(int16_t),
+		pcm_volume_change_16(dither, (int16_t *)dest,
+				     (const int16_t *)src,
+				     size / sizeof(int16_t),
 				     volume);
 		break;
 
 	case SampleFormat::S24_P32:
-		pcm_volume_change_24(dither, (int32_t *)data,
-				     (const int32_t *)src.data,
-				     src.size / sizeof(int32_t),
+		pcm_volume_change_24(dither, (int32_t *)dest,
+				     (const int32_t *)src,
+				     size / sizeof(int32_t),
 				     volume);
 		break;
 
 	case SampleFormat::S32:
-		pcm_volume_change_32(dither, (int32_t *)data,
-				     (const int32_t *)src.data,
-				     src.size / sizeof(int32_t),
+		pcm_volume_change_32(dither, (int32_t *)dest,
+				     (const int32_t *)src,
+				     size / sizeof(int32_t),
 				     volume);
 		break;
 
 	case SampleFormat::FLOAT:
-		pcm_volume_change_float((float *)data,
-					(const float *)src.data,
-					src.size / sizeof(float),
+		pcm_volume_change_float((float *)dest,
+					(const float *)src,
+					size / sizeof(float),
 					pcm_volume_to_float(volume));
 		break;
 
 	case SampleFormat::DSD:
 		// TODO: implement this; currently, it's a no-op
-		return src;
+		if (dest != src)
+			memcpy(dest, src, size);
+		break;
 	}
+}
 
+ConstBuffer<void>
+PcmVolume::Apply(ConstBuffer<void> src)
+{
+	if (volume == PCM_VOLUME_1)
+		return src;
+
+	void *data = buffer.Get(src.size);
+	Change(data, src.data, src.size);
 	return { data, src.size };
 }
+
+WritableBuffer<void>
+PcmVolume::ApplyInPlace(WritableBuffer<void> src)
+{
+	if (volume != PCM_VOLUME_1)
+		Change(src.data, src.data, src.size);
+
+	return src;
+}
@@ -30,6 +30,7 @@
 
 class Error;
 template<typename T> struct ConstBuffer;
+template<typename T> struct WritableBuffer;
 
 /**
  * Number of fractional bits for a fixed-point volume value.
@@ -114,6 +115,16 @@ public:
 	 */
 	gcc_pure
 	ConstBuffer<void> Apply(ConstBuffer<void> src);
+
+	/**
+	 * Apply the volume level, modifying the given buffer.
+	 *
+	 * @return the buffer (always #src)
+	 */
+	WritableBuffer<void> ApplyInPlace(WritableBuffer<void> src);
+
+private:
+	void Change(void *dest, const void *src, size_t size);
 };
 
 #endif
@@ -21,6 +21,7 @@
 #include "Control.hxx"
 #include "Idle.hxx"
 #include "DetachedSong.hxx"
+#include "MusicBuffer.hxx"
 
 #include <algorithm>
 
@@ -29,17 +30,24 @@
 PlayerControl::PlayerControl(PlayerListener &_listener,
 			     MultipleOutputs &_outputs,
 			     unsigned _buffer_chunks,
-			     unsigned _buffered_before_play)
+			     size_t _chunk_size,
+			     unsigned _buffered_before_play,
+			     bool _adaptive_buffering,
+			     bool _lock_free_pipe)
 	:listener(_listener), outputs(_outputs),
 	 buffer_chunks(_buffer_chunks),
+	 chunk_size(_chunk_size),
 	 buffered_before_play(_buffered_before_play),
+	 adaptive_buffering(_adaptive_buffering),
+	 lock_free_pipe(_lock_free_pipe),
 	 command(PlayerCommand::NONE),
 	 state(PlayerState::STOP),
 	 error_type(PlayerError::NONE),
 	 tagged_song(nullptr),
 	 next_song(nullptr),
 	 total_play_time(0),
-	 border_pause(false)
+	 border_pause(false),
+	 buffer(nullptr)
 {
 }
 
@@ -275,3 +283,10 @@ PlayerControl::SetMixRampDelay(float _mixramp_delay_seconds)
 
 	idle_add(IDLE_OPTIONS);
 }
+
+unsigned long
+PlayerControl::LockGetBufferContention() const
+{
+	const ScopeLock protect(mutex);
+	return buffer != nullptr ? buffer->GetContention() : 0;
+}
@@ -28,10 +28,12 @@
 #include "CrossFade.hxx"
 #include "Chrono.hxx"
 
+#include <stddef.h>
 #include <stdint.h>
 
 class PlayerListener;
 class MultipleOutputs;
+class MusicBuffer;
 class DetachedSong;
 
 enum class PlayerState : uint8_t {
@@ -100,8 +102,27 @@ struct PlayerControl {
 
 	const unsigned buffer_chunks;
 
+	/**
+	 * The size of MusicChunk::data in bytes.
+	 */
+	const size_t chunk_size;
+
 	const unsigned buffered_before_play;
 
+	/**
+	 * Decide for each song how much of #buffered_before_play
+	 * needs to be decoded before playback begins?  Network
+	 * streams always use the full amount, but local files may
+	 * start earlier if the decoder is fast enough.
+	 */
+	const bool adaptive_buffering;
+
+	/**
+	 * Use a lock-free #MusicBuffer and lock-free #MusicPipe
+	 * instances between the decoder and the player thread?
+	 */
+	const bool lock_free_pipe;
+
 	/**
 	 * The handle of the player thread.
 	 */
@@ -177,10 +198,19 @@ struct PlayerControl {
 	 */
 	bool border_pause;
 
+	/**
+	 * The #MusicBuffer owned by the player thread, or nullptr if
+	 * the thread is not running.  Protected by #mutex.
+	 */
+	const MusicBuffer *buffer;
+
 	PlayerControl(PlayerListener &_listener,
 		      MultipleOutputs &_outputs,
 		      unsigned buffer_chunks,
-		      unsigned buffered_before_play);
+		      size_t chunk_size,
+		      unsigned buffered_before_play,
+		      bool adaptive_buffering,
+		      bool lock_free_pipe);
 	~PlayerControl();
 
 	/**
@@ -465,6 +495,14 @@ public:
 	double GetTotalPlayTime() const {
 		return total_play_time;
 	}
+
+	/**
+	 * Returns the contention counter of the #MusicBuffer (see
+	 * MusicBuffer::GetContention()), or 0 if the player thread is
+	 * not running.
+	 */
+	gcc_pure
+	unsigned long LockGetBufferContention() const;
 };
 
 #endif
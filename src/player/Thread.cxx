@@ -25,6 +25,7 @@
 #include "MusicPipe.hxx"
 #include "MusicBuffer.hxx"
 #include "MusicChunk.hxx"
+#include "PipelineStats.hxx"
 #include "DetachedSong.hxx"
 #include "CrossFade.hxx"
 #include "Control.hxx"
@@ -33,12 +34,27 @@
 #include "Idle.hxx"
 #include "util/Domain.hxx"
 #include "thread/Name.hxx"
+#include "system/Clock.hxx"
 #include "Log.hxx"
 
+#include <algorithm>
+
 #include <string.h>
 
 static constexpr Domain player_domain("player");
 
+/**
+ * With adaptive buffering, playback of a local file may begin as
+ * soon as this much audio has been decoded [us] ...
+ */
+static constexpr uint64_t ADAPTIVE_BUFFER_MIN_US = 200000;
+
+/**
+ * ... and if the decoder has been at least this many times faster
+ * than real time so far.
+ */
+static constexpr unsigned ADAPTIVE_BUFFER_MIN_SPEED = 4;
+
 class Player {
 	PlayerControl &pc;
 
@@ -53,6 +69,13 @@ class Player {
 	 */
 	bool buffering;
 
+	/**
+	 * The time stamp (MonotonicClockUS()) when #buffering was
+	 * set.  It is used to estimate the decoder's speed for
+	 * adaptive buffering.
+	 */
+	uint64_t buffering_start;
+
 	/**
 	 * true if the decoder is starting and did not provide data
 	 * yet
@@ -147,7 +170,7 @@ public:
 	Player(PlayerControl &_pc, DecoderControl &_dc,
 	       MusicBuffer &_buffer)
 		:pc(_pc), dc(_dc), buffer(_buffer),
-		 buffering(true),
+		 buffering(true), buffering_start(MonotonicClockUS()),
 		 decoder_starting(false),
 		 decoder_woken(false),
 		 paused(false),
@@ -168,6 +191,31 @@ private:
 		xfade_state = CrossFadeState::UNKNOWN;
 	}
 
+	/**
+	 * Create a new #MusicPipe for the decoder.  In lock-free
+	 * mode, it is a single-producer/single-consumer ring which
+	 * can hold all chunks of the #MusicBuffer.
+	 */
+	MusicPipe *NewPipe() const {
+		return buffer.IsLockFree()
+			? new MusicPipe(buffer.GetSize())
+			: new MusicPipe();
+	}
+
+	void StartBuffering() {
+		buffering = true;
+		buffering_start = MonotonicClockUS();
+	}
+
+	/**
+	 * Has enough been decoded to begin playback?  Without
+	 * adaptive buffering, this waits for
+	 * PlayerControl::buffered_before_play chunks.
+	 *
+	 * The player lock is not held.
+	 */
+	bool IsBufferFilled() const;
+
 	void ClearAndDeletePipe() {
 		pipe->Clear(buffer);
 		delete pipe;
@@ -333,6 +381,39 @@ public:
 	void Run();
 };
 
+bool
+Player::IsBufferFilled() const
+{
+	const unsigned n_chunks = pipe->GetSize();
+	if (n_chunks >= pc.buffered_before_play)
+		return true;
+
+	if (!pc.adaptive_buffering || n_chunks == 0 ||
+	    dc.song == nullptr || dc.song->IsRemote())
+		/* network streams may stall at any time; they always
+		   fill the whole configured buffer */
+		return false;
+
+	dc.Lock();
+	const AudioFormat audio_format = dc.IsStarting()
+		? AudioFormat::Undefined()
+		: dc.out_audio_format;
+	dc.Unlock();
+
+	if (!audio_format.IsValid())
+		return false;
+
+	/* a local file: begin playback early if the decoder has been
+	   much faster than real time so far */
+
+	const uint64_t decoded_us = n_chunks * buffer.GetChunkSize()
+		/ audio_format.GetTimeToSize() * 1000000;
+	const uint64_t elapsed_us = MonotonicClockUS() - buffering_start;
+
+	return decoded_us >= ADAPTIVE_BUFFER_MIN_US &&
+		decoded_us >= elapsed_us * ADAPTIVE_BUFFER_MIN_SPEED;
+}
+
 void
 Player::StartDecoder(MusicPipe &_pipe)
 {
@@ -542,8 +623,10 @@ Player::SendSilence()
 
 	const size_t frame_size = play_audio_format.GetFrameSize();
 	/* this formula ensures that we don't send
-	   partial frames */
-	unsigned num_frames = sizeof(chunk->data) / frame_size;
+	   partial frames; large chunks are not filled completely to
+	   avoid adding more latency than necessary */
+	unsigned num_frames = std::min(chunk->capacity, CHUNK_SIZE)
+		/ frame_size;
 
 	chunk->time = SignedSongTime::Negative(); /* undefined time stamp */
 	chunk->length = num_frames * frame_size;
@@ -627,7 +710,7 @@ Player::SeekDecoder()
 	assert(xfade_state == CrossFadeState::UNKNOWN);
 
 	/* re-fill the buffer after seeking */
-	buffering = true;
+	StartBuffering();
 
 	return true;
 }
@@ -659,7 +742,7 @@ Player::ProcessCommand()
 
 		pc.Unlock();
 		if (dc.LockIsIdle())
-			StartDecoder(*new MusicPipe());
+			StartDecoder(*NewPipe());
 		pc.Lock();
 
 		break;
@@ -881,6 +964,14 @@ Player::PlayNextChunk()
 
 	assert(chunk != nullptr);
 
+	if (pipeline_stats_enabled) {
+		auto &stats = pipeline_player_stats;
+		if (chunk->decoded_time != 0)
+			stats.decoder_latency.Add(pipeline_stats_now()
+						  - chunk->decoded_time);
+		stats.decoder_depth.Add(pipe->GetSize());
+	}
+
 	/* insert the postponed tag if cross-fading is finished */
 
 	if (xfade_state != CrossFadeState::ACTIVE && cross_fade_tag != nullptr) {
@@ -958,7 +1049,7 @@ Player::SongBorder()
 inline void
 Player::Run()
 {
-	pipe = new MusicPipe();
+	pipe = NewPipe();
 
 	StartDecoder(*pipe);
 	ActivateDecoder();
@@ -985,8 +1076,7 @@ Player::Run()
 			   until the buffer is large enough, to
 			   prevent stuttering on slow machines */
 
-			if (pipe->GetSize() < pc.buffered_before_play &&
-			    !dc.LockIsIdle()) {
+			if (!IsBufferFilled() && !dc.LockIsIdle()) {
 				/* not enough decoded buffer space yet */
 
 				if (!paused && output_open &&
@@ -1028,7 +1118,7 @@ Player::Run()
 
 			assert(dc.pipe == nullptr || dc.pipe == pipe);
 
-			StartDecoder(*new MusicPipe());
+			StartDecoder(*NewPipe());
 		}
 
 		if (/* no cross-fading if MPD is going to pause at the
@@ -1048,6 +1138,7 @@ Player::Run()
 							dc.GetMixRampPreviousEnd(),
 							dc.out_audio_format,
 							play_audio_format,
+							buffer.GetChunkSize(),
 							buffer.GetSize() -
 							pc.buffered_before_play);
 			if (cross_fade_chunks > 0)
@@ -1151,9 +1242,10 @@ player_task(void *arg)
 	DecoderControl dc(pc.mutex, pc.cond);
 	decoder_thread_start(dc);
 
-	MusicBuffer buffer(pc.buffer_chunks);
+	MusicBuffer buffer(pc.buffer_chunks, pc.chunk_size, pc.lock_free_pipe);
 
 	pc.Lock();
+	pc.buffer = &buffer;
 
 	while (1) {
 		switch (pc.command) {
@@ -1207,7 +1299,10 @@ player_task(void *arg)
 
 			pc.outputs.Close();
 
-			pc.LockCommandFinished();
+			pc.Lock();
+			pc.buffer = nullptr;
+			pc.CommandFinished();
+			pc.Unlock();
 			return;
 
 		case PlayerCommand::CANCEL:
@@ -38,6 +38,9 @@ merge_song_metadata(DetachedSong &add, const DetachedSong &base)
 		TagBuilder builder(add.GetTag());
 		builder.Complement(base.GetTag());
 		add.SetTag(builder.Commit());
+
+		if (base.HasPartialTag())
+			add.SetPartialTag();
 	}
 
 	add.SetLastModified(base.GetLastModified());
@@ -58,8 +61,12 @@ playlist_check_load_song(DetachedSong &song, const SongLoader &loader)
 		return false;
 
 	song.SetURI(tmp->GetURI());
-	if (!song.HasRealURI() && tmp->HasRealURI())
-		song.SetRealURI(tmp->GetRealURI());
+	if (!song.HasRealURI()) {
+		if (tmp->HasRealURI())
+			song.SetRealURI(tmp->GetRealURI());
+		else if (tmp->HasRemoteStorage())
+			song.SetRemoteStorage();
+	}
 
 	merge_song_metadata(song, *tmp);
 	delete tmp;
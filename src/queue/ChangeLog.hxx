@@ -0,0 +1,165 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef MPD_QUEUE_CHANGE_LOG_HXX
+#define MPD_QUEUE_CHANGE_LOG_HXX
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * A bounded log of position ranges in the #Queue which have been
+ * modified, tagged with the queue version.  It allows answering
+ * "plchanges" without comparing the version of each queue item.
+ *
+ * Ranges are recorded with the positions they had at the time of the
+ * modification.  This is good enough, because every operation which
+ * moves songs marks them as modified at their new positions.
+ */
+class QueueChangeLog {
+public:
+	struct Range {
+		unsigned start, end;
+	};
+
+private:
+	struct Entry {
+		uint32_t version;
+		unsigned start, end;
+	};
+
+	static constexpr unsigned CAPACITY = 1024;
+
+	/**
+	 * A ring buffer of entries, the oldest one at #head.  The
+	 * version numbers are non-decreasing.
+	 */
+	Entry entries[CAPACITY];
+
+	unsigned head = 0, n_entries = 0;
+
+	/**
+	 * The log contains all modifications with this version
+	 * number or newer.
+	 */
+	uint32_t min_version = 0;
+
+	/**
+	 * Is the log usable at all?  This is cleared when the queue's
+	 * version number wraps around.
+	 */
+	bool valid = true;
+
+public:
+	/**
+	 * Forget all entries.  Call this after the queue has been
+	 * cleared; from now on, the log is complete again.
+	 */
+	void Reset() {
+		head = n_entries = 0;
+		min_version = 0;
+		valid = true;
+	}
+
+	/**
+	 * Forget all entries and disable the log until the next
+	 * Reset() call.
+	 */
+	void Invalidate() {
+		Reset();
+		valid = false;
+	}
+
+	/**
+	 * Record a modification of the specified position range.
+	 * If it touches the range of the previous entry with the same
+	 * version, both are merged.
+	 */
+	void Add(uint32_t version, unsigned start, unsigned end) {
+		assert(start <= end);
+
+		if (start == end || !valid)
+			return;
+
+		if (n_entries > 0) {
+			Entry &last = entries[(head + n_entries - 1) % CAPACITY];
+			assert(version >= last.version);
+
+			if (version == last.version &&
+			    start <= last.end && end >= last.start) {
+				last.start = std::min(last.start, start);
+				last.end = std::max(last.end, end);
+				return;
+			}
+		}
+
+		if (n_entries == CAPACITY) {
+			/* discard the oldest entry */
+			min_version = entries[head].version + 1;
+			head = (head + 1) % CAPACITY;
+			--n_entries;
+		}
+
+		entries[(head + n_entries++) % CAPACITY] = {version, start, end};
+	}
+
+	/**
+	 * Obtain the (sorted and merged) position ranges which may
+	 * have been modified since the specified version.
+	 *
+	 * @return false if the log does not reach back far enough;
+	 * the caller must then check all positions
+	 */
+	bool GetRanges(uint32_t version, std::vector<Range> &ranges) const {
+		if (!valid || version < min_version)
+			return false;
+
+		for (unsigned i = n_entries; i > 0; --i) {
+			const Entry &entry = entries[(head + i - 1) % CAPACITY];
+			if (entry.version < version)
+				break;
+
+			ranges.push_back({entry.start, entry.end});
+		}
+
+		std::sort(ranges.begin(), ranges.end(),
+			  [](const Range &a, const Range &b){
+				  return a.start < b.start;
+			  });
+
+		/* merge overlapping ranges */
+
+		auto dest = ranges.begin();
+		for (auto i = ranges.begin(); i != ranges.end(); ++i) {
+			if (dest != ranges.begin() && i->start <= dest[-1].end)
+				dest[-1].end = std::max(dest[-1].end, i->end);
+			else
+				*dest++ = *i;
+		}
+
+		ranges.erase(dest, ranges.end());
+		return true;
+	}
+};
+
+#endif
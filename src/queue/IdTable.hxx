@@ -73,6 +73,28 @@ public:
 		return id;
 	}
 
+	/**
+	 * Like Insert(), but attempt to use the given id, e.g. one
+	 * which was restored from the state file.  If it is not
+	 * available, a new one is generated.
+	 */
+	unsigned Insert(unsigned id, unsigned position) {
+		if (id == 0 || id >= size || data[id] >= 0)
+			return Insert(position);
+
+		data[id] = position;
+
+		/* continue generating ids after this one, just like
+		   before the restart */
+		if (id >= next) {
+			next = id + 1;
+			if (next == size)
+				next = 1;
+		}
+
+		return id;
+	}
+
 	void Move(unsigned id, unsigned position) {
 		assert(id < size);
 		assert(data[id] >= 0);
@@ -23,6 +23,7 @@
 #include "PlaylistError.hxx"
 #include "player/Control.hxx"
 #include "DetachedSong.hxx"
+#include "Mapper.hxx"
 #include "Log.hxx"
 
 #include <assert.h>
@@ -43,6 +44,15 @@ playlist::TagModified(DetachedSong &&song)
 	OnModified();
 }
 
+DetachedSong *
+playlist::DupForPlayer(const DetachedSong &song)
+{
+	DetachedSong *copy = new DetachedSong(song);
+	if (!song.HasRealURI() && song.IsInDatabase())
+		copy->SetRealURI(map_song_real_uri(song));
+	return copy;
+}
+
 inline void
 playlist::QueueSongOrder(PlayerControl &pc, unsigned order)
 
@@ -56,7 +66,7 @@ playlist::QueueSongOrder(PlayerControl &pc, unsigned order)
 	FormatDebug(playlist_domain, "queue song %i:\"%s\"",
 		    queued, song.GetURI());
 
-	pc.LockEnqueueSong(new DetachedSong(song));
+	pc.LockEnqueueSong(DupForPlayer(song));
 }
 
 void
@@ -163,7 +173,7 @@ playlist::PlayOrder(PlayerControl &pc, unsigned order, Error &error)
 
 	current = order;
 
-	if (!pc.Play(new DetachedSong(song), error))
+	if (!pc.Play(DupForPlayer(song), error))
 		return false;
 
 	SongStarted();
@@ -22,6 +22,8 @@
 
 #include "queue/Queue.hxx"
 
+#include <vector>
+
 enum TagType : uint8_t;
 struct PlayerControl;
 class DetachedSong;
@@ -163,6 +165,16 @@ protected:
 	 */
 	void UpdateQueuedSong(PlayerControl &pc, const DetachedSong *prev);
 
+	/**
+	 * Create the copy of a queue song which is handed to the
+	 * player (and from there to the decoder via
+	 * DecoderControl::song).  Songs from the database get their
+	 * "real" URI mapped here, in the main thread, because the
+	 * queue doesn't store it.
+	 */
+	gcc_malloc
+	static DetachedSong *DupForPlayer(const DetachedSong &song);
+
 	/**
 	 * Queue a song, addressed by its order number.
 	 */
@@ -208,6 +220,16 @@ public:
 	 */
 	unsigned AppendSong(PlayerControl &pc, DetachedSong &&song);
 
+	/**
+	 * Append many songs at once.  This is cheaper than calling
+	 * AppendSong() for each of them, because the "queued" song
+	 * and the version number are updated only once.
+	 *
+	 * Throws PlaylistError if the queue would be too large; in
+	 * that case, the songs which still fit have been appended.
+	 */
+	void AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &&songs);
+
 	/**
 	 * @return the new song id or 0 on error
 	 */
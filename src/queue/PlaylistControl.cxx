@@ -221,7 +221,7 @@ playlist::SeekSongOrder(PlayerControl &pc, unsigned i, SongTime seek_time,
 
 	queued = -1;
 
-	if (!pc.LockSeek(new DetachedSong(queue.GetOrder(i)), seek_time, error)) {
+	if (!pc.LockSeek(DupForPlayer(queue.GetOrder(i)), seek_time, error)) {
 		UpdateQueuedSong(pc, queued_song);
 		return false;
 	}
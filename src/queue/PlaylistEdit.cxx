@@ -122,6 +122,41 @@ playlist::AppendSong(PlayerControl &pc, DetachedSong &&song)
 	return id;
 }
 
+void
+playlist::AppendSongs(PlayerControl &pc, std::vector<DetachedSong> &&songs)
+{
+	if (songs.empty())
+		return;
+
+	const DetachedSong *const queued_song = GetQueuedSong();
+
+	/* the songs will be shuffled into the list of remaining
+	   songs to play */
+	const unsigned shuffle_start = queued >= 0
+		? queued + 1
+		: current + 1;
+
+	const unsigned n = std::min<size_t>(songs.size(),
+					    queue.max_length - queue.GetLength());
+
+	for (unsigned i = 0; i < n; ++i) {
+		queue.Append(std::move(songs[i]), 0);
+
+		if (queue.random && shuffle_start < queue.GetLength())
+			queue.ShuffleOrderLast(shuffle_start,
+					       queue.GetLength());
+	}
+
+	if (n > 0) {
+		UpdateQueuedSong(pc, queued_song);
+		OnModified();
+	}
+
+	if (n < songs.size())
+		throw PlaylistError(PlaylistResult::TOO_LARGE,
+				    "Playlist is too large");
+}
+
 unsigned
 playlist::AppendURI(PlayerControl &pc, const SongLoader &loader,
 		    const char *uri,
@@ -291,9 +326,58 @@ playlist::DeleteRange(PlayerControl &pc, unsigned start, unsigned end)
 
 	const DetachedSong *queued_song = GetQueuedSong();
 
-	do {
-		DeleteInternal(pc, --end, &queued_song);
-	} while (end != start);
+	int current_position = GetCurrentPosition();
+	if (current_position >= (int)start && current_position < (int)end) {
+		/* the current song is going to be deleted: see which
+		   song after the deleted range is going to be played
+		   instead */
+
+		int next = current;
+		do {
+			next = queue.GetNextOrder(next);
+		} while (next >= 0 && next != current &&
+			 queue.OrderToPosition(next) >= start &&
+			 queue.OrderToPosition(next) < end);
+
+		if (next == current)
+			next = -1;
+
+		if (playing) {
+			const bool paused = pc.GetState() == PlayerState::PAUSE;
+
+			if (next >= 0 && !paused)
+				/* play the song after the deleted ones */
+				/* TODO: log error? */
+				PlayOrder(pc, next, IgnoreError());
+			else {
+				/* stop the player */
+
+				pc.LockStop();
+				playing = false;
+			}
+
+			queued_song = nullptr;
+			current_position = next >= 0
+				? (int)queue.OrderToPosition(next)
+				: -1;
+		} else
+			/* there's a "current song" but we're not
+			   playing currently - clear "current" */
+			current_position = -1;
+	}
+
+	/* now do it: remove the songs */
+
+	queue.DeleteRange(start, end);
+
+	/* update the "current" variable */
+
+	if (current_position >= (int)end)
+		current_position -= end - start;
+
+	current = current_position >= 0
+		? (int)queue.PositionToOrder(current_position)
+		: -1;
 
 	UpdateQueuedSong(pc, queued_song);
 	OnModified();
@@ -29,14 +29,18 @@
 #include "queue/QueueSave.hxx"
 #include "fs/io/TextFile.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
+#include "fs/Path.hxx"
 #include "player/Control.hxx"
 #include "config/ConfigGlobal.hxx"
 #include "config/ConfigOption.hxx"
 #include "util/CharUtil.hxx"
 #include "util/StringAPI.hxx"
 #include "util/StringCompare.hxx"
+#include "util/Error.hxx"
 #include "Log.hxx"
 
+#include <stdexcept>
+
 #include <string.h>
 #include <stdlib.h>
 
@@ -52,6 +56,7 @@
 #define PLAYLIST_STATE_FILE_MIXRAMPDELAY	"mixrampdelay: "
 #define PLAYLIST_STATE_FILE_PLAYLIST_BEGIN	"playlist_begin"
 #define PLAYLIST_STATE_FILE_PLAYLIST_END	"playlist_end"
+#define PLAYLIST_STATE_FILE_PLAYLIST_BINARY	"playlist_binary"
 
 #define PLAYLIST_STATE_FILE_STATE_PLAY		"play"
 #define PLAYLIST_STATE_FILE_STATE_PAUSE		"pause"
@@ -59,7 +64,7 @@
 
 void
 playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
-		    PlayerControl &pc)
+		    PlayerControl &pc, bool binary_queue)
 {
 	const auto player_status = pc.LockGetStatus();
 
@@ -94,6 +99,12 @@ playlist_state_save(BufferedOutputStream &os, const struct playlist &playlist,
 	os.Format(PLAYLIST_STATE_FILE_MIXRAMPDB "%f\n", pc.GetMixRampDb());
 	os.Format(PLAYLIST_STATE_FILE_MIXRAMPDELAY "%f\n",
 		  pc.GetMixRampDelay());
+
+	if (binary_queue) {
+		os.Write(PLAYLIST_STATE_FILE_PLAYLIST_BINARY "\n");
+		return;
+	}
+
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_BEGIN "\n");
 	queue_save(os, playlist.queue);
 	os.Write(PLAYLIST_STATE_FILE_PLAYLIST_END "\n");
@@ -109,8 +120,10 @@ playlist_state_load(TextFile &file, const SongLoader &song_loader,
 		return;
 	}
 
+	QueueLoader loader(song_loader);
+
 	while (!StringStartsWith(line, PLAYLIST_STATE_FILE_PLAYLIST_END)) {
-		queue_load_song(file, song_loader, line, playlist.queue);
+		loader.LoadLine(file, line);
 
 		line = file.ReadLine();
 		if (line == nullptr) {
@@ -121,12 +134,34 @@ playlist_state_load(TextFile &file, const SongLoader &song_loader,
 		}
 	}
 
+	loader.Commit(playlist.queue);
+	playlist.queue.IncrementVersion();
+}
+
+static void
+playlist_state_load_binary(Path path, const SongLoader &song_loader,
+			   struct playlist &playlist)
+{
+	QueueLoader loader(song_loader);
+
+	try {
+		Error error;
+		if (!loader.LoadBinary(path, error)) {
+			LogError(error, "Failed to load the queue file");
+			return;
+		}
+	} catch (const std::runtime_error &e) {
+		LogError(e);
+		return;
+	}
+
+	loader.Commit(playlist.queue);
 	playlist.queue.IncrementVersion();
 }
 
 bool
 playlist_state_restore(const char *line, TextFile &file,
-		       const SongLoader &song_loader,
+		       const SongLoader &song_loader, Path queue_path,
 		       struct playlist &playlist, PlayerControl &pc)
 {
 	int current = -1;
@@ -171,6 +206,10 @@ playlist_state_restore(const char *line, TextFile &file,
 		} else if (StringStartsWith(line,
 					    PLAYLIST_STATE_FILE_PLAYLIST_BEGIN)) {
 			playlist_state_load(file, song_loader, playlist);
+		} else if (StringIsEqual(line,
+					 PLAYLIST_STATE_FILE_PLAYLIST_BINARY)) {
+			playlist_state_load_binary(queue_path, song_loader,
+						   playlist);
 		}
 	}
 
@@ -194,7 +233,8 @@ playlist_state_restore(const char *line, TextFile &file,
 			pc.LockUpdateAudio();
 
 		if (state == PlayerState::STOP /* && config_option */)
-			playlist.current = current;
+			playlist.current =
+				playlist.queue.PositionToOrder(current);
 		else if (seek_time.count() == 0)
 			/* TODO: log error? */
 			playlist.PlayPosition(pc, current, IgnoreError());
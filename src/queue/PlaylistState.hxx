@@ -30,14 +30,24 @@ struct PlayerControl;
 class TextFile;
 class BufferedOutputStream;
 class SongLoader;
+class Path;
 
+/**
+ * @param binary_queue if true, then the queue itself is not written
+ * to the state file; it is saved separately with queue_save_binary()
+ * by the caller
+ */
 void
 playlist_state_save(BufferedOutputStream &os, const playlist &playlist,
-		    PlayerControl &pc);
+		    PlayerControl &pc, bool binary_queue);
 
+/**
+ * @param queue_path the file written by queue_save_binary(), which is
+ * loaded if the state file refers to it
+ */
 bool
 playlist_state_restore(const char *line, TextFile &file,
-		       const SongLoader &song_loader,
+		       const SongLoader &song_loader, Path queue_path,
 		       playlist &playlist, PlayerControl &pc);
 
 /**
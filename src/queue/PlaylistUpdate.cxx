@@ -54,6 +54,8 @@ UpdatePlaylistSong(const Database &db, DetachedSong &song)
 
 	song.SetLastModified(original->mtime);
 	song.SetTag(*original->tag);
+	if (original->partial_tag)
+		song.SetPartialTag();
 
 	db.ReturnSong(original);
 	return true;
@@ -26,6 +26,7 @@ Queue::Queue(unsigned _max_length)
 	 version(1),
 	 items(new Item[max_length]),
 	 order(new unsigned[max_length]),
+	 position_order(new unsigned[max_length]),
 	 id_table(max_length * HASH_MULT),
 	 repeat(false),
 	 single(false),
@@ -40,6 +41,7 @@ Queue::~Queue()
 
 	delete[] items;
 	delete[] order;
+	delete[] position_order;
 }
 
 int
@@ -71,6 +73,10 @@ Queue::IncrementVersion()
 			items[i].version = 0;
 
 		version = 1;
+
+		/* all items are "new" now; the change log can't
+		   represent that */
+		changes.Invalidate();
 	}
 }
 
@@ -84,12 +90,12 @@ Queue::ModifyAtOrder(unsigned _order)
 }
 
 unsigned
-Queue::Append(DetachedSong &&song, uint8_t priority)
+Queue::Append(DetachedSong &&song, uint8_t priority, unsigned id)
 {
 	assert(!IsFull());
 
 	const unsigned position = length++;
-	const unsigned id = id_table.Insert(position);
+	id = id_table.Insert(id, position);
 
 	auto &item = items[position];
 	item.song = new DetachedSong(std::move(song));
@@ -98,6 +104,9 @@ Queue::Append(DetachedSong &&song, uint8_t priority)
 	item.priority = priority;
 
 	order[position] = position;
+	position_order[position] = position;
+
+	changes.Add(version, position, position + 1);
 
 	return id;
 }
@@ -115,84 +124,60 @@ Queue::SwapPositions(unsigned position1, unsigned position2)
 
 	id_table.Move(id1, position2);
 	id_table.Move(id2, position1);
+
+	changes.Add(version, position1, position1 + 1);
+	changes.Add(version, position2, position2 + 1);
 }
 
 void
 Queue::MovePostion(unsigned from, unsigned to)
 {
-	const Item tmp = items[from];
-
-	/* move songs to one less in from->to */
-
-	for (unsigned i = from; i < to; i++)
-		MoveItemTo(i + 1, i);
-
-	/* move songs to one more in to->from */
-
-	for (unsigned i = from; i > to; i--)
-		MoveItemTo(i - 1, i);
-
-	/* put song at _to_ */
-
-	id_table.Move(tmp.id, to);
-	items[to] = tmp;
-	items[to].version = version;
-
-	/* now deal with order */
-
-	if (random) {
-		for (unsigned i = 0; i < length; i++) {
-			if (order[i] > from && order[i] <= to)
-				order[i]--;
-			else if (order[i] < from &&
-				 order[i] >= to)
-				order[i]++;
-			else if (from == order[i])
-				order[i] = to;
-		}
-	}
+	MoveRange(from, from + 1, to);
 }
 
 void
 Queue::MoveRange(unsigned start, unsigned end, unsigned to)
 {
-	Item tmp[end - start];
-	// Copy the original block [start,end-1]
-	for (unsigned i = start; i < end; i++)
-		tmp[i - start] = items[i];
-
-	// If to > start, we need to move to-start items to start, starting from end
-	for (unsigned i = end; i < end + to - start; i++)
-		MoveItemTo(i, start + i - end);
-
-	// If to < start, we need to move start-to items to newend (= end + to - start), starting from to
-	// This is the same as moving items from start-1 to to (decreasing), with start-1 going to end-1
-	// We have to iterate in this order to avoid writing over something we haven't yet moved
-	for (int i = start - 1; i >= int(to); i--)
-		MoveItemTo(i, i + end - start);
-
-	// Copy the original block back in, starting at to.
-	for (unsigned i = start; i< end; i++)
-	{
-		id_table.Move(tmp[i - start].id, to + i - start);
-		items[to + i - start] = tmp[i-start];
-		items[to + i - start].version = version;
+	assert(start < end);
+	assert(end <= length);
+	assert(to + end - start <= length);
+
+	/* the span of positions which is affected by this move */
+
+	unsigned span_start, span_end;
+	if (to > start) {
+		span_start = start;
+		span_end = to + end - start;
+
+		std::rotate(items + start, items + end, items + span_end);
+		if (random)
+			std::rotate(position_order + start,
+				    position_order + end,
+				    position_order + span_end);
+	} else {
+		span_start = to;
+		span_end = end;
+
+		std::rotate(items + to, items + start, items + end);
+		if (random)
+			std::rotate(position_order + to,
+				    position_order + start,
+				    position_order + end);
 	}
 
-	if (random) {
-		// Update the positions in the queue.
-		// Note that the ranges for these cases are the same as the ranges of
-		// the loops above.
-		for (unsigned i = 0; i < length; i++) {
-			if (order[i] >= end && order[i] < to + end - start)
-				order[i] -= end - start;
-			else if (order[i] < start &&
-				 order[i] >= to)
-				order[i] += end - start;
-			else if (start <= order[i] && order[i] < end)
-				order[i] += to - start;
-		}
+	for (unsigned i = span_start; i < span_end; ++i) {
+		id_table.Move(items[i].id, i);
+		items[i].version = version;
 	}
+
+	changes.Add(version, span_start, span_end);
+
+	/* now deal with order: in random mode, the order numbers
+	   follow the songs; only the positions they refer to in the
+	   affected span need to be updated */
+
+	if (random)
+		UpdateOrder(span_start, span_end);
 }
 
 void
@@ -212,6 +197,11 @@ Queue::MoveOrder(unsigned from_order, unsigned to_order)
 	}
 
 	order[to_order] = from_position;
+
+	if (from_order < to_order)
+		UpdatePositionOrder(from_order, to_order + 1);
+	else
+		UpdatePositionOrder(to_order, from_order + 1);
 }
 
 void
@@ -230,21 +220,70 @@ Queue::DeletePosition(unsigned position)
 
 	id_table.Erase(id);
 
-	/* delete song from songs array */
+	/* delete song from songs array; its order number moves
+	   along */
 
-	for (unsigned i = position; i < length; i++)
+	for (unsigned i = position; i < length; i++) {
 		MoveItemTo(i + 1, i);
 
-	/* delete the entry from the order array */
+		const unsigned o = position_order[i + 1];
+		position_order[i] = o > _order ? o - 1 : o;
+	}
 
-	for (unsigned i = _order; i < length; i++)
-		order[i] = order[i + 1];
+	/* delete the entry from the order array and readjust the
+	   positions following the deleted song; only entries behind
+	   the deleted order number and entries referring to moved
+	   songs need to be touched */
 
-	/* readjust values in the order array */
+	for (unsigned i = _order; i < length; i++) {
+		const unsigned p = order[i + 1];
+		order[i] = p > position ? p - 1 : p;
+	}
+
+	UpdatePositionOrder(_order, length);
+	UpdateOrder(position, length);
 
-	for (unsigned i = 0; i < length; i++)
-		if (order[i] > position)
-			--order[i];
+	changes.Add(version, position, length);
+}
+
+void
+Queue::DeleteRange(unsigned start, unsigned end)
+{
+	assert(start <= end);
+	assert(end <= length);
+
+	const unsigned n = end - start;
+	if (n == 0)
+		return;
+
+	for (unsigned i = start; i < end; i++) {
+		delete items[i].song;
+		id_table.Erase(items[i].id);
+	}
+
+	/* compact the order array in one pass */
+
+	unsigned dest = 0;
+	for (unsigned i = 0; i < length; i++) {
+		const unsigned p = order[i];
+		if (p >= start && p < end)
+			continue;
+
+		order[dest++] = p >= end ? p - n : p;
+	}
+
+	assert(dest == length - n);
+
+	/* compact the songs array */
+
+	for (unsigned i = end; i < length; i++)
+		MoveItemTo(i, i - n);
+
+	length -= n;
+
+	UpdatePositionOrder(0, length);
+
+	changes.Add(version, start, length);
 }
 
 void
@@ -259,6 +298,7 @@ Queue::Clear()
 	}
 
 	length = 0;
+	changes.Reset();
 }
 
 static void
@@ -277,6 +317,9 @@ queue_sort_order_by_priority(Queue *queue, unsigned start, unsigned end)
 	};
 
 	std::stable_sort(queue->order + start, queue->order + end, cmp);
+
+	/* position_order will be updated by ShuffleOrderRange() for
+	   each priority group */
 }
 
 void
@@ -288,6 +331,7 @@ Queue::ShuffleOrderRange(unsigned start, unsigned end)
 
 	rand.AutoCreate();
 	std::shuffle(order + start, order + end, rand);
+	UpdatePositionOrder(start, end);
 }
 
 /**
@@ -414,6 +458,7 @@ Queue::SetPriority(unsigned position, uint8_t priority, int after_order,
 
 	item->version = version;
 	item->priority = priority;
+	changes.Add(version, position, position + 1);
 
 	if (!random || !reorder)
 		/* don't reorder if not in random mode */
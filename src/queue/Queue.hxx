@@ -22,6 +22,7 @@
 
 #include "Compiler.h"
 #include "IdTable.hxx"
+#include "ChangeLog.hxx"
 #include "util/LazyRandomEngine.hxx"
 
 #include <algorithm>
@@ -84,9 +85,19 @@ struct Queue {
 	/** map order numbers to positions */
 	unsigned *order;
 
+	/**
+	 * The inverse of #order: map positions to order numbers.
+	 * This is kept in sync with #order by all methods which
+	 * modify it.
+	 */
+	unsigned *position_order;
+
 	/** map song ids to positions */
 	IdTable id_table;
 
+	/** recently modified position ranges, for "plchanges" */
+	QueueChangeLog changes;
+
 	/** repeat playback when the end of the queue has been
 	    reached? */
 	bool repeat;
@@ -171,13 +182,9 @@ struct Queue {
 	gcc_pure
 	unsigned PositionToOrder(unsigned position) const {
 		assert(position < length);
+		assert(order[position_order[position]] == position);
 
-		for (unsigned i = 0;; ++i) {
-			assert(i < length);
-
-			if (order[i] == position)
-				return i;
-		}
+		return position_order[position];
 	}
 
 	gcc_pure
@@ -225,6 +232,20 @@ struct Queue {
 			items[position].version == 0;
 	}
 
+	/**
+	 * Obtain the position ranges which may contain songs newer
+	 * than the specified version.  Each position still needs to
+	 * be checked with IsNewerAtPosition().
+	 *
+	 * @return false if this is not known; all positions need to
+	 * be checked then
+	 */
+	bool GetChangedRanges(uint32_t _version,
+			      std::vector<QueueChangeLog::Range> &ranges) const {
+		return _version <= version &&
+			changes.GetRanges(_version, ranges);
+	}
+
 	/**
 	 * Returns the order number following the specified one.  This takes
 	 * end of queue and "repeat" mode into account.
@@ -249,6 +270,7 @@ struct Queue {
 		assert(position < length);
 
 		items[position].version = version;
+		changes.Add(version, position, position + 1);
 	}
 
 	/**
@@ -267,8 +289,12 @@ struct Queue {
 	 * queue.
 	 *
 	 * @param priority the priority of this new queue item
+	 * @param id the id which shall be used if it is available
+	 * (e.g. when restoring a saved queue); 0 to generate a new
+	 * one
 	 */
-	unsigned Append(DetachedSong &&song, uint8_t priority);
+	unsigned Append(DetachedSong &&song, uint8_t priority,
+			unsigned id=0);
 
 	/**
 	 * Swaps two songs, addressed by their position.
@@ -280,6 +306,8 @@ struct Queue {
 	 */
 	void SwapOrders(unsigned order1, unsigned order2) {
 		std::swap(order[order1], order[order2]);
+		position_order[order[order1]] = order1;
+		position_order[order[order2]] = order2;
 	}
 
 	/**
@@ -297,6 +325,13 @@ struct Queue {
 	 */
 	void DeletePosition(unsigned position);
 
+	/**
+	 * Removes a range of songs from the playlist.  Unlike calling
+	 * DeletePosition() for each song, this compacts the queue
+	 * only once.
+	 */
+	void DeleteRange(unsigned start, unsigned end);
+
 	/**
 	 * Removes all songs from the playlist.
 	 */
@@ -307,7 +342,21 @@ struct Queue {
 	 */
 	void RestoreOrder() {
 		for (unsigned i = 0; i < length; ++i)
-			order[i] = i;
+			order[i] = position_order[i] = i;
+	}
+
+	/**
+	 * Initializes the "order" array from the given list of
+	 * positions, e.g. when restoring a saved queue in random
+	 * mode.  It must contain each position exactly once.
+	 */
+	void RestoreOrder(const unsigned *positions) {
+		for (unsigned i = 0; i < length; ++i) {
+			assert(positions[i] < length);
+
+			order[i] = positions[i];
+			position_order[positions[i]] = i;
+		}
 	}
 
 	/**
@@ -350,6 +399,25 @@ struct Queue {
 			      uint8_t priority, int after_order);
 
 private:
+	/**
+	 * Update #position_order after the "order" list has been
+	 * modified in the specified range.
+	 */
+	void UpdatePositionOrder(unsigned start_order, unsigned end_order) {
+		for (unsigned i = start_order; i < end_order; ++i)
+			position_order[order[i]] = i;
+	}
+
+	/**
+	 * Update the "order" list after songs have been moved
+	 * (together with their #position_order entries) in the
+	 * specified position range.
+	 */
+	void UpdateOrder(unsigned start_position, unsigned end_position) {
+		for (unsigned i = start_position; i < end_position; ++i)
+			order[position_order[i]] = i;
+	}
+
 	/**
 	 * Moves a song to a new position in the "order" list.
 	 */
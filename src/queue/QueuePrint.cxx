@@ -69,10 +69,15 @@ queue_print_uris(Response &r, Partition &partition, const Queue &queue,
 	}
 }
 
-void
-queue_print_changes_info(Response &r, Partition &partition, const Queue &queue,
-			 uint32_t version,
-			 unsigned start, unsigned end)
+/**
+ * Invoke a function for each song in the specified range which is
+ * newer than the specified version.  If possible, this consults the
+ * queue's change log instead of checking each song.
+ */
+template<typename F>
+static void
+queue_visit_changes(const Queue &queue, uint32_t version,
+		    unsigned start, unsigned end, F &&f)
 {
 	assert(start <= end);
 
@@ -82,9 +87,32 @@ queue_print_changes_info(Response &r, Partition &partition, const Queue &queue,
 	if (end > queue.GetLength())
 		end = queue.GetLength();
 
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			queue_print_song_info(r, partition, queue, i);
+	std::vector<QueueChangeLog::Range> ranges;
+	if (!queue.GetChangedRanges(version, ranges))
+		/* the change log doesn't reach back far enough:
+		   check all songs */
+		ranges.push_back({start, end});
+
+	for (const auto &range : ranges) {
+		const unsigned range_start = std::max(range.start, start);
+		const unsigned range_end = std::min(range.end, end);
+
+		for (unsigned i = range_start; i < range_end; i++)
+			if (queue.IsNewerAtPosition(i, version))
+				f(i);
+	}
+}
+
+void
+queue_print_changes_info(Response &r, Partition &partition, const Queue &queue,
+			 uint32_t version,
+			 unsigned start, unsigned end)
+{
+	queue_visit_changes(queue, version, start, end,
+			    [&r, &partition, &queue](unsigned position){
+				    queue_print_song_info(r, partition, queue,
+							  position);
+			    });
 }
 
 void
@@ -92,18 +120,12 @@ queue_print_changes_position(Response &r, const Queue &queue,
 			     uint32_t version,
 			     unsigned start, unsigned end)
 {
-	assert(start <= end);
-
-	if (start >= queue.GetLength())
-		return;
-
-	if (end > queue.GetLength())
-		end = queue.GetLength();
-
-	for (unsigned i = start; i < end; i++)
-		if (queue.IsNewerAtPosition(i, version))
-			r.Format("cpos: %i\nId: %i\n",
-				 i, queue.PositionToId(i));
+	queue_visit_changes(queue, version, start, end,
+			    [&r, &queue](unsigned position){
+				    r.Format("cpos: %i\nId: %i\n",
+					     position,
+					     queue.PositionToId(position));
+			    });
 }
 
 void
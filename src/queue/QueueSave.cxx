@@ -23,17 +23,127 @@
 #include "PlaylistError.hxx"
 #include "DetachedSong.hxx"
 #include "SongSave.hxx"
+#include "SongLoader.hxx"
 #include "playlist/PlaylistSong.hxx"
+#include "tag/Tag.hxx"
+#include "tag/TagBuilder.hxx"
 #include "fs/io/TextFile.hxx"
+#include "fs/io/FileReader.hxx"
 #include "fs/io/BufferedOutputStream.hxx"
+#include "fs/FileInfo.hxx"
+#include "fs/Traits.hxx"
+#include "util/UriUtil.hxx"
 #include "util/StringCompare.hxx"
 #include "util/Error.hxx"
 #include "Log.hxx"
 
+#ifdef ENABLE_DATABASE
+#include "db/Interface.hxx"
+#include "db/DatabaseSong.hxx"
+#endif
+
+#include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define PRIO_LABEL "Prio: "
 
+/*
+ * Layout of the binary queue file: #BinaryQueueHeader, followed by
+ * the arrays of #BinaryQueueSong, the order (uint32_t positions;
+ * only in random mode), #BinaryQueueDetails and #BinaryQueueItem,
+ * each padded to a multiple of 8 bytes, followed by the string
+ * table.  Strings are referred to by their byte offset in the string
+ * table.
+ *
+ * All numbers are in host byte order; a file written on a machine
+ * with a different byte order is discarded.
+ */
+
+static constexpr char BINARY_QUEUE_MAGIC[8] = {
+	'\x89', 'M', 'P', 'D', 'Q', 'U', '\r', '\n',
+};
+
+static constexpr uint32_t BINARY_QUEUE_FORMAT = 1;
+
+static constexpr uint32_t BINARY_QUEUE_BYTE_ORDER = 0x01020304;
+
+struct BinaryQueueHeader {
+	char magic[sizeof(BINARY_QUEUE_MAGIC)];
+
+	uint32_t format, byte_order;
+
+	uint32_t n_songs, n_order, n_details, n_items;
+
+	uint32_t string_size, reserved;
+};
+
+struct BinaryQueueSong {
+	uint32_t uri, id;
+
+	uint8_t priority;
+
+	/**
+	 * One of the BINARY_QUEUE_SONG_* constants.
+	 */
+	uint8_t type;
+
+	uint16_t reserved;
+};
+
+/**
+ * The song is in the database; only its URI was saved.
+ */
+static constexpr uint8_t BINARY_QUEUE_SONG_DATABASE = 0;
+
+/**
+ * The song has a #BinaryQueueDetails record.
+ */
+static constexpr uint8_t BINARY_QUEUE_SONG_DETAILS = 1;
+
+/**
+ * The attributes of a song which is not (just) a reference to a
+ * database song; see queue_save_full_song().
+ */
+struct BinaryQueueDetails {
+	int64_t mtime;
+	uint32_t start_ms, end_ms;
+
+	/**
+	 * The duration in milliseconds; negative if unknown.
+	 */
+	int32_t duration_ms;
+
+	uint32_t first_item;
+	uint16_t n_items;
+	uint8_t has_playlist;
+	uint8_t reserved[5];
+};
+
+struct BinaryQueueItem {
+	uint32_t value, type;
+};
+
+static_assert(sizeof(BinaryQueueHeader) % 8 == 0, "Wrong header size");
+static_assert(sizeof(BinaryQueueDetails) % 8 == 0, "Wrong record size");
+
+static constexpr uint64_t
+AlignSection(uint64_t size)
+{
+	return (size + 7) & ~uint64_t(7);
+}
+
+/**
+ * Can this song be saved with just its URI?
+ */
+gcc_pure
+static bool
+IsDatabaseSong(const DetachedSong &song)
+{
+	return song.IsInDatabase() &&
+		song.GetStartTime().IsZero() && song.GetEndTime().IsZero();
+}
+
 static void
 queue_save_database_song(BufferedOutputStream &os,
 			 int idx, const DetachedSong &song)
@@ -50,8 +160,7 @@ queue_save_full_song(BufferedOutputStream &os, const DetachedSong &song)
 static void
 queue_save_song(BufferedOutputStream &os, int idx, const DetachedSong &song)
 {
-	if (song.IsInDatabase() &&
-	    song.GetStartTime().IsZero() && song.GetEndTime().IsZero())
+	if (IsDatabaseSong(song))
 		/* use the brief format (just the URI) for "full"
 		   database songs */
 		queue_save_database_song(os, idx, song);
@@ -73,13 +182,127 @@ queue_save(BufferedOutputStream &os, const Queue &queue)
 	}
 }
 
+static uint32_t
+AddString(std::vector<char> &strings, const char *s)
+{
+	const uint32_t offset = strings.size();
+	strings.insert(strings.end(), s, s + strlen(s) + 1);
+	return offset;
+}
+
+template<typename T>
+static void
+WriteSection(BufferedOutputStream &os, const std::vector<T> &v)
+{
+	static constexpr uint8_t padding[8] = {};
+
+	const size_t size = v.size() * sizeof(T);
+	if (size > 0)
+		os.Write(v.data(), size);
+
+	const size_t padded = AlignSection(size);
+	if (padded > size)
+		os.Write(padding, padded - size);
+}
+
+void
+queue_save_binary(BufferedOutputStream &os, const Queue &queue)
+{
+	const unsigned length = queue.GetLength();
+
+	std::vector<BinaryQueueSong> songs;
+	songs.reserve(length);
+
+	std::vector<uint32_t> order;
+	std::vector<BinaryQueueDetails> details;
+	std::vector<BinaryQueueItem> items;
+	std::vector<char> strings;
+
+	for (unsigned i = 0; i < length; ++i) {
+		const DetachedSong &song = queue.Get(i);
+
+		BinaryQueueSong s;
+		memset(&s, 0, sizeof(s));
+		s.uri = AddString(strings, song.GetURI());
+		s.id = queue.PositionToId(i);
+		s.priority = queue.GetPriorityAtPosition(i);
+
+		if (IsDatabaseSong(song))
+			s.type = BINARY_QUEUE_SONG_DATABASE;
+		else {
+			s.type = BINARY_QUEUE_SONG_DETAILS;
+
+			const Tag &tag = song.GetTag();
+
+			BinaryQueueDetails d;
+			memset(&d, 0, sizeof(d));
+			d.mtime = song.GetLastModified();
+			d.start_ms = song.GetStartTime().ToMS();
+			d.end_ms = song.GetEndTime().ToMS();
+			d.duration_ms = tag.duration.IsNegative()
+				? -1
+				: tag.duration.ToMS();
+			d.first_item = items.size();
+			d.n_items = tag.num_items;
+			d.has_playlist = tag.has_playlist;
+			details.push_back(d);
+
+			for (const auto &item : tag)
+				items.push_back({AddString(strings, item.value),
+						 uint32_t(item.type)});
+		}
+
+		songs.push_back(s);
+	}
+
+	if (queue.random)
+		order.assign(queue.order, queue.order + length);
+
+	BinaryQueueHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BINARY_QUEUE_MAGIC, sizeof(header.magic));
+	header.format = BINARY_QUEUE_FORMAT;
+	header.byte_order = BINARY_QUEUE_BYTE_ORDER;
+	header.n_songs = songs.size();
+	header.n_order = order.size();
+	header.n_details = details.size();
+	header.n_items = items.size();
+	header.string_size = strings.size();
+
+	os.Write(&header, sizeof(header));
+	WriteSection(os, songs);
+	WriteSection(os, order);
+	WriteSection(os, details);
+	WriteSection(os, items);
+	WriteSection(os, strings);
+}
+
+QueueLoader::Item::Item(DetachedSong *_song, unsigned _id, uint8_t _priority)
+	:song(_song), id(_id), priority(_priority) {}
+
+QueueLoader::Item::Item(const char *_uri, unsigned _id, uint8_t _priority)
+	:uri(_uri), id(_id), priority(_priority) {}
+
+QueueLoader::QueueLoader(const SongLoader &_loader)
+	:loader(_loader) {}
+
+QueueLoader::~QueueLoader() {}
+
 void
-queue_load_song(TextFile &file, const SongLoader &loader,
-		const char *line, Queue &queue)
+QueueLoader::AddUri(const char *uri, unsigned id, uint8_t priority)
 {
-	if (queue.IsFull())
-		return;
+	if (uri_has_scheme(uri) || PathTraitsUTF8::IsAbsolute(uri))
+		/* not a database song; this can only happen if the
+		   file was edited manually, but let
+		   playlist_check_translate_song() decide */
+		items.emplace_back(new DetachedSong(uri), id, priority);
+	else
+		items.emplace_back(uri, id, priority);
+}
 
+void
+QueueLoader::LoadLine(TextFile &file, const char *line)
+{
 	uint8_t priority = 0;
 	const char *p;
 	if ((p = StringAfterPrefix(line, PRIO_LABEL))) {
@@ -90,17 +313,17 @@ queue_load_song(TextFile &file, const SongLoader &loader,
 			return;
 	}
 
-	DetachedSong *song;
-
 	if ((p = StringAfterPrefix(line, SONG_BEGIN))) {
 		const char *uri = p;
 
 		Error error;
-		song = song_load(file, uri, error);
+		DetachedSong *song = song_load(file, uri, error);
 		if (song == nullptr) {
 			LogError(error);
 			return;
 		}
+
+		items.emplace_back(song, 0, priority);
 	} else {
 		char *endptr;
 		long ret = strtol(line, &endptr, 10);
@@ -110,16 +333,255 @@ queue_load_song(TextFile &file, const SongLoader &loader,
 			return;
 		}
 
-		const char *uri = endptr + 1;
+		AddUri(endptr + 1, 0, priority);
+	}
+}
+
+static bool
+CheckString(uint32_t offset, uint32_t string_size, bool allow_empty,
+	    const char *strings)
+{
+	return offset < string_size &&
+		(allow_empty || strings[offset] != 0);
+}
+
+bool
+QueueLoader::LoadBinary(Path path, Error &error)
+{
+	FileReader reader(path);
+
+	const uint64_t file_size = reader.GetFileInfo().GetSize();
+	if (file_size < sizeof(BinaryQueueHeader) ||
+	    file_size != size_t(file_size)) {
+		error.Set(playlist_domain, "Queue file corrupted");
+		return false;
+	}
+
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[file_size]);
+	for (size_t position = 0; position < file_size;) {
+		size_t nbytes = reader.Read(buffer.get() + position,
+					    file_size - position);
+		if (nbytes == 0) {
+			error.Set(playlist_domain, "Unexpected end of file");
+			return false;
+		}
+
+		position += nbytes;
+	}
+
+	reader.Close();
+
+	const uint8_t *const base = buffer.get();
+	const auto &header = *(const BinaryQueueHeader *)base;
+
+	if (memcmp(header.magic, BINARY_QUEUE_MAGIC,
+		   sizeof(header.magic)) != 0 ||
+	    header.format != BINARY_QUEUE_FORMAT ||
+	    header.byte_order != BINARY_QUEUE_BYTE_ORDER) {
+		error.Set(playlist_domain, "Queue file format mismatch");
+		return false;
+	}
+
+	/* locate the sections and verify that they fit into the
+	   file */
+
+	uint64_t offset = sizeof(header);
+
+	const auto *songs = (const BinaryQueueSong *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_songs) * sizeof(*songs));
+
+	const auto *saved_order = (const uint32_t *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_order) * sizeof(*saved_order));
+
+	const auto *details = (const BinaryQueueDetails *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_details) * sizeof(*details));
+
+	const auto *tag_items = (const BinaryQueueItem *)(base + offset);
+	offset += AlignSection(uint64_t(header.n_items) * sizeof(*tag_items));
+
+	const char *strings = (const char *)(base + offset);
+	offset += header.string_size;
+
+	if (offset > file_size ||
+	    (header.n_order != 0 && header.n_order != header.n_songs) ||
+	    (header.string_size > 0 &&
+	     strings[header.string_size - 1] != 0)) {
+		error.Set(playlist_domain, "Queue file corrupted");
+		return false;
+	}
+
+	/* validate all references before loading anything */
+
+	uint32_t n_details = 0;
+	for (size_t i = 0; i < header.n_songs; ++i) {
+		const auto &s = songs[i];
+		if (!CheckString(s.uri, header.string_size, false, strings) ||
+		    s.type > BINARY_QUEUE_SONG_DETAILS) {
+			error.Set(playlist_domain, "Queue file corrupted");
+			return false;
+		}
+
+		if (s.type == BINARY_QUEUE_SONG_DETAILS)
+			++n_details;
+	}
+
+	if (n_details != header.n_details) {
+		error.Set(playlist_domain, "Queue file corrupted");
+		return false;
+	}
+
+	for (size_t i = 0; i < header.n_details; ++i) {
+		const auto &d = details[i];
+		if (uint64_t(d.first_item) + d.n_items > header.n_items) {
+			error.Set(playlist_domain, "Queue file corrupted");
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < header.n_items; ++i) {
+		if (tag_items[i].type >= TAG_NUM_OF_ITEM_TYPES ||
+		    !CheckString(tag_items[i].value, header.string_size,
+				 true, strings)) {
+			error.Set(playlist_domain, "Queue file corrupted");
+			return false;
+		}
+	}
+
+	if (header.n_order > 0) {
+		/* must contain each position exactly once */
+		std::vector<bool> seen(header.n_order);
+		for (size_t i = 0; i < header.n_order; ++i) {
+			if (saved_order[i] >= header.n_order ||
+			    seen[saved_order[i]]) {
+				error.Set(playlist_domain,
+					  "Queue file corrupted");
+				return false;
+			}
+
+			seen[saved_order[i]] = true;
+		}
+	}
+
+	const size_t base_index = items.size();
+	items.reserve(base_index + header.n_songs);
+
+	const BinaryQueueDetails *d = details;
+	for (size_t i = 0; i < header.n_songs; ++i) {
+		const auto &s = songs[i];
+		const char *uri = strings + s.uri;
+
+		if (s.type == BINARY_QUEUE_SONG_DATABASE) {
+			AddUri(uri, s.id, s.priority);
+			continue;
+		}
+
+		DetachedSong *song = new DetachedSong(uri);
+		song->SetLastModified(d->mtime);
+		song->SetStartTime(SongTime::FromMS(d->start_ms));
+		song->SetEndTime(SongTime::FromMS(d->end_ms));
 
-		song = new DetachedSong(uri);
+		TagBuilder tag;
+		tag.SetDuration(d->duration_ms < 0
+				? SignedSongTime::Negative()
+				: SignedSongTime::FromMS(d->duration_ms));
+		tag.SetHasPlaylist(d->has_playlist);
+
+		for (size_t j = 0; j < d->n_items; ++j) {
+			const auto &item = tag_items[d->first_item + j];
+			tag.AddItem(TagType(item.type), strings + item.value);
+		}
+
+		song->SetTag(tag.Commit());
+		items.emplace_back(song, s.id, s.priority);
+		++d;
 	}
 
-	if (!playlist_check_translate_song(*song, nullptr, loader)) {
-		delete song;
+	order.clear();
+	for (size_t i = 0; i < header.n_order; ++i)
+		order.push_back(base_index + saved_order[i]);
+
+	return true;
+}
+
+void
+QueueLoader::LookupDatabaseSongs()
+{
+#ifdef ENABLE_DATABASE
+	const Database *db = loader.GetDatabase();
+	const Storage *storage = loader.GetStorage();
+	if (db != nullptr && storage != nullptr) {
+		std::vector<const char *> uris;
+		std::vector<size_t> indexes;
+
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (items[i].song == nullptr) {
+				uris.push_back(items[i].uri.c_str());
+				indexes.push_back(i);
+			}
+		}
+
+		db->LookupSongs({uris.data(), uris.size()},
+				[this, storage, &indexes](size_t i,
+							  const LightSong &song){
+					auto &item = items[indexes[i]];
+					item.song.reset(new DetachedSong(DatabaseDetachSong(*storage,
+											    song)));
+				});
 		return;
 	}
+#endif
+
+	/* no database (or no storage): let
+	   playlist_check_translate_song() deal with it */
+	for (auto &item : items) {
+		if (item.song == nullptr) {
+			item.song.reset(new DetachedSong(item.uri));
+			item.uri.clear();
+		}
+	}
+}
+
+void
+QueueLoader::Commit(Queue &queue)
+{
+	assert(queue.IsEmpty());
+
+	LookupDatabaseSongs();
+
+	/* the new position of each item; -1 if it was skipped */
+	std::vector<int> positions(items.size(), -1);
+
+	for (size_t i = 0; i < items.size() && !queue.IsFull(); ++i) {
+		auto &item = items[i];
+
+		if (item.song == nullptr)
+			/* not found in the database */
+			continue;
+
+		if (item.uri.empty() &&
+		    !playlist_check_translate_song(*item.song, nullptr,
+						   loader))
+			continue;
+
+		positions[i] = queue.GetLength();
+		queue.Append(std::move(*item.song), item.priority, item.id);
+	}
+
+	if (!order.empty()) {
+		/* restore the saved order of the songs which were
+		   added */
+		std::vector<unsigned> new_order;
+		new_order.reserve(queue.GetLength());
+		for (unsigned i : order)
+			if (positions[i] >= 0)
+				new_order.push_back(positions[i]);
+
+		assert(new_order.size() == queue.GetLength());
+
+		queue.random = true;
+		queue.RestoreOrder(new_order.data());
+	}
 
-	queue.Append(std::move(*song), priority);
-	delete song;
+	items.clear();
+	order.clear();
 }
@@ -25,19 +25,104 @@
 #ifndef MPD_QUEUE_SAVE_HXX
 #define MPD_QUEUE_SAVE_HXX
 
+#include "check.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
 struct Queue;
 class BufferedOutputStream;
 class TextFile;
 class SongLoader;
+class DetachedSong;
+class Path;
+class Error;
 
 void
 queue_save(BufferedOutputStream &os, const Queue &queue);
 
 /**
- * Loads one song from the state file and appends it to the queue.
+ * Saves the queue in a binary format, which also contains the song
+ * ids and, in random mode, the order.  It is much faster to save and
+ * to load than the text format.
  */
 void
-queue_load_song(TextFile &file, const SongLoader &loader,
-		const char *line, Queue &queue);
+queue_save_binary(BufferedOutputStream &os, const Queue &queue);
+
+/**
+ * Collects the songs loaded from the state file, and appends them
+ * to the queue in Commit().  Songs which were saved with just their
+ * URI are looked up in the database all at once (see
+ * Database::LookupSongs()), which is much faster than looking them
+ * up one by one.
+ */
+class QueueLoader {
+	const SongLoader &loader;
+
+	struct Item {
+		/**
+		 * The song, or nullptr if this is a database song
+		 * which has not been looked up yet.
+		 */
+		std::unique_ptr<DetachedSong> song;
+
+		/**
+		 * The URI of a database song.  If this is empty, then
+		 * #song was loaded from the file and needs to be
+		 * verified with playlist_check_translate_song().
+		 */
+		std::string uri;
+
+		unsigned id;
+
+		uint8_t priority;
+
+		Item(DetachedSong *_song, unsigned _id, uint8_t _priority);
+		Item(const char *_uri, unsigned _id, uint8_t _priority);
+	};
+
+	std::vector<Item> items;
+
+	/**
+	 * The saved order (indexes into #items); empty if none was
+	 * saved.
+	 */
+	std::vector<unsigned> order;
+
+public:
+	explicit QueueLoader(const SongLoader &_loader);
+	~QueueLoader();
+
+	QueueLoader(const QueueLoader &) = delete;
+	QueueLoader &operator=(const QueueLoader &) = delete;
+
+	/**
+	 * Loads one song from the (text) state file.
+	 */
+	void LoadLine(TextFile &file, const char *line);
+
+	/**
+	 * Loads a file which was written by queue_save_binary().
+	 * Throws std::runtime_error if the file cannot be read.
+	 *
+	 * @return false on error (with #Error set)
+	 */
+	bool LoadBinary(Path path, Error &error);
+
+	/**
+	 * Looks up the songs and appends them to the queue, which
+	 * must be empty.  If an order was saved, random mode is
+	 * enabled (#Queue::random) and the order is restored.
+	 */
+	void Commit(Queue &queue);
+
+private:
+	void AddUri(const char *uri, unsigned id, uint8_t priority);
+
+	void LookupDatabaseSongs();
+};
 
 #endif
@@ -23,6 +23,9 @@
 #include "TagBuilder.hxx"
 #include "util/ASCII.hxx"
 
+#include <atomic>
+#include <new>
+
 #include <assert.h>
 #include <string.h>
 
@@ -56,18 +59,94 @@ tag_name_parse_i(const char *name)
 	return TAG_NUM_OF_ITEM_TYPES;
 }
 
+/**
+ * The header of a #Tag::items array, located right before the first
+ * item pointer.
+ */
+struct TagItemsHeader {
+	std::atomic_uint ref;
+};
+
+static constexpr size_t tag_items_header_size =
+	(sizeof(TagItemsHeader) + alignof(TagItem *) - 1) &
+	~(alignof(TagItem *) - 1);
+
+static TagItemsHeader &
+GetItemsHeader(TagItem **items)
+{
+	return *(TagItemsHeader *)((char *)items - tag_items_header_size);
+}
+
+TagItem **
+Tag::AllocateItems(unsigned n)
+{
+	if (n == 0)
+		return nullptr;
+
+	char *p = (char *)operator new(tag_items_header_size +
+				       n * sizeof(TagItem *));
+	new(p) TagItemsHeader{{1}};
+	return (TagItem **)(p + tag_items_header_size);
+}
+
+static void
+FreeItems(TagItem **items)
+{
+	TagItemsHeader &header = GetItemsHeader(items);
+	header.~TagItemsHeader();
+	operator delete(&header);
+}
+
+/**
+ * Release one reference to the #Tag::items array.  If it was the
+ * last one, the array and its #TagItem references are freed.
+ */
+static void
+ReleaseItems(TagItem **items, unsigned n)
+{
+	if (GetItemsHeader(items).ref.fetch_sub(1) != 1)
+		return;
+
+	tag_pool_lock.lock();
+	for (unsigned i = 0; i < n; ++i)
+		tag_pool_put_item(items[i]);
+	tag_pool_lock.unlock();
+
+	FreeItems(items);
+}
+
 void
 Tag::Clear()
 {
 	duration = SignedSongTime::Negative();
 	has_playlist = false;
 
-	tag_pool_lock.lock();
-	for (unsigned i = 0; i < num_items; ++i)
-		tag_pool_put_item(items[i]);
-	tag_pool_lock.unlock();
+	if (items != nullptr)
+		ReleaseItems(items, num_items);
+
+	items = nullptr;
+	num_items = 0;
+}
+
+void
+Tag::DisownItems()
+{
+	if (items != nullptr) {
+		if (GetItemsHeader(items).ref.load() == 1)
+			/* nobody else can obtain a reference while we
+			   own the only one: just free the array and
+			   keep the item references */
+			FreeItems(items);
+		else {
+			tag_pool_lock.lock();
+			for (unsigned i = 0; i < num_items; ++i)
+				tag_pool_dup_item(items[i]);
+			tag_pool_lock.unlock();
+
+			ReleaseItems(items, num_items);
+		}
+	}
 
-	delete[] items;
 	items = nullptr;
 	num_items = 0;
 }
@@ -75,16 +154,13 @@ Tag::Clear()
 Tag::Tag(const Tag &other)
 	:duration(other.duration), has_playlist(other.has_playlist),
 	 num_items(other.num_items),
-	 items(nullptr)
+	 items(other.items)
 {
-	if (num_items > 0) {
-		items = new TagItem *[num_items];
-
-		tag_pool_lock.lock();
-		for (unsigned i = 0; i < num_items; i++)
-			items[i] = tag_pool_dup_item(other.items[i]);
-		tag_pool_lock.unlock();
-	}
+	/* share the item array; this doesn't need to touch the tag
+	   pool */
+	if (items != nullptr)
+		GetItemsHeader(items).ref.fetch_add(1,
+						    std::memory_order_relaxed);
 }
 
 Tag *
@@ -47,7 +47,11 @@ struct Tag {
 	/** the total number of tag items in the #items array */
 	unsigned short num_items;
 
-	/** an array of tag items */
+	/**
+	 * An array of tag items.  It is reference counted and shared
+	 * by all copies of this object, and therefore must not be
+	 * modified after it has been filled; see AllocateItems().
+	 */
 	TagItem **items;
 
 	/**
@@ -110,6 +114,24 @@ struct Tag {
 	 */
 	void Clear();
 
+	/**
+	 * Allocate a new (reference counted) #items array.  The
+	 * caller is responsible for filling it with references to
+	 * #TagItem objects from the tag pool.
+	 *
+	 * @return the new array, or nullptr if n is zero
+	 */
+	static TagItem **AllocateItems(unsigned n);
+
+	/**
+	 * Hand this object's #TagItem references to the caller, which
+	 * must have copied the pointers from the #items array before.
+	 * If the array is shared with other #Tag objects, new
+	 * references are obtained for the caller.  Afterwards, this
+	 * object has no items.
+	 */
+	void DisownItems();
+
 	/**
 	 * Merges the data from two tags.  If both tags share data for the
 	 * same TagType, only data from "add" is used.
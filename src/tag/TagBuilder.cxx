@@ -45,16 +45,15 @@ TagBuilder::TagBuilder(const Tag &other)
 TagBuilder::TagBuilder(Tag &&other)
 	:duration(other.duration), has_playlist(other.has_playlist)
 {
-	/* move all TagItem pointers from the Tag object; we don't
-	   need to contact the tag pool, because all we do is move
+	/* move all TagItem pointers from the Tag object; unless
+	   its array is shared with other Tag objects, we don't need
+	   to contact the tag pool, because all we do is move
 	   references */
 	items.reserve(other.num_items);
 	std::copy_n(other.items, other.num_items, std::back_inserter(items));
 
-	/* discard the pointers from the Tag object */
-	other.num_items = 0;
-	delete[] other.items;
-	other.items = nullptr;
+	/* take over the references from the Tag object */
+	other.DisownItems();
 }
 
 TagBuilder &
@@ -90,17 +89,16 @@ TagBuilder::operator=(Tag &&other)
 	duration = other.duration;
 	has_playlist = other.has_playlist;
 
-	/* move all TagItem pointers from the Tag object; we don't
-	   need to contact the tag pool, because all we do is move
+	/* move all TagItem pointers from the Tag object; unless
+	   its array is shared with other Tag objects, we don't need
+	   to contact the tag pool, because all we do is move
 	   references */
 	items.clear();
 	items.reserve(other.num_items);
 	std::copy_n(other.items, other.num_items, std::back_inserter(items));
 
-	/* discard the pointers from the Tag object */
-	other.num_items = 0;
-	delete[] other.items;
-	other.items = nullptr;
+	/* take over the references from the Tag object */
+	other.DisownItems();
 
 	return *this;
 }
@@ -127,7 +125,7 @@ TagBuilder::Commit(Tag &tag)
 	   object */
 	const unsigned n_items = items.size();
 	tag.num_items = n_items;
-	tag.items = new TagItem *[n_items];
+	tag.items = Tag::AllocateItems(n_items);
 	std::copy_n(items.begin(), n_items, tag.items);
 	items.clear();
 
@@ -24,27 +24,25 @@
 #include "config/ConfigGlobal.hxx"
 #include "config/ConfigOption.hxx"
 #include "system/FatalError.hxx"
-#include "util/Alloc.hxx"
 #include "util/ASCII.hxx"
 #include "util/StringUtil.hxx"
+#include "util/RuntimeError.hxx"
 
-#include <stdlib.h>
+#include <string>
 
-void
-TagLoadConfig()
+tag_mask_t
+ParseTagMask(const char *value)
 {
-	const char *value = config_get_string(ConfigOption::METADATA_TO_USE);
-	if (value == nullptr)
-		return;
-
-	global_tag_mask = 0;
+	tag_mask_t mask = 0;
 
 	if (StringEqualsCaseASCII(value, "none"))
-		return;
+		return mask;
+
+	std::string buffer(value);
 
 	bool quit = false;
-	char *temp, *c, *s;
-	temp = c = s = xstrdup(value);
+	char *c, *s;
+	c = s = &buffer[0];
 	do {
 		if (*s == ',' || *s == '\0') {
 			if (*s == '\0')
@@ -57,10 +55,10 @@ TagLoadConfig()
 
 			const auto type = tag_name_parse_i(c);
 			if (type == TAG_NUM_OF_ITEM_TYPES)
-				FormatFatalError("error parsing metadata item \"%s\"",
-						 c);
+				throw FormatRuntimeError("error parsing metadata item \"%s\"",
+							 c);
 
-			global_tag_mask |= tag_mask_t(1) << unsigned(type);
+			mask |= tag_mask_t(1) << unsigned(type);
 
 			s++;
 			c = s;
@@ -68,5 +66,19 @@ TagLoadConfig()
 		s++;
 	} while (!quit);
 
-	free(temp);
+	return mask;
+}
+
+void
+TagLoadConfig()
+{
+	const char *value = config_get_string(ConfigOption::METADATA_TO_USE);
+	if (value == nullptr)
+		return;
+
+	try {
+		global_tag_mask = ParseTagMask(value);
+	} catch (const std::runtime_error &e) {
+		FatalError(e.what());
+	}
 }
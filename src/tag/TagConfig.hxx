@@ -20,6 +20,16 @@
 #ifndef MPD_TAG_CONFIG_HXX
 #define MPD_TAG_CONFIG_HXX
 
+#include "Mask.hxx"
+
+/**
+ * Parse a comma-separated list of tag names (or "none").
+ *
+ * Throws std::runtime_error on error.
+ */
+tag_mask_t
+ParseTagMask(const char *value);
+
 void
 TagLoadConfig();
 
@@ -36,6 +36,13 @@ static constexpr size_t NUM_SLOTS = 4093;
 
 struct TagPoolSlot {
 	TagPoolSlot *next;
+
+	/**
+	 * The sort key of the value, allocated with new[]; nullptr
+	 * if it has not been set yet.  See tag_pool_get_sort_key().
+	 */
+	char *sort_key;
+
 	unsigned char ref;
 	TagItem item;
 
@@ -43,7 +50,7 @@ struct TagPoolSlot {
 
 	TagPoolSlot(TagPoolSlot *_next, TagType type,
 		    StringView value)
-		:next(_next), ref(1) {
+		:next(_next), sort_key(nullptr), ref(1) {
 		item.type = type;
 		memcpy(item.value, value.data, value.size);
 		item.value[value.size] = 0;
@@ -167,5 +174,34 @@ tag_pool_put_item(TagItem *item)
 	}
 
 	*slot_p = slot->next;
+	delete[] slot->sort_key;
 	DeleteVarSize(slot);
 }
+
+const char *
+tag_pool_get_sort_key(const TagItem &item)
+{
+	return tag_item_to_slot(const_cast<TagItem *>(&item))->sort_key;
+}
+
+const char *
+tag_pool_set_sort_key(const TagItem &item, char *sort_key)
+{
+	TagPoolSlot *slot = tag_item_to_slot(const_cast<TagItem *>(&item));
+	assert(slot->ref > 0);
+	assert(slot->sort_key == nullptr);
+
+	slot->sort_key = sort_key;
+	return sort_key;
+}
+
+void
+tag_pool_find_items(TagType type, const char *value,
+		    std::vector<const TagItem *> &dest)
+{
+	for (auto slot = *tag_value_slot_p(type, value);
+	     slot != nullptr; slot = slot->next)
+		if (slot->item.type == type &&
+		    strcmp(slot->item.value, value) == 0)
+			dest.push_back(&slot->item);
+}
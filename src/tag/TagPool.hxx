@@ -22,6 +22,9 @@
 
 #include "TagType.h"
 #include "thread/Mutex.hxx"
+#include "Compiler.h"
+
+#include <vector>
 
 extern Mutex tag_pool_lock;
 
@@ -37,4 +40,40 @@ tag_pool_dup_item(TagItem *item);
 void
 tag_pool_put_item(TagItem *item);
 
+/**
+ * Look up all items with the given type and value, without obtaining
+ * a reference.  There may be more than one, because a new item is
+ * allocated each time the reference counter of an existing one
+ * overflows.
+ *
+ * Caller must lock #tag_pool_lock.
+ */
+void
+tag_pool_find_items(TagType type, const char *value,
+		    std::vector<const TagItem *> &dest);
+
+/**
+ * Returns the sort key which was attached to the item with
+ * tag_pool_set_sort_key(), or nullptr if there is none.
+ *
+ * Caller must lock #tag_pool_lock.
+ */
+gcc_pure
+const char *
+tag_pool_get_sort_key(const TagItem &item);
+
+/**
+ * Attach a sort key (e.g. from IcuSortKey()) to the item, which will
+ * be freed together with the item.  This caches the sort key for all
+ * songs sharing this value.
+ *
+ * Caller must lock #tag_pool_lock.
+ *
+ * @param sort_key a string allocated with new[]; this function takes
+ * ownership
+ * @return the sort_key parameter
+ */
+const char *
+tag_pool_set_sort_key(const TagItem &item, char *sort_key);
+
 #endif
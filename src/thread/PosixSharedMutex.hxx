@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2009-2015 Max Kellermann <max@duempel.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * - Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the
+ * distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THREAD_POSIX_SHARED_MUTEX_HXX
+#define THREAD_POSIX_SHARED_MUTEX_HXX
+
+#include <pthread.h>
+
+/**
+ * Low-level wrapper for a pthread_rwlock_t.
+ */
+class PosixSharedMutex {
+	pthread_rwlock_t rwlock;
+
+public:
+#ifdef __GLIBC__
+	/* optimized constexpr constructor for pthread implementations
+	   that support it; prefer writers, or else a steady stream of
+	   readers could starve them */
+	constexpr PosixSharedMutex()
+		:rwlock(PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP) {}
+#else
+	/* slow fallback for pthread implementations that are not
+	   compatible with "constexpr" */
+	PosixSharedMutex() {
+		pthread_rwlock_init(&rwlock, nullptr);
+	}
+
+	~PosixSharedMutex() {
+		pthread_rwlock_destroy(&rwlock);
+	}
+#endif
+
+	PosixSharedMutex(const PosixSharedMutex &other) = delete;
+	PosixSharedMutex &operator=(const PosixSharedMutex &other) = delete;
+
+	void lock() {
+		pthread_rwlock_wrlock(&rwlock);
+	}
+
+	bool try_lock() {
+		return pthread_rwlock_trywrlock(&rwlock) == 0;
+	}
+
+	void unlock() {
+		pthread_rwlock_unlock(&rwlock);
+	}
+
+	void lock_shared() {
+		pthread_rwlock_rdlock(&rwlock);
+	}
+
+	bool try_lock_shared() {
+		return pthread_rwlock_tryrdlock(&rwlock) == 0;
+	}
+
+	void unlock_shared() {
+		pthread_rwlock_unlock(&rwlock);
+	}
+};
+
+#endif
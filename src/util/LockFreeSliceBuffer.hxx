@@ -0,0 +1,233 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef MPD_LOCK_FREE_SLICE_BUFFER_HXX
+#define MPD_LOCK_FREE_SLICE_BUFFER_HXX
+
+#include "HugeAllocator.hxx"
+#include "Compiler.h"
+
+#include <atomic>
+#include <utility>
+#include <new>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A variant of #SliceBuffer which may be used by multiple threads
+ * without a mutex.  The list of available slices is a lock-free
+ * stack; each stack head carries a modification counter to avoid
+ * the ABA problem.
+ *
+ * Unlike #SliceBuffer, memory is never given back to the kernel
+ * while the object exists, because that cannot be done safely
+ * without a lock.
+ */
+template<typename T>
+class LockFreeSliceBuffer {
+	/**
+	 * The lower 32 bits of a stack head value: the index of the
+	 * first available slice plus one, or 0 if the stack is
+	 * empty.  The upper 32 bits are the modification counter.
+	 */
+	static constexpr uint64_t INDEX_MASK = 0xffffffff;
+
+	/**
+	 * The maximum number of slices in this container.
+	 */
+	const unsigned n_max;
+
+	/**
+	 * The number of slices that are initialized.  This is used to
+	 * avoid page faulting on the new allocation, so the kernel
+	 * does not need to reserve physical memory pages.
+	 */
+	std::atomic_uint n_initialized;
+
+	/**
+	 * The number of slices currently allocated.
+	 */
+	std::atomic_uint n_allocated;
+
+	/**
+	 * The number of times a compare-and-swap failed because
+	 * another thread modified the stack concurrently.
+	 */
+	std::atomic_ulong n_retries;
+
+	T *const data;
+
+	/**
+	 * For each slice: the stack head value below it (index plus
+	 * one, or 0).  Only meaningful while the slice is available.
+	 */
+	std::atomic_uint *const links;
+
+	/**
+	 * The stack of available slices.
+	 */
+	std::atomic<uint64_t> available;
+
+	size_t CalcAllocationSize() const {
+		return n_max * sizeof(T);
+	}
+
+public:
+	LockFreeSliceBuffer(unsigned _count)
+		:n_max(_count), n_initialized(0), n_allocated(0),
+		 n_retries(0),
+		 data((T *)HugeAllocate(CalcAllocationSize())),
+		 links(new std::atomic_uint[n_max]),
+		 available(0) {
+		assert(n_max > 0);
+	}
+
+	~LockFreeSliceBuffer() {
+		/* all slices must be freed explicitly, and this
+		   assertion checks for leaks */
+		assert(n_allocated == 0);
+
+		delete[] links;
+		HugeFree(data, CalcAllocationSize());
+	}
+
+	LockFreeSliceBuffer(const LockFreeSliceBuffer &other) = delete;
+	LockFreeSliceBuffer &operator=(const LockFreeSliceBuffer &other) = delete;
+
+	unsigned GetCapacity() const {
+		return n_max;
+	}
+
+	bool IsEmpty() const {
+		return n_allocated.load(std::memory_order_relaxed) == 0;
+	}
+
+	/**
+	 * Returns the position of an allocated object within this
+	 * buffer, in the range 0 to GetCapacity()-1.
+	 */
+	gcc_pure
+	unsigned IndexOf(const T *value) const {
+		assert(value >= data && value < data + n_max);
+
+		return value - data;
+	}
+
+	/**
+	 * Returns the number of compare-and-swap retries so far.
+	 */
+	unsigned long GetRetries() const {
+		return n_retries.load(std::memory_order_relaxed);
+	}
+
+	template<typename... Args>
+	T *Allocate(Args&&... args) {
+		T *value = Pop();
+		if (value == nullptr)
+			value = Initialize();
+		if (value == nullptr)
+			/* out of (internal) memory, buffer is full */
+			return nullptr;
+
+		n_allocated.fetch_add(1, std::memory_order_relaxed);
+
+		/* construct the object */
+		return ::new((void *)value) T(std::forward<Args>(args)...);
+	}
+
+	void Free(T *value) {
+		assert(n_allocated > 0);
+		assert(value >= data && value < data + n_max);
+
+		/* destruct the object */
+		value->~T();
+
+		n_allocated.fetch_sub(1, std::memory_order_relaxed);
+
+		const unsigned i = value - data;
+		uint64_t head = available.load(std::memory_order_relaxed);
+		uint64_t new_head;
+		do {
+			links[i].store(unsigned(head & INDEX_MASK),
+				       std::memory_order_relaxed);
+			new_head = NextCounter(head) | (i + 1);
+		} while (!CompareExchange(head, new_head,
+					  std::memory_order_release));
+	}
+
+private:
+	static constexpr uint64_t NextCounter(uint64_t head) {
+		return ((head >> 32) + 1) << 32;
+	}
+
+	bool CompareExchange(uint64_t &expected, uint64_t desired,
+			     std::memory_order order) {
+		if (available.compare_exchange_weak(expected, desired, order,
+						    std::memory_order_acquire))
+			return true;
+
+		n_retries.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	/**
+	 * Remove the first slice from the stack of available slices.
+	 *
+	 * @return the slice or nullptr if the stack is empty
+	 */
+	T *Pop() {
+		uint64_t head = available.load(std::memory_order_acquire);
+		while (true) {
+			const unsigned i = unsigned(head & INDEX_MASK);
+			if (i == 0)
+				return nullptr;
+
+			/* if another thread pops this slice before we
+			   do, the value loaded here may be stale, but
+			   then the counter has changed and the
+			   following compare-and-swap fails */
+			const unsigned next =
+				links[i - 1].load(std::memory_order_relaxed);
+			if (CompareExchange(head, NextCounter(head) | next,
+					    std::memory_order_acq_rel))
+				return &data[i - 1];
+		}
+	}
+
+	/**
+	 * Obtain a slice which has never been used before.
+	 *
+	 * @return the slice or nullptr if all slices have been
+	 * initialized already
+	 */
+	T *Initialize() {
+		unsigned n = n_initialized.load(std::memory_order_relaxed);
+		do {
+			if (n >= n_max)
+				return nullptr;
+		} while (!n_initialized.compare_exchange_weak(n, n + 1,
+							      std::memory_order_relaxed));
+
+		return &data[n];
+	}
+};
+
+#endif
@@ -100,6 +100,18 @@ public:
 		return n_allocated == n_max;
 	}
 
+	/**
+	 * Returns the position of an allocated object within this
+	 * buffer, in the range 0 to GetCapacity()-1.
+	 */
+	gcc_pure
+	unsigned IndexOf(const T *value) const {
+		const Slice *slice = reinterpret_cast<const Slice *>(value);
+		assert(slice >= data && slice < data + n_max);
+
+		return slice - data;
+	}
+
 	template<typename... Args>
 	T *Allocate(Args&&... args) {
 		assert(n_initialized <= n_max);
@@ -0,0 +1,519 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * This program measures the throughput of MPD's PCM library and
+ * filter plugins.
+ *
+ * Each result is printed on one line with four tab-separated
+ * columns: the stage, the benchmark name, the input audio format
+ * and the number of input samples (not frames) per second.  Lines
+ * starting with '#' are comments.
+ *
+ */
+
+#include "config.h"
+#include "config/ConfigGlobal.hxx"
+#include "config/Block.hxx"
+#include "pcm/PcmConvert.hxx"
+#include "pcm/PcmFormat.hxx"
+#include "pcm/PcmPack.hxx"
+#include "pcm/PcmExport.hxx"
+#include "pcm/PcmBuffer.hxx"
+#include "pcm/PcmDither.hxx"
+#include "pcm/PcmMix.hxx"
+#include "pcm/Volume.hxx"
+#include "pcm/Simd.hxx"
+#include "filter/FilterPlugin.hxx"
+#include "filter/FilterRegistry.hxx"
+#include "filter/FilterInternal.hxx"
+#include "filter/plugins/VolumeFilterPlugin.hxx"
+#include "filter/plugins/ReplayGainFilterPlugin.hxx"
+#include "system/Clock.hxx"
+#include "util/ConstBuffer.hxx"
+#include "util/Error.hxx"
+#include "AudioFormat.hxx"
+#include "Log.hxx"
+
+#include <memory>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+bool
+mixer_set_volume(gcc_unused Mixer *mixer,
+		 gcc_unused unsigned volume, gcc_unused Error &error)
+{
+	return true;
+}
+
+/**
+ * The number of frames per call; this is roughly what one
+ * #MusicChunk contains.
+ */
+static constexpr size_t N = 1024;
+
+static unsigned iterations = 2000;
+
+/**
+ * The stages selected on the command line; empty means all.
+ */
+static std::vector<const char *> selected_stages;
+
+/**
+ * Prevent the compiler from discarding a result.
+ */
+static volatile uint8_t sink;
+
+static void
+Consume(ConstBuffer<void> b)
+{
+	if (!b.IsEmpty())
+		sink = ((const uint8_t *)b.data)[b.size - 1];
+}
+
+static bool
+IsSelected(const char *stage)
+{
+	if (selected_stages.empty())
+		return true;
+
+	for (const char *i : selected_stages)
+		if (strcmp(i, stage) == 0)
+			return true;
+
+	return false;
+}
+
+static void
+Report(const char *stage, const char *name, AudioFormat af,
+       uint64_t duration_us)
+{
+	const double samples = double(N) * af.channels * iterations;
+	if (duration_us == 0)
+		duration_us = 1;
+
+	struct audio_format_string af_string;
+	printf("%s\t%s\t%s\t%.0f\n", stage, name,
+	       audio_format_to_string(af, &af_string),
+	       samples * 1000000 / duration_us);
+	fflush(stdout);
+}
+
+/**
+ * Call the function #iterations times and report the throughput.
+ */
+template<typename F>
+static void
+Run(const char *stage, const char *name, AudioFormat af, F &&f)
+{
+	/* warm up caches and buffers */
+	f();
+
+	const uint64_t start = MonotonicClockUS();
+	for (unsigned i = 0; i < iterations; ++i)
+		f();
+	Report(stage, name, af, MonotonicClockUS() - start);
+}
+
+/**
+ * Generate #N frames of random samples in the given format.
+ */
+static std::vector<uint8_t>
+Generate(AudioFormat af)
+{
+	const size_t n_samples = N * af.channels;
+	std::vector<uint8_t> v(N * af.GetFrameSize());
+	for (auto &i : v)
+		i = rand();
+
+	switch (af.format) {
+	case SampleFormat::S24_P32:
+		for (size_t i = 0; i < n_samples; ++i) {
+			int32_t &s = ((int32_t *)v.data())[i];
+			s = (s << 8) >> 8;
+		}
+		break;
+
+	case SampleFormat::FLOAT:
+		for (size_t i = 0; i < n_samples; ++i)
+			((float *)v.data())[i] = rand() / (RAND_MAX / 2.f) - 1.f;
+		break;
+
+	default:
+		break;
+	}
+
+	return v;
+}
+
+static ConstBuffer<void>
+ToBuffer(const std::vector<uint8_t> &v)
+{
+	return { v.data(), v.size() };
+}
+
+static constexpr SampleFormat pcm_formats[] = {
+	SampleFormat::S8,
+	SampleFormat::S16,
+	SampleFormat::S24_P32,
+	SampleFormat::S32,
+	SampleFormat::FLOAT,
+};
+
+static void
+BenchFormat()
+{
+	static constexpr char stage[] = "format";
+
+	for (const auto format : pcm_formats) {
+		const AudioFormat af(44100, format, 2);
+		const auto src = Generate(af);
+		const auto s = ToBuffer(src);
+
+		PcmBuffer buffer;
+		PcmDither dither;
+
+		if (format != SampleFormat::S16)
+			Run(stage, "to_16", af, [&](){
+					Consume(pcm_convert_to_16(buffer, dither,
+								  format, s).ToVoid());
+				});
+
+		if (format != SampleFormat::S24_P32)
+			Run(stage, "to_24", af, [&](){
+					Consume(pcm_convert_to_24(buffer, format,
+								  s).ToVoid());
+				});
+
+		if (format != SampleFormat::S32)
+			Run(stage, "to_32", af, [&](){
+					Consume(pcm_convert_to_32(buffer, format,
+								  s).ToVoid());
+				});
+
+		if (format != SampleFormat::FLOAT)
+			Run(stage, "to_float", af, [&](){
+					Consume(pcm_convert_to_float(buffer, format,
+								     s).ToVoid());
+				});
+	}
+}
+
+static void
+BenchPack()
+{
+	static constexpr char stage[] = "pack";
+
+	const AudioFormat af(44100, SampleFormat::S24_P32, 2);
+	const auto src = Generate(af);
+	const auto packed = Generate(AudioFormat(44100, SampleFormat::S8, 6));
+	const size_t n = N * af.channels;
+	std::vector<uint8_t> packed_dest(n * 3);
+	std::vector<int32_t> unpacked_dest(n);
+
+	Run(stage, "pack_24", af, [&](){
+			const int32_t *s = (const int32_t *)src.data();
+			pcm_pack_24(packed_dest.data(), s, s + n);
+			sink = packed_dest.back();
+		});
+
+	Run(stage, "unpack_24", af, [&](){
+			pcm_unpack_24(unpacked_dest.data(),
+				      packed.data(), packed.data() + n * 3);
+			sink = unpacked_dest.back();
+		});
+}
+
+static void
+BenchExport(const char *name, AudioFormat af, PcmExport::Params params)
+{
+	const auto src = Generate(af);
+
+	PcmExport e;
+	e.Open(af.format, af.channels, params);
+
+	Run("export", name, af, [&](){
+			Consume(e.Export(ToBuffer(src)));
+		});
+}
+
+static void
+BenchExport()
+{
+	PcmExport::Params params;
+	params.alsa_channel_order = true;
+	BenchExport("alsa_channel_order",
+		    AudioFormat(44100, SampleFormat::S16, 6), params);
+
+	params = PcmExport::Params();
+	params.shift8 = true;
+	BenchExport("shift8", AudioFormat(44100, SampleFormat::S24_P32, 2),
+		    params);
+
+	params = PcmExport::Params();
+	params.pack24 = true;
+	BenchExport("pack24", AudioFormat(44100, SampleFormat::S24_P32, 2),
+		    params);
+
+	params.reverse_endian = true;
+	BenchExport("pack24_reverse_endian",
+		    AudioFormat(44100, SampleFormat::S24_P32, 2), params);
+
+	params = PcmExport::Params();
+	params.reverse_endian = true;
+	BenchExport("reverse_endian", AudioFormat(44100, SampleFormat::S16, 2),
+		    params);
+	BenchExport("reverse_endian", AudioFormat(44100, SampleFormat::S32, 2),
+		    params);
+
+#ifdef ENABLE_DSD
+	params = PcmExport::Params();
+	params.dop = true;
+	BenchExport("dop", AudioFormat(352800, SampleFormat::DSD, 2), params);
+
+	params = PcmExport::Params();
+	params.dsd_u32 = true;
+	BenchExport("dsd_u32", AudioFormat(352800, SampleFormat::DSD, 2),
+		    params);
+#endif
+}
+
+static void
+BenchConvert(const char *name, AudioFormat in, AudioFormat out)
+{
+	const auto src = Generate(in);
+
+	PcmConvert convert;
+	Error error;
+	if (!convert.Open(in, out, error)) {
+		printf("# %s: %s\n", name, error.GetMessage());
+		return;
+	}
+
+	Run("convert", name, in, [&](){
+			Consume(convert.Convert(ToBuffer(src), error));
+		});
+
+	convert.Close();
+}
+
+static void
+BenchConvert()
+{
+	for (const auto format : pcm_formats) {
+		/* PcmConvert does not implement conversion to S8 and
+		   channel conversion of S8 */
+
+		for (const auto dest : pcm_formats)
+			if (dest != format && dest != SampleFormat::S8)
+				BenchConvert(sample_format_to_string(dest),
+					     AudioFormat(44100, format, 2),
+					     AudioFormat(44100, dest, 2));
+
+		if (format == SampleFormat::S8)
+			continue;
+
+		BenchConvert("channels_1", AudioFormat(44100, format, 2),
+			     AudioFormat(44100, format, 1));
+		BenchConvert("channels_2", AudioFormat(44100, format, 1),
+			     AudioFormat(44100, format, 2));
+		BenchConvert("channels_2", AudioFormat(44100, format, 6),
+			     AudioFormat(44100, format, 2));
+	}
+
+	BenchConvert("resample_48000", AudioFormat(44100, SampleFormat::S16, 2),
+		     AudioFormat(48000, SampleFormat::S16, 2));
+	BenchConvert("resample_48000",
+		     AudioFormat(44100, SampleFormat::FLOAT, 2),
+		     AudioFormat(48000, SampleFormat::FLOAT, 2));
+	BenchConvert("resample_44100",
+		     AudioFormat(96000, SampleFormat::S24_P32, 2),
+		     AudioFormat(44100, SampleFormat::S24_P32, 2));
+
+#ifdef ENABLE_DSD
+	BenchConvert("dsd_to_float", AudioFormat(352800, SampleFormat::DSD, 2),
+		     AudioFormat(352800, SampleFormat::FLOAT, 2));
+	BenchConvert("dsd_to_float", AudioFormat(352800, SampleFormat::DSD, 6),
+		     AudioFormat(352800, SampleFormat::FLOAT, 6));
+	BenchConvert("dsd_to_176400", AudioFormat(352800, SampleFormat::DSD, 2),
+		     AudioFormat(176400, SampleFormat::FLOAT, 2));
+	BenchConvert("dsd_to_88200", AudioFormat(352800, SampleFormat::DSD, 2),
+		     AudioFormat(88200, SampleFormat::FLOAT, 2));
+#endif
+}
+
+static void
+BenchVolume()
+{
+	for (const auto format : pcm_formats) {
+		const AudioFormat af(44100, format, 2);
+		const auto src = Generate(af);
+
+		PcmVolume pv;
+		if (!pv.Open(format, IgnoreError()))
+			continue;
+
+		pv.SetVolume(PCM_VOLUME_1 / 2);
+
+		Run("volume", "50%", af, [&](){
+				Consume(pv.Apply(ToBuffer(src)));
+			});
+
+		pv.Close();
+	}
+}
+
+static void
+BenchMix()
+{
+	for (const auto format : pcm_formats) {
+		const AudioFormat af(44100, format, 2);
+		const auto src1 = Generate(af);
+		const auto src2 = Generate(af);
+		auto dest = src1;
+
+		PcmDither dither;
+
+		Run("mix", "crossfade", af, [&](){
+				pcm_mix(dither, dest.data(), src2.data(),
+					dest.size(), format, 0.3);
+				sink = dest.back();
+			});
+
+		dest = src1;
+		Run("mix", "add", af, [&](){
+				pcm_mix(dither, dest.data(), src2.data(),
+					dest.size(), format, -1);
+				sink = dest.back();
+			});
+	}
+}
+
+static void
+BenchFilter(const filter_plugin &plugin, AudioFormat af)
+{
+	ConfigBlock block;
+	block.AddBlockParam("name", plugin.name);
+
+	Error error;
+	std::unique_ptr<PreparedFilter> prepared(filter_new(&plugin, block,
+							    error));
+	if (!prepared) {
+		printf("# %s: %s\n", plugin.name, error.GetMessage());
+		return;
+	}
+
+	AudioFormat in = af;
+	std::unique_ptr<Filter> filter(prepared->Open(in, error));
+	if (!filter || in != af)
+		/* this audio format is not supported */
+		return;
+
+	/* make sure the filter has some work to do */
+	if (strcmp(plugin.name, "volume") == 0)
+		volume_filter_set(filter.get(), PCM_VOLUME_1 / 2);
+	else if (strcmp(plugin.name, "replay_gain") == 0) {
+		ReplayGainInfo info;
+		info.Clear();
+		info.tuples[REPLAY_GAIN_TRACK].gain = -6;
+		info.tuples[REPLAY_GAIN_TRACK].peak = 0.5;
+		replay_gain_filter_set_info(filter.get(), &info);
+		replay_gain_filter_set_mode(filter.get(), REPLAY_GAIN_TRACK);
+	}
+
+	const auto src = Generate(af);
+	Run("filter", plugin.name, af, [&](){
+			Consume(filter->FilterPCM(ToBuffer(src), error));
+		});
+}
+
+static void
+BenchFilter()
+{
+	for (unsigned i = 0; filter_plugins[i] != nullptr; ++i)
+		for (const auto format : pcm_formats)
+			for (const unsigned channels : {2, 6})
+				BenchFilter(*filter_plugins[i],
+					    AudioFormat(44100, format, channels));
+}
+
+static constexpr struct {
+	const char *name;
+	void (*function)();
+} stages[] = {
+	{ "format", BenchFormat },
+	{ "pack", BenchPack },
+	{ "export", BenchExport },
+	{ "convert", BenchConvert },
+	{ "volume", BenchVolume },
+	{ "mix", BenchMix },
+	{ "filter", BenchFilter },
+};
+
+int
+main(int argc, char **argv)
+try {
+	int option;
+	while ((option = getopt(argc, argv, "n:")) != -1) {
+		switch (option) {
+		case 'n':
+			iterations = strtoul(optarg, nullptr, 10);
+			if (iterations == 0) {
+				fprintf(stderr, "Invalid iteration count\n");
+				return EXIT_FAILURE;
+			}
+			break;
+
+		default:
+			fprintf(stderr,
+				"Usage: bench_pcm [-n ITERATIONS] [STAGE...]\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (int i = optind; i < argc; ++i)
+		selected_stages.push_back(argv[i]);
+
+	config_global_init();
+
+	Error error;
+	if (!pcm_convert_global_init(error)) {
+		LogError(error);
+		return EXIT_FAILURE;
+	}
+
+	printf("# simd=%s frames=%u iterations=%u\n",
+	       pcm_simd_name(pcm_simd_detect()), unsigned(N), iterations);
+	printf("# stage\tname\tformat\tsamples_per_second\n");
+
+	for (const auto &stage : stages)
+		if (IsSelected(stage.name))
+			stage.function();
+
+	config_global_finish();
+	return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+	LogError(e);
+	return EXIT_FAILURE;
+}
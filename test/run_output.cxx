@@ -32,6 +32,7 @@
 #include "pcm/PcmConvert.hxx"
 #include "filter/FilterRegistry.hxx"
 #include "player/Control.hxx"
+#include "MusicChunk.hxx"
 #include "util/Error.hxx"
 #include "Log.hxx"
 
@@ -51,10 +52,16 @@ filter_plugin_by_name(gcc_unused const char *name)
 PlayerControl::PlayerControl(PlayerListener &_listener,
 			     MultipleOutputs &_outputs,
 			     unsigned _buffer_chunks,
-			     unsigned _buffered_before_play)
+			     size_t _chunk_size,
+			     unsigned _buffered_before_play,
+			     bool _adaptive_buffering,
+			     bool _lock_free_pipe)
 	:listener(_listener), outputs(_outputs),
 	 buffer_chunks(_buffer_chunks),
-	 buffered_before_play(_buffered_before_play) {}
+	 chunk_size(_chunk_size),
+	 buffered_before_play(_buffered_before_play),
+	 adaptive_buffering(_adaptive_buffering),
+	 lock_free_pipe(_lock_free_pipe) {}
 PlayerControl::~PlayerControl() {}
 
 static AudioOutput *
@@ -69,7 +76,8 @@ load_audio_output(EventLoop &event_loop, const char *name)
 
 	static struct PlayerControl dummy_player_control(*(PlayerListener *)nullptr,
 							 *(MultipleOutputs *)nullptr,
-							 32, 4);
+							 32, CHUNK_SIZE, 4,
+							 false, false);
 
 	Error error;
 	AudioOutput *ao =
@@ -79,6 +79,7 @@ class PcmFormatTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(TestFormat16to24);
 	CPPUNIT_TEST(TestFormat16to32);
 	CPPUNIT_TEST(TestFormatFloat);
+	CPPUNIT_TEST(TestFormatFloatToInteger);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -86,6 +87,7 @@ public:
 	void TestFormat16to24();
 	void TestFormat16to32();
 	void TestFormatFloat();
+	void TestFormatFloatToInteger();
 };
 
 class PcmMixTest : public CppUnit::TestFixture {
@@ -94,6 +96,11 @@ class PcmMixTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(TestMix16);
 	CPPUNIT_TEST(TestMix24);
 	CPPUNIT_TEST(TestMix32);
+	CPPUNIT_TEST(TestMixFloat);
+	CPPUNIT_TEST(TestAddVolFloat);
+	CPPUNIT_TEST(TestAdd16);
+	CPPUNIT_TEST(TestAdd24);
+	CPPUNIT_TEST(TestAdd32);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -101,6 +108,11 @@ public:
 	void TestMix16();
 	void TestMix24();
 	void TestMix32();
+	void TestMixFloat();
+	void TestAddVolFloat();
+	void TestAdd16();
+	void TestAdd24();
+	void TestAdd32();
 };
 
 class PcmInterleaveTest : public CppUnit::TestFixture {
@@ -125,6 +137,7 @@ class PcmExportTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST(TestShift8);
 	CPPUNIT_TEST(TestPack24);
 	CPPUNIT_TEST(TestReverseEndian);
+	CPPUNIT_TEST(TestReverseEndianLarge);
 #ifdef ENABLE_DSD
 	CPPUNIT_TEST(TestDsdU32);
 	CPPUNIT_TEST(TestDop);
@@ -136,6 +149,7 @@ public:
 	void TestShift8();
 	void TestPack24();
 	void TestReverseEndian();
+	void TestReverseEndianLarge();
 #ifdef ENABLE_DSD
 	void TestDsdU32();
 	void TestDop();
@@ -143,4 +157,21 @@ public:
 	void TestAlsaChannelOrder();
 };
 
+#ifdef ENABLE_DSD
+class PcmDsdTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(PcmDsdTest);
+	CPPUNIT_TEST(TestReference);
+	CPPUNIT_TEST(TestDecimation);
+	CPPUNIT_TEST(TestDecimationChunks);
+	CPPUNIT_TEST(TestChooseDecimation);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void TestReference();
+	void TestDecimation();
+	void TestDecimationChunks();
+	void TestChooseDecimation();
+};
+#endif
+
 #endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2003-2016 The Music Player Daemon Project
+ * http://www.musicpd.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+#include "test_pcm_all.hxx"
+#include "test_pcm_util.hxx"
+#include "pcm/PcmDsd.hxx"
+#include "pcm/dsd2pcm/dsd2pcm.h"
+#include "util/ConstBuffer.hxx"
+
+#include <algorithm>
+#include <vector>
+
+#include <math.h>
+
+void
+PcmDsdTest::TestReference()
+{
+	constexpr unsigned channels = 3;
+	constexpr size_t n_frames = 1500;
+
+	const auto src = TestDataBuffer<uint8_t, n_frames * channels>();
+
+	float expected[n_frames * channels];
+	for (unsigned c = 0; c < channels; ++c) {
+		auto *ctx = dsd2pcm_init();
+		dsd2pcm_translate(ctx, n_frames, src.begin() + c, channels,
+				  false, expected + c, channels);
+		dsd2pcm_destroy(ctx);
+	}
+
+	PcmDsd dsd;
+	dsd.Open(channels);
+
+	/* convert in odd chunks to verify that the state is
+	   preserved */
+	static constexpr size_t chunks[] = { 1, 511, 3, 985 };
+	const float *e = expected;
+	const uint8_t *s = src.begin();
+	for (size_t chunk : chunks) {
+		const size_t size = chunk * channels;
+		const auto result = dsd.ToFloat({s, size});
+		CPPUNIT_ASSERT_EQUAL(size, result.size);
+
+		for (size_t i = 0; i < size; ++i)
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(e[i], result.data[i],
+						     1e-5);
+
+		s += size;
+		e += size;
+	}
+}
+
+void
+PcmDsdTest::TestDecimation()
+{
+	/* constant input is a DC signal, which must pass all
+	   decimation stages unmodified */
+	constexpr unsigned channels = 2;
+	constexpr size_t n_frames = 4096;
+	uint8_t src[n_frames * channels];
+	std::fill_n(src, n_frames * channels, 0xfc);
+
+	PcmDsd reference;
+	reference.Open(channels);
+	const auto r = reference.ToFloat({src, n_frames * channels});
+	const float dc = r.data[r.size - 1];
+
+	for (unsigned shift = 1; shift <= PcmDsd::MAX_DECIMATION_SHIFT;
+	     ++shift) {
+		PcmDsd dsd;
+		dsd.Open(channels, shift);
+
+		const auto result = dsd.ToFloat({src, n_frames * channels});
+		CPPUNIT_ASSERT_EQUAL((n_frames >> shift) * channels,
+				     result.size);
+
+		/* skip the filter delay of all stages */
+		for (size_t i = result.size / 2; i < result.size; ++i)
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(dc, result.data[i],
+						     1e-4);
+	}
+}
+
+void
+PcmDsdTest::TestDecimationChunks()
+{
+	constexpr unsigned channels = 2;
+	constexpr size_t n_frames = 1024;
+	constexpr unsigned shift = 2;
+
+	const auto src = TestDataBuffer<uint8_t, n_frames * channels>();
+
+	PcmDsd dsd;
+	dsd.Open(channels, shift);
+	const auto r = dsd.ToFloat({src.begin(), n_frames * channels});
+	const std::vector<float> expected(r.begin(), r.end());
+	CPPUNIT_ASSERT_EQUAL((n_frames >> shift) * channels, expected.size());
+
+	/* odd chunk sizes must not disturb the phase of the
+	   decimation stages */
+	dsd.Reset();
+	std::vector<float> result;
+	static constexpr size_t chunks[] = { 3, 1, 517, 503 };
+	const uint8_t *s = src.begin();
+	for (size_t chunk : chunks) {
+		const auto d = dsd.ToFloat({s, chunk * channels});
+		result.insert(result.end(), d.begin(), d.end());
+		s += chunk * channels;
+	}
+
+	CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+	for (size_t i = 0; i < result.size(); ++i)
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i], result[i], 1e-6);
+}
+
+void
+PcmDsdTest::TestChooseDecimation()
+{
+	CPPUNIT_ASSERT_EQUAL(0u, PcmDsd::ChooseDecimation(352800, 352800));
+	CPPUNIT_ASSERT_EQUAL(1u, PcmDsd::ChooseDecimation(352800, 176400));
+	CPPUNIT_ASSERT_EQUAL(2u, PcmDsd::ChooseDecimation(352800, 88200));
+	CPPUNIT_ASSERT_EQUAL(1u, PcmDsd::ChooseDecimation(352800, 48000));
+	CPPUNIT_ASSERT_EQUAL(2u, PcmDsd::ChooseDecimation(352800, 44100));
+	CPPUNIT_ASSERT_EQUAL(4u, PcmDsd::ChooseDecimation(2822400, 176400));
+	CPPUNIT_ASSERT_EQUAL(4u, PcmDsd::ChooseDecimation(2822400, 44100));
+}
@@ -19,11 +19,14 @@
 
 #include "config.h"
 #include "test_pcm_all.hxx"
+#include "test_pcm_util.hxx"
 #include "pcm/PcmExport.hxx"
 #include "pcm/Traits.hxx"
 #include "system/ByteOrder.hxx"
 #include "util/ConstBuffer.hxx"
 
+#include <vector>
+
 #include <string.h>
 
 void
@@ -115,6 +118,49 @@ PcmExportTest::TestReverseEndian()
 	CPPUNIT_ASSERT(memcmp(dest.data, expected4, dest.size) == 0);
 }
 
+/**
+ * Check the byte order reversal with a buffer which is large enough
+ * for the vectorized code.
+ */
+static void
+CheckReverseEndian(SampleFormat format, bool pack24,
+		       size_t frame_size)
+{
+	/* 509 32 bit samples, an odd number which can be packed to
+	   24 bit */
+	constexpr size_t N = 509 * 4;
+	const auto src = TestDataBuffer<uint8_t, N>();
+
+	PcmExport::Params params;
+	params.pack24 = pack24;
+
+	PcmExport e;
+	e.Open(format, 1, params);
+	const auto expected = e.Export({src, sizeof(src)});
+	const std::vector<uint8_t> reversed((const uint8_t *)expected.data,
+					    (const uint8_t *)expected.data
+					    + expected.size);
+
+	params.reverse_endian = true;
+	e.Open(format, 1, params);
+	const auto dest =
+		ConstBuffer<uint8_t>::FromVoid(e.Export({src, sizeof(src)}));
+	CPPUNIT_ASSERT_EQUAL(reversed.size(), dest.size);
+
+	for (size_t i = 0; i < dest.size; i += frame_size)
+		for (size_t j = 0; j < frame_size; ++j)
+			CPPUNIT_ASSERT_EQUAL(reversed[i + j],
+					     dest[i + frame_size - 1 - j]);
+}
+
+void
+PcmExportTest::TestReverseEndianLarge()
+{
+	CheckReverseEndian(SampleFormat::S16, false, 2);
+	CheckReverseEndian(SampleFormat::S24_P32, true, 3);
+	CheckReverseEndian(SampleFormat::S32, false, 4);
+}
+
 #ifdef ENABLE_DSD
 
 void
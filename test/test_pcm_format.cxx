@@ -24,6 +24,7 @@
 #include "pcm/PcmDither.hxx"
 #include "pcm/PcmUtils.hxx"
 #include "pcm/PcmBuffer.hxx"
+#include "pcm/FloatConvert.hxx"
 #include "AudioFormat.hxx"
 
 void
@@ -118,3 +119,33 @@ PcmFormatTest::TestFormatFloat()
 	for (size_t i = 4; i < N; ++i)
 		CPPUNIT_ASSERT_EQUAL(src[i], d[i]);
 }
+
+template<SampleFormat F, class Traits=SampleTraits<F>>
+static void
+TestFromFloat(ConstBuffer<typename Traits::value_type> (*f)(PcmBuffer &,
+							   SampleFormat,
+							   ConstBuffer<void>))
+{
+	constexpr size_t N = 509;
+
+	/* include values which need to be clamped */
+	const auto src = TestDataBuffer<float, N>([](){
+			static RandomFloat r;
+			return r() * 1.5f;
+		});
+
+	PcmBuffer buffer;
+	auto d = f(buffer, SampleFormat::FLOAT, src);
+	CPPUNIT_ASSERT_EQUAL(N, d.size);
+
+	typedef FloatToIntegerSampleConvert<F, Traits> C;
+	for (size_t i = 0; i < N; ++i)
+		CPPUNIT_ASSERT_EQUAL(C::Convert(src[i]), d[i]);
+}
+
+void
+PcmFormatTest::TestFormatFloatToInteger()
+{
+	TestFromFloat<SampleFormat::S24_P32>(pcm_convert_to_24);
+	TestFromFloat<SampleFormat::S32>(pcm_convert_to_32);
+}
@@ -17,6 +17,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include "config.h"
 #include "test_pcm_all.hxx"
 #include "Compiler.h"
 
@@ -33,6 +34,9 @@ CPPUNIT_TEST_SUITE_REGISTRATION(PcmFormatTest);
 CPPUNIT_TEST_SUITE_REGISTRATION(PcmMixTest);
 CPPUNIT_TEST_SUITE_REGISTRATION(PcmInterleaveTest);
 CPPUNIT_TEST_SUITE_REGISTRATION(PcmExportTest);
+#ifdef ENABLE_DSD
+CPPUNIT_TEST_SUITE_REGISTRATION(PcmDsdTest);
+#endif
 
 int
 main(gcc_unused int argc, gcc_unused char **argv)
@@ -22,6 +22,9 @@
 #include "test_pcm_util.hxx"
 #include "pcm/PcmMix.hxx"
 #include "pcm/PcmDither.hxx"
+#include "pcm/PcmUtils.hxx"
+#include "pcm/Traits.hxx"
+#include "pcm/Simd.hxx"
 
 template<typename T, SampleFormat format, typename G=RandomInt<T>>
 static void
@@ -61,6 +64,37 @@ TestPcmMix(G g=G())
 	AssertEqualWithTolerance(result, expected, 3);
 }
 
+template<SampleFormat F, class Traits=SampleTraits<F>,
+	 typename G=RandomInt<typename Traits::value_type>>
+static void
+TestPcmAdd(G g=G())
+{
+	typedef typename Traits::value_type value_type;
+
+	/* an odd number of samples, to test the portable code after
+	   the vectorized blocks */
+	constexpr unsigned N = 509;
+	const auto src1 = TestDataBuffer<value_type, N>(g);
+	const auto src2 = TestDataBuffer<value_type, N>(g);
+
+	PcmDither dither;
+
+	/* portion1=-1 (MixRamp): saturating addition, which must be
+	   exact */
+	auto result = src1;
+	bool success = pcm_mix(dither,
+			       result.begin(), src2.begin(), sizeof(result),
+			       F, -1);
+	CPPUNIT_ASSERT(success);
+
+	for (unsigned i = 0; i < N; ++i) {
+		typename Traits::sum_type sum(src1[i]);
+		sum += src2[i];
+		const value_type expected = PcmClamp<F, Traits>(sum);
+		CPPUNIT_ASSERT_EQUAL(expected, result[i]);
+	}
+}
+
 void
 PcmMixTest::TestMix8()
 {
@@ -84,3 +118,92 @@ PcmMixTest::TestMix32()
 {
 	TestPcmMix<int32_t, SampleFormat::S32>();
 }
+
+void
+PcmMixTest::TestMixFloat()
+{
+	constexpr unsigned N = 509;
+	const auto src1 = TestDataBuffer<float, N>(RandomFloat());
+	const auto src2 = TestDataBuffer<float, N>(RandomFloat());
+
+	PcmDither dither;
+
+	auto result = src1;
+	bool success = pcm_mix(dither,
+			       result.begin(), src2.begin(), sizeof(result),
+			       SampleFormat::FLOAT, 0.5);
+	CPPUNIT_ASSERT(success);
+
+	for (unsigned i = 0; i < N; ++i)
+		CPPUNIT_ASSERT_DOUBLES_EQUAL((src1[i] + src2[i]) / 2,
+					     result[i], 0.001);
+
+	result = src1;
+	success = pcm_mix(dither,
+			  result.begin(), src2.begin(), sizeof(result),
+			  SampleFormat::FLOAT, -1);
+	CPPUNIT_ASSERT(success);
+
+	for (unsigned i = 0; i < N; ++i)
+		CPPUNIT_ASSERT_EQUAL(src1[i] + src2[i], result[i]);
+}
+
+void
+PcmMixTest::TestAddVolFloat()
+{
+	constexpr unsigned N = 509;
+	const auto src1 = TestDataBuffer<float, N>(RandomFloat());
+	const auto src2 = TestDataBuffer<float, N>(RandomFloat());
+	constexpr float volume1 = 0.3f, volume2 = 0.7f;
+
+	/* the vectorized kernel must be bit-exact with the portable
+	   code */
+	auto result = src1;
+	const size_t done = pcm_simd_add_vol_float(result.begin(),
+						   src2.begin(), N,
+						   volume1, volume2);
+	CPPUNIT_ASSERT(done <= N);
+
+	for (unsigned i = 0; i < done; ++i) {
+		const float expected = src1[i] * volume1 + src2[i] * volume2;
+		CPPUNIT_ASSERT_EQUAL(expected, result[i]);
+	}
+
+	/* the remaining samples must not be touched */
+	for (unsigned i = done; i < N; ++i)
+		CPPUNIT_ASSERT_EQUAL(src1[i], result[i]);
+
+	/* pcm_mix() must give the same result with the kernel and
+	   with the portable code (a buffer smaller than one vector) */
+	PcmDither dither;
+	result = src1;
+	CPPUNIT_ASSERT(pcm_mix(dither,
+			       result.begin(), src2.begin(), sizeof(result),
+			       SampleFormat::FLOAT, 0.3));
+
+	for (unsigned i = 0; i < N; ++i) {
+		float sample = src1[i];
+		CPPUNIT_ASSERT(pcm_mix(dither, &sample, &src2[i],
+				       sizeof(sample),
+				       SampleFormat::FLOAT, 0.3));
+		CPPUNIT_ASSERT_EQUAL(sample, result[i]);
+	}
+}
+
+void
+PcmMixTest::TestAdd16()
+{
+	TestPcmAdd<SampleFormat::S16>();
+}
+
+void
+PcmMixTest::TestAdd24()
+{
+	TestPcmAdd<SampleFormat::S24_P32>(RandomInt24());
+}
+
+void
+PcmMixTest::TestAdd32()
+{
+	TestPcmAdd<SampleFormat::S32>();
+}
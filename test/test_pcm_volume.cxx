@@ -21,7 +21,9 @@
 #include "test_pcm_all.hxx"
 #include "pcm/Volume.hxx"
 #include "pcm/Traits.hxx"
+#include "pcm/Simd.hxx"
 #include "util/ConstBuffer.hxx"
+#include "util/WritableBuffer.hxx"
 #include "util/Error.hxx"
 #include "test_pcm_util.hxx"
 
@@ -65,6 +67,20 @@ TestVolume(G g=G())
 		CPPUNIT_ASSERT(_dest[i] <= expected + 4);
 	}
 
+	/* the in-place variant must produce the same result */
+	PcmVolume pv2;
+	CPPUNIT_ASSERT(pv2.Open(F, IgnoreError()));
+	pv2.SetVolume(PCM_VOLUME_1 / 2);
+
+	value_type copy[N];
+	std::copy(_src.begin(), _src.end(), copy);
+	const auto result =
+		pv2.ApplyInPlace(WritableBuffer<void>(copy, sizeof(copy)));
+	CPPUNIT_ASSERT_EQUAL((void *)copy, result.data);
+	CPPUNIT_ASSERT_EQUAL(dest.size, result.size);
+	CPPUNIT_ASSERT_EQUAL(0, memcmp(dest.data, copy, sizeof(copy)));
+
+	pv2.Close();
 	pv.Close();
 }
 
@@ -121,5 +137,22 @@ PcmVolumeTest::TestVolumeFloat()
 	for (unsigned i = 0; i < N; ++i)
 		CPPUNIT_ASSERT_DOUBLES_EQUAL(_src[i] / 2, _dest[i], 1);
 
+	/* the vectorized kernel and the portable code must be
+	   bit-exact */
+	const float volume = pcm_volume_to_float(PCM_VOLUME_1 / 3);
+	float simd[N];
+	const size_t done = pcm_simd_volume_float(simd, _src.begin(), N,
+						  volume);
+	CPPUNIT_ASSERT(done <= N);
+	for (unsigned i = 0; i < done; ++i)
+		CPPUNIT_ASSERT_EQUAL(_src[i] * volume, simd[i]);
+
+	pv.SetVolume(PCM_VOLUME_1 / 3);
+	dest = pv.Apply(src);
+	CPPUNIT_ASSERT_EQUAL(src.size, dest.size);
+	const auto _dest2 = ConstBuffer<float>::FromVoid(dest);
+	for (unsigned i = 0; i < N; ++i)
+		CPPUNIT_ASSERT_EQUAL(_src[i] * volume, _dest2[i]);
+
 	pv.Close();
 }
@@ -8,6 +8,12 @@
 #include <cppunit/ui/text/TestRunner.h>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <stdio.h>
+
 Tag::Tag(const Tag &) {}
 void Tag::Clear() {}
 
@@ -27,13 +33,58 @@ check_descending_priority(const Queue *queue,
 	}
 }
 
+/**
+ * Verify that the queue matches the reference lists of song ids in
+ * "position" and in "order" order, and that the order mapping is
+ * consistent in both directions.
+ */
+static void
+check_queue(const Queue &queue,
+	    const std::vector<unsigned> &positions,
+	    const std::vector<unsigned> &orders)
+{
+	CPPUNIT_ASSERT_EQUAL(unsigned(positions.size()), queue.GetLength());
+	CPPUNIT_ASSERT_EQUAL(unsigned(orders.size()), queue.GetLength());
+
+	for (unsigned i = 0; i < queue.GetLength(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(positions[i],
+				     unsigned(queue.PositionToId(i)));
+		CPPUNIT_ASSERT_EQUAL(int(i),
+				     queue.IdToPosition(positions[i]));
+
+		const unsigned position = queue.OrderToPosition(i);
+		CPPUNIT_ASSERT_EQUAL(orders[i],
+				     unsigned(queue.PositionToId(position)));
+		CPPUNIT_ASSERT_EQUAL(i, queue.PositionToOrder(position));
+	}
+}
+
+/**
+ * Read the current "order" list from the queue (after an operation
+ * with a random outcome).
+ */
+static std::vector<unsigned>
+get_orders(const Queue &queue)
+{
+	std::vector<unsigned> orders;
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		orders.push_back(queue.PositionToId(queue.OrderToPosition(i)));
+	return orders;
+}
+
 class QueuePriorityTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE(QueuePriorityTest);
 	CPPUNIT_TEST(TestPriority);
+	CPPUNIT_TEST(TestLargeQueue);
+	CPPUNIT_TEST(TestChanges);
+	CPPUNIT_TEST(TestRestore);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
 	void TestPriority();
+	void TestLargeQueue();
+	void TestChanges();
+	void TestRestore();
 };
 
 void
@@ -193,6 +244,318 @@ QueuePriorityTest::TestPriority()
 	CPPUNIT_ASSERT_EQUAL(6u, a_order);
 }
 
+void
+QueuePriorityTest::TestLargeQueue()
+{
+	static constexpr unsigned N = 4096;
+
+	Queue queue(N);
+	std::vector<unsigned> positions, orders;
+
+	for (unsigned i = 0; i < N; ++i) {
+		char uri[32];
+		snprintf(uri, sizeof(uri), "%u.ogg", i);
+		positions.push_back(queue.Append(DetachedSong(uri), 0));
+	}
+
+	orders = positions;
+	check_queue(queue, positions, orders);
+
+	queue.random = true;
+	queue.SetPriorityRange(N / 4, N / 2, 10, -1);
+	queue.ShuffleOrder();
+	check_descending_priority(&queue, 0);
+	orders = get_orders(queue);
+	check_queue(queue, positions, orders);
+
+	std::mt19937 engine(42);
+	auto random = [&engine](unsigned n){
+		return std::uniform_int_distribution<unsigned>(0, n - 1)(engine);
+	};
+
+	for (unsigned i = 0; i < 256; ++i) {
+		const unsigned length = queue.GetLength();
+
+		switch (i % 6) {
+		case 0: {
+			/* move one song; in random mode, the order
+			   follows the song */
+			const unsigned from = random(length);
+			const unsigned to = random(length);
+			queue.MovePostion(from, to);
+
+			const unsigned id = positions[from];
+			positions.erase(positions.begin() + from);
+			positions.insert(positions.begin() + to, id);
+			break;
+		}
+
+		case 1: {
+			/* move a range */
+			const unsigned start = random(length);
+			const unsigned end = start + 1 +
+				random(std::min(length - start, 64u));
+			const unsigned to = random(length - (end - start) + 1);
+			queue.MoveRange(start, end, to);
+
+			std::vector<unsigned> block(positions.begin() + start,
+						    positions.begin() + end);
+			positions.erase(positions.begin() + start,
+					positions.begin() + end);
+			positions.insert(positions.begin() + to,
+					 block.begin(), block.end());
+			break;
+		}
+
+		case 2: {
+			/* delete one song */
+			const unsigned position = random(length);
+			const unsigned id = positions[position];
+			queue.DeletePosition(position);
+
+			positions.erase(positions.begin() + position);
+			orders.erase(std::find(orders.begin(), orders.end(),
+					       id));
+			break;
+		}
+
+		case 3: {
+			/* delete a range */
+			const unsigned start = random(length);
+			const unsigned end = start +
+				random(std::min(length - start, 16u) + 1);
+			queue.DeleteRange(start, end);
+
+			for (unsigned j = start; j < end; ++j)
+				orders.erase(std::find(orders.begin(),
+						       orders.end(),
+						       positions[j]));
+			positions.erase(positions.begin() + start,
+					positions.begin() + end);
+			break;
+		}
+
+		case 4: {
+			/* swap two order numbers */
+			const unsigned a = random(length);
+			const unsigned b = random(length);
+			queue.SwapOrders(a, b);
+
+			std::swap(orders[a], orders[b]);
+			break;
+		}
+
+		case 5: {
+			/* change a priority; this reorders the queue */
+			const unsigned position = random(length);
+			queue.SetPriority(position, random(256), -1);
+
+			orders = get_orders(queue);
+			break;
+		}
+		}
+
+		check_queue(queue, positions, orders);
+	}
+
+	/* back to "normal" order */
+
+	queue.random = false;
+	queue.RestoreOrder();
+	check_queue(queue, positions, positions);
+
+	/* moves and deletes keep the identity mapping */
+
+	queue.MoveRange(10, 20, 100);
+	std::rotate(positions.begin() + 10, positions.begin() + 20,
+		    positions.begin() + 110);
+	queue.DeletePosition(5);
+	positions.erase(positions.begin() + 5);
+	queue.DeleteRange(50, 60);
+	positions.erase(positions.begin() + 50, positions.begin() + 60);
+	check_queue(queue, positions, positions);
+}
+
+/**
+ * Determine the positions which have changed since the specified
+ * version, using the change log if possible.
+ */
+static std::vector<unsigned>
+get_changes(const Queue &queue, uint32_t version, bool &from_log)
+{
+	std::vector<QueueChangeLog::Range> ranges;
+	from_log = queue.GetChangedRanges(version, ranges);
+	if (!from_log)
+		ranges.push_back({0, queue.GetLength()});
+
+	std::vector<unsigned> result;
+	for (const auto &range : ranges)
+		for (unsigned i = range.start;
+		     i < std::min(range.end, queue.GetLength()); ++i)
+			if (queue.IsNewerAtPosition(i, version))
+				result.push_back(i);
+
+	return result;
+}
+
+/**
+ * Determine the positions which have changed since the specified
+ * version by checking all songs.
+ */
+static std::vector<unsigned>
+get_changes_full(const Queue &queue, uint32_t version)
+{
+	std::vector<unsigned> result;
+	for (unsigned i = 0; i < queue.GetLength(); ++i)
+		if (queue.IsNewerAtPosition(i, version))
+			result.push_back(i);
+	return result;
+}
+
+void
+QueuePriorityTest::TestChanges()
+{
+	static constexpr unsigned N = 2048;
+
+	Queue queue(N);
+	queue.random = true;
+
+	const uint32_t initial_version = queue.version;
+
+	for (unsigned i = 0; i < N / 2; ++i) {
+		char uri[32];
+		snprintf(uri, sizeof(uri), "%u.ogg", i);
+		queue.Append(DetachedSong(uri), 0);
+	}
+
+	queue.IncrementVersion();
+
+	/* all appends have been merged into one log entry */
+
+	bool from_log;
+	CPPUNIT_ASSERT_EQUAL(N / 2,
+			     unsigned(get_changes(queue, initial_version,
+						  from_log).size()));
+	CPPUNIT_ASSERT(from_log);
+
+	std::mt19937 engine(42);
+	auto random = [&engine](unsigned n){
+		return std::uniform_int_distribution<unsigned>(0, n - 1)(engine);
+	};
+
+	for (unsigned i = 0; i < 4096; ++i) {
+		const unsigned length = queue.GetLength();
+
+		switch (random(8)) {
+		case 0:
+			queue.MovePostion(random(length), random(length));
+			break;
+
+		case 1:
+			queue.DeletePosition(random(length));
+			break;
+
+		case 2: {
+			const unsigned start = random(length);
+			queue.DeleteRange(start, start +
+					  random(std::min(length - start, 8u) + 1));
+			break;
+		}
+
+		case 3:
+			queue.SwapPositions(random(length), random(length));
+			break;
+
+		case 4:
+			queue.SetPriority(random(length), random(256), -1);
+			break;
+
+		case 5:
+			queue.ModifyAtPosition(random(length));
+			break;
+
+		default:
+			if (!queue.IsFull())
+				queue.Append(DetachedSong("x.ogg"), 0);
+			break;
+		}
+
+		if (queue.GetLength() < 16)
+			queue.Append(DetachedSong("y.ogg"), 0);
+
+		if (random(4) == 0)
+			queue.IncrementVersion();
+
+		/* compare with a full scan, for a few past versions */
+
+		for (unsigned j = 0; j < 4; ++j) {
+			const uint32_t version = j == 0
+				? initial_version
+				: queue.version - random(std::min(queue.version, 64u));
+
+			const auto changes = get_changes(queue, version,
+							 from_log);
+			CPPUNIT_ASSERT(changes == get_changes_full(queue, version));
+		}
+	}
+
+	/* many modifications which can't be merged truncate the log */
+
+	queue.IncrementVersion();
+	const uint32_t old_version = queue.version;
+
+	for (unsigned i = 0; i < 4096; ++i) {
+		queue.ModifyAtPosition((i % 2) * 2);
+		queue.IncrementVersion();
+	}
+
+	get_changes(queue, old_version, from_log);
+	CPPUNIT_ASSERT(!from_log);
+
+	/* recent changes are still answered from the log */
+
+	queue.IncrementVersion();
+	queue.ModifyAtPosition(3);
+	const auto changes = get_changes(queue, queue.version, from_log);
+	CPPUNIT_ASSERT(from_log);
+	CPPUNIT_ASSERT_EQUAL(1u, unsigned(changes.size()));
+	CPPUNIT_ASSERT_EQUAL(3u, changes.front());
+
+	/* after clearing the queue, the log is complete again */
+
+	queue.Clear();
+	get_changes(queue, initial_version, from_log);
+	CPPUNIT_ASSERT(from_log);
+}
+
+void
+QueuePriorityTest::TestRestore()
+{
+	Queue queue(32);
+
+	/* saved ids are reused if available */
+
+	CPPUNIT_ASSERT_EQUAL(7u, queue.Append(DetachedSong("a.ogg"), 0, 7));
+	CPPUNIT_ASSERT_EQUAL(3u, queue.Append(DetachedSong("b.ogg"), 0, 3));
+	CPPUNIT_ASSERT_EQUAL(20u, queue.Append(DetachedSong("c.ogg"), 0, 20));
+
+	/* duplicate and invalid ids are replaced, and new ids are
+	   generated after the highest restored one */
+
+	CPPUNIT_ASSERT_EQUAL(21u, queue.Append(DetachedSong("d.ogg"), 0, 3));
+	CPPUNIT_ASSERT_EQUAL(22u, queue.Append(DetachedSong("e.ogg"), 0, 1000));
+	CPPUNIT_ASSERT_EQUAL(23u, queue.Append(DetachedSong("f.ogg"), 0));
+
+	/* restore a random order */
+
+	static constexpr unsigned saved_order[] = { 4, 0, 5, 2, 1, 3 };
+	queue.random = true;
+	queue.RestoreOrder(saved_order);
+
+	check_queue(queue, {7, 3, 20, 21, 22, 23},
+		    {22, 7, 23, 20, 3, 21});
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(QueuePriorityTest);
 
 int